@@ -9,7 +9,7 @@
  * @note 关于`AXI UART 16550`芯片介绍: https://wenku.baidu.com/view/6f7a176048d7c1c708a14521.html?_wkts_=1681021571718
  * @note 关于`AXI UART 16550`相关常量, 参考`AXI UART 16550`编程手册(`Programming Table`): http://byterunner.com/16550.html
  * 
- * @warning 目前使用轮询方式使用`UART`设备, 没有实现中断方式
+ * @warning `uart.c`中的函数以轮询方式使用`UART`设备, 内核中以中断方式发送字符的功能由`kernel/kconsole.c`实现
  * 
  * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
  */
@@ -51,6 +51,26 @@ void uart_puts(const char* str){
         uart_put((char) str[i]);
 }
 
+size_t uart_fifo_write(const char *buf, size_t len){
+    // FIFO非空时直接返回, 不等待
+    if ((read_8_bits(UART_LSR) & UART_LSR_THE) == 0)
+        return 0;
+    // FIFO为空时可以一次写入UART_FIFO_SIZE个字节
+    size_t count = len < UART_FIFO_SIZE ? len : UART_FIFO_SIZE;
+    for (size_t i = 0; i < count; i++)
+        write_8_bits(UART_THR, buf[i]);
+    return count;
+}
+
+void uart_set_interrupt(uint8_t mask, Bool enable){
+    uint8_t ier = read_8_bits(UART_IER);
+    write_8_bits(UART_IER, enable ? (ier | mask) : (ier & ~mask));
+}
+
+uint8_t uart_interrupt_status(void){
+    return read_8_bits(UART_ISR) & UART_ISR_ID_MASK;
+}
+
 char uart_get(void){
     if (read_8_bits(UART_LSR) & UART_LSR_RDR)
         return read_8_bits(UART_DAT);
@@ -58,14 +78,10 @@ char uart_get(void){
         return -1;
 }
 
-// TODO: 添加一个字符缓冲区
-void uart_interrupt_handler(void){
-    char c = uart_get();
-    if (c < 0)
-        return;
-    else if (c == '\r') {
-        uart_puts("Enter an enter!\n");
-    }
-    // 屏幕上回显, 然后返回
-    uart_put(c);
-}
\ No newline at end of file
+size_t uart_rx_drain(char *buf, size_t max){
+    size_t count = 0;
+    // 读空接收缓冲区(FIFO)
+    while (count < max && (read_8_bits(UART_LSR) & UART_LSR_RDR))
+        buf[count++] = read_8_bits(UART_RHR);
+    return count;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file aia.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `aia.h`定义了`RISC-V`高级中断架构(Advanced Interrupt Architecture, AIA)的`APLIC`和`IMSIC`的相关常量和函数
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @note `AIA`中外部设备的中断线连接到`APLIC`, `APLIC`工作在`MSI`模式下时, 将中断转换为向目标`HART`的`IMSIC`中断文件的一次内存写入(MSI).
+ *      每个`HART`的每个模式都有一个中断文件, 中断文件中的中断号(External Interrupt Identity, EIID)由软件分配.
+ *      `HART`通过`CSR`直接读取并认领中断文件中优先级最高的中断, 不需要像`PLIC`那样读写`MMIO`寄存器
+ * 
+ * @note `APLIC`分为多个中断域, M模式的根中断域可以将中断源委托给S模式的子中断域. 根中断域由`SBI`初始化, 子中断域由内核初始化
+ * @note 该文件中的值参考`The RISC-V Advanced Interrupt Architecture`手册`1.0`版本
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_ASM_AIA_H
+#define __INCLUDE_ASM_AIA_H
+
+#include "types.h"
+
+
+/* ----- APLIC寄存器偏移 ----- */
+#define APLIC_DOMAINCFG                 0x0000
+#define APLIC_SOURCECFG_BASE            0x0004
+#define APLIC_MMSIADDRCFG               0x1BC0
+#define APLIC_MMSIADDRCFGH              0x1BC4
+#define APLIC_SMSIADDRCFG               0x1BC8
+#define APLIC_SMSIADDRCFGH              0x1BCC
+#define APLIC_SETIENUM                  0x1EDC
+#define APLIC_CLRIENUM                  0x1FDC
+#define APLIC_SETIPNUM                  0x1CDC
+#define APLIC_IN_CLRIP_BASE             0x1D00
+#define APLIC_TARGET_BASE               0x3004
+
+/* ----- domaincfg寄存器 ----- */
+/// 中断域使能
+#define APLIC_DOMAINCFG_IE              (1U << 8)
+/// 中断以MSI的方式发送
+#define APLIC_DOMAINCFG_DM              (1U << 2)
+
+/* ----- sourcecfg寄存器 ----- */
+/// 将中断源委托给子中断域, 低10位为子中断域的下标
+#define APLIC_SOURCECFG_D               (1U << 10)
+/// 中断源未启用
+#define APLIC_SOURCECFG_SM_INACTIVE     0
+/// 中断源高电平触发
+#define APLIC_SOURCECFG_SM_LEVEL_HIGH   6
+
+/* ----- target寄存器 ----- */
+/// `MSI`模式下目标`HART`的下标
+#define APLIC_TARGET_HART_SHIFT         18
+/// `MSI`模式下的中断号, 低11位
+#define APLIC_TARGET_EIID_MASK          0x7FF
+
+/* ----- msiaddrcfgh寄存器 ----- */
+/// `HART`下标的位数
+#define APLIC_MSIADDRCFGH_LHXW_SHIFT    12
+/// 地址配置被锁定
+#define APLIC_MSIADDRCFGH_L             (1U << 31)
+
+
+/**
+ * @brief `aplic_sourcecfg_addr`用于计算中断源`src`的`sourcecfg`寄存器的`MMIO`地址
+ * 
+ * @param base `APLIC`中断域的基地址
+ * @param src 中断源编号, 从1开始
+ * @return addr_t `sourcecfg`寄存器的地址
+ */
+static inline addr_t aplic_sourcecfg_addr(addr_t base, uint32_t src){
+    return base + APLIC_SOURCECFG_BASE + (src - 1) * 4;
+}
+
+/**
+ * @brief `aplic_target_addr`用于计算中断源`src`的`target`寄存器的`MMIO`地址
+ * 
+ * @param base `APLIC`中断域的基地址
+ * @param src 中断源编号, 从1开始
+ * @return addr_t `target`寄存器的地址
+ */
+static inline addr_t aplic_target_addr(addr_t base, uint32_t src){
+    return base + APLIC_TARGET_BASE + (src - 1) * 4;
+}
+
+/**
+ * @brief `aplic_in_clrip_addr`用于计算中断源`src`所在的`in_clrip`寄存器的`MMIO`地址, 读取该寄存器得到中断源当前的输入电平
+ * 
+ * @param base `APLIC`中断域的基地址
+ * @param src 中断源编号
+ * @return addr_t `in_clrip`寄存器的地址, 中断源对应第`src % 32`位
+ */
+static inline addr_t aplic_in_clrip_addr(addr_t base, uint32_t src){
+    return base + APLIC_IN_CLRIP_BASE + (src / 32) * 4;
+}
+
+
+/* ----- IMSIC的CSR寄存器 ----- */
+#define CSR_SISELECT                    0x150
+#define CSR_SIREG                       0x151
+#define CSR_STOPEI                      0x15C
+
+/* ----- 通过siselect间接访问的中断文件寄存器 ----- */
+/// 中断文件的中断发送使能, 为1时中断文件向`HART`发送中断
+#define IMSIC_EIDELIVERY                0x70
+/// 中断文件的优先级阈值, 中断号不小于阈值的中断被屏蔽, 为0表示不屏蔽
+#define IMSIC_EITHRESHOLD               0x72
+/// 中断使能寄存器`eie0`, RV64下只有偶数编号的`eie`寄存器, 每个64位
+#define IMSIC_EIE0                      0xC0
+
+/// `stopei`寄存器中中断号的偏移
+#define IMSIC_TOPEI_ID_SHIFT            16
+
+/// `AIA_STR`将宏展开后转为字符串, 用于在内联汇编中拼接`CSR`编号
+#define _AIA_STR(x)                     #x
+#define AIA_STR(x)                      _AIA_STR(x)
+
+
+/**
+ * @brief `imsic_csr_write`用于写当前`HART`的S模式中断文件的间接寄存器`reg`
+ * 
+ * @param reg 间接寄存器的编号, 如`IMSIC_EIDELIVERY`
+ * @param value 写入的值
+ * 
+ * @note `siselect`和`sireg`需要成对访问, 调用时需要关闭中断
+ */
+static inline void imsic_csr_write(uint64_t reg, uint64_t value){
+    asm volatile(
+        "csrw " AIA_STR(CSR_SISELECT) ", %0\n"
+        "csrw " AIA_STR(CSR_SIREG) ", %1\n"
+        :: "r" (reg), "r" (value) : "memory"
+    );
+}
+
+/**
+ * @brief `imsic_csr_read`用于读当前`HART`的S模式中断文件的间接寄存器`reg`
+ * 
+ * @param reg 间接寄存器的编号, 如`IMSIC_EITHRESHOLD`
+ * @return uint64_t 寄存器的值
+ * 
+ * @note `siselect`和`sireg`需要成对访问, 调用时需要关闭中断
+ */
+static inline uint64_t imsic_csr_read(uint64_t reg){
+    uint64_t value;
+    asm volatile(
+        "csrw " AIA_STR(CSR_SISELECT) ", %1\n"
+        "csrr %0, " AIA_STR(CSR_SIREG) "\n"
+        : "=r" (value) : "r" (reg) : "memory"
+    );
+    return value;
+}
+
+/**
+ * @brief `imsic_csr_set`用于将当前`HART`的S模式中断文件的间接寄存器`reg`中`mask`的位设置为1
+ * 
+ * @param reg 间接寄存器的编号, 如`IMSIC_EIE0`
+ * @param mask 需要设置的位
+ * 
+ * @note `siselect`和`sireg`需要成对访问, 调用时需要关闭中断
+ */
+static inline void imsic_csr_set(uint64_t reg, uint64_t mask){
+    asm volatile(
+        "csrw " AIA_STR(CSR_SISELECT) ", %0\n"
+        "csrs " AIA_STR(CSR_SIREG) ", %1\n"
+        :: "r" (reg), "r" (mask) : "memory"
+    );
+}
+
+/**
+ * @brief `imsic_claim`用于认领当前`HART`的S模式中断文件中优先级最高的中断
+ * 
+ * @return uint32_t 认领的中断号, 0表示没有待处理的中断
+ * 
+ * @note 使用`csrrw`读取并写`stopei`, 读取和认领是一条指令完成的
+ */
+static inline uint32_t imsic_claim(void){
+    uint64_t topei;
+    asm volatile("csrrw %0, " AIA_STR(CSR_STOPEI) ", zero" : "=r" (topei) :: "memory");
+    return (uint32_t) (topei >> IMSIC_TOPEI_ID_SHIFT);
+}
+
+
+#endif
@@ -0,0 +1,210 @@
+/**
+ * @file atomic.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `atomic.h`基于`RISC-V`的`A`扩展提供了64位原子操作
+ * @version 0.1
+ * @date 2023-06-09
+ *
+ * @note `add`/`or`/`and`/`xchg`使用`AMO`指令实现, `cmpxchg`使用`LR/SC`指令实现
+ *
+ * @note 每个操作都有四种内存顺序, 通过函数名的后缀区分:
+ *  - 无后缀: 完全有序, 对应`.aqrl`, 操作前后的内存访问都不会越过该操作
+ *  - `_relaxed`: 只保证原子性, 不保证顺序, 适用于统计计数器
+ *  - `_acquire`: 对应`.aq`, 之后的内存访问不会在该操作之前执行, 用于获取锁
+ *  - `_release`: 对应`.rl`, 之前的内存访问不会在该操作之后执行, 用于释放锁
+ *
+ * @note 所有`fetch`操作都返回操作之前的值
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_ASM_ATOMIC_H
+#define __INCLUDE_ASM_ATOMIC_H
+
+#include "types.h"
+
+
+/**
+ * @brief `atomic64_t`是64位原子变量类型, 只能通过本文件中的函数访问
+ */
+typedef struct __atomic64_t {
+    /// @brief 原子变量的值
+    int64_t volatile counter;
+} atomic64_t;
+
+/// 静态初始化原子变量
+#define ATOMIC64_INIT(value)    {.counter = (value)}
+
+
+/**
+ * @brief `atomic64_read`用于读取原子变量的值
+ *
+ * @param v 原子变量
+ * @return int64_t 原子变量的值
+ *
+ * @note 对齐的64位读取本身就是原子的
+ */
+static inline int64_t atomic64_read(const atomic64_t *v){
+    return v->counter;
+}
+
+/**
+ * @brief `atomic64_set`用于设置原子变量的值
+ *
+ * @param v 原子变量
+ * @param value 要设置的值
+ */
+static inline void atomic64_set(atomic64_t *v, int64_t value){
+    v->counter = value;
+}
+
+/**
+ * @brief `atomic64_read_acquire`以acquire语义读取原子变量的值, 之后的内存访问不会在读取之前执行
+ *
+ * @param v 原子变量
+ * @return int64_t 原子变量的值
+ */
+static inline int64_t atomic64_read_acquire(const atomic64_t *v){
+    int64_t value = v->counter;
+    asm volatile("fence r,rw" ::: "memory");
+    return value;
+}
+
+/**
+ * @brief `atomic64_set_release`以release语义设置原子变量的值, 之前的内存访问不会在设置之后执行
+ *
+ * @param v 原子变量
+ * @param value 要设置的值
+ */
+static inline void atomic64_set_release(atomic64_t *v, int64_t value){
+    asm volatile("fence rw,w" ::: "memory");
+    v->counter = value;
+}
+
+
+/**
+ * @brief `_ATOMIC64_FETCH_OP`用于生成使用`AMO`指令的原子操作函数`atomic64_fetch_<op><suffix>`
+ *
+ * @param op 函数名中的操作名
+ * @param amo `AMO`指令名
+ * @param suffix 函数名后缀
+ * @param order `AMO`指令的内存顺序后缀
+ */
+#define _ATOMIC64_FETCH_OP(op, amo, suffix, order)                                  \
+    static inline int64_t atomic64_fetch_##op##suffix(atomic64_t *v, int64_t i){    \
+        int64_t ret;                                                                \
+        asm volatile(                                                               \
+            amo ".d" order " %0, %2, %1"                                            \
+            : "=r" (ret), "+A" (v->counter)                                         \
+            : "r" (i)                                                               \
+            : "memory"                                                              \
+        );                                                                          \
+        return ret;                                                                 \
+    }
+
+#define _ATOMIC64_FETCH_OPS(op, amo)                                                \
+    _ATOMIC64_FETCH_OP(op, amo, , ".aqrl")                                          \
+    _ATOMIC64_FETCH_OP(op, amo, _relaxed, "")                                       \
+    _ATOMIC64_FETCH_OP(op, amo, _acquire, ".aq")                                    \
+    _ATOMIC64_FETCH_OP(op, amo, _release, ".rl")
+
+_ATOMIC64_FETCH_OPS(add, "amoadd")
+_ATOMIC64_FETCH_OPS(or, "amoor")
+_ATOMIC64_FETCH_OPS(and, "amoand")
+_ATOMIC64_FETCH_OPS(xor, "amoxor")
+
+#undef _ATOMIC64_FETCH_OPS
+#undef _ATOMIC64_FETCH_OP
+
+
+/**
+ * @brief `_ATOMIC64_XCHG`用于生成使用`amoswap`指令的原子交换函数`atomic64_xchg<suffix>`, 返回交换之前的值
+ */
+#define _ATOMIC64_XCHG(suffix, order)                                               \
+    static inline int64_t atomic64_xchg##suffix(atomic64_t *v, int64_t new){        \
+        int64_t ret;                                                                \
+        asm volatile(                                                               \
+            "amoswap.d" order " %0, %2, %1"                                         \
+            : "=r" (ret), "+A" (v->counter)                                         \
+            : "r" (new)                                                             \
+            : "memory"                                                              \
+        );                                                                          \
+        return ret;                                                                 \
+    }
+
+_ATOMIC64_XCHG(, ".aqrl")
+_ATOMIC64_XCHG(_relaxed, "")
+_ATOMIC64_XCHG(_acquire, ".aq")
+_ATOMIC64_XCHG(_release, ".rl")
+
+#undef _ATOMIC64_XCHG
+
+
+/**
+ * @brief `_ATOMIC64_CMPXCHG`用于生成使用`LR/SC`指令的比较交换函数`atomic64_cmpxchg<suffix>`
+ *
+ * @note 生成的函数在原子变量的值等于`old`时将其设置为`new`, 返回操作之前的值, 因此返回值等于`old`时表示交换成功
+ * @note `sc.d`失败时(其他`HART`修改了该地址)重新`lr.d`
+ */
+#define _ATOMIC64_CMPXCHG(suffix, lr_order, sc_order)                                           \
+    static inline int64_t atomic64_cmpxchg##suffix(atomic64_t *v, int64_t old, int64_t new){    \
+        int64_t prev;                                                                           \
+        int64_t rc;                                                                             \
+        asm volatile(                                                                           \
+            "0:     lr.d" lr_order " %0, %2\n"                                                  \
+            "       bne %0, %3, 1f\n"                                                           \
+            "       sc.d" sc_order " %1, %4, %2\n"                                              \
+            "       bnez %1, 0b\n"                                                              \
+            "1:\n"                                                                              \
+            : "=&r" (prev), "=&r" (rc), "+A" (v->counter)                                       \
+            : "r" (old), "r" (new)                                                              \
+            : "memory"                                                                          \
+        );                                                                                      \
+        return prev;                                                                            \
+    }
+
+_ATOMIC64_CMPXCHG(, ".aqrl", ".aqrl")
+_ATOMIC64_CMPXCHG(_relaxed, "", "")
+_ATOMIC64_CMPXCHG(_acquire, ".aq", "")
+_ATOMIC64_CMPXCHG(_release, "", ".rl")
+
+#undef _ATOMIC64_CMPXCHG
+
+
+/**
+ * @brief `atomic64_add`用于将原子变量加`i`, 不关心返回值和顺序时使用
+ */
+static inline void atomic64_add(atomic64_t *v, int64_t i){
+    atomic64_fetch_add_relaxed(v, i);
+}
+
+/**
+ * @brief `atomic64_sub`用于将原子变量减`i`, 不关心返回值和顺序时使用
+ */
+static inline void atomic64_sub(atomic64_t *v, int64_t i){
+    atomic64_fetch_add_relaxed(v, -i);
+}
+
+/**
+ * @brief `atomic64_add_return`用于将原子变量加`i`, 并返回相加之后的值, 完全有序
+ */
+static inline int64_t atomic64_add_return(atomic64_t *v, int64_t i){
+    return atomic64_fetch_add(v, i) + i;
+}
+
+/**
+ * @brief `atomic64_inc`用于将原子变量加1, 不关心返回值和顺序时使用
+ */
+static inline void atomic64_inc(atomic64_t *v){
+    atomic64_fetch_add_relaxed(v, 1);
+}
+
+/**
+ * @brief `atomic64_dec`用于将原子变量减1, 不关心返回值和顺序时使用
+ */
+static inline void atomic64_dec(atomic64_t *v){
+    atomic64_fetch_add_relaxed(v, -1);
+}
+
+
+#endif
@@ -32,6 +32,14 @@
  */
 #define CLINT_END_ADDR                  (CLINT_BASE_ADDR + CLINT_MMIO_SIZE)
 
+/**
+ * @brief `CLINT`中断控制器的`msip0`寄存器的地址, 每个`HART`都有自己的4字节`msip`寄存器, 这个地址是`HART0`的`msip`寄存器的地址
+ * 
+ * @note 向`HARTn`的`msip`寄存器(`CLINT_MSIP_0_ADDR + 4 * n`)写1将触发`HARTn`的M模式软件中断, 写0清除
+ * @note 该值参考`SiFive FU740`手册`P176`的`CLINT Memory Map`
+ */
+#define CLINT_MSIP_0_ADDR               (CLINT_BASE_ADDR + 0x0)
+
 /**
  * @brief `CLINT`中断控制器的`mtime`寄存器的地址, 所有的`HART`共享这个寄存器
  * 
@@ -46,5 +54,10 @@
  */
 #define CLINT_TIMER_MTIMECMP_0_ADDR       (CLINT_BASE_ADDR + 0x4000)
 
+/**
+ * @brief `CLINT_TIMER_MTIMECMP_ADDR`用于计算`HART`的`mtimecmp`寄存器的地址, 每个`mtimecmp`寄存器8字节
+ */
+#define CLINT_TIMER_MTIMECMP_ADDR(hartid) (CLINT_TIMER_MTIMECMP_0_ADDR + 8 * (hartid))
+
 
 #endif
\ No newline at end of file
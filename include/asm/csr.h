@@ -163,6 +163,27 @@
 #define SIE_S_EXTERNAL_INTERRUPT                            (1UL << CAUSE_INTERRUPT_S_EXTERNAL_INTERRUPT)
 
 
+/* ----- sip寄存器 ----- */
+// * SIP寄存器和SIE寄存器的结构是一样的, S模式下只有SSIP可以写, 用于清除软件中断
+#define SIP_S_SOFTWARE_INTERRUPT                            SIE_S_SOFTWARE_INTERRUPT
+#define SIP_S_TIMER_INTERRUPT                               SIE_S_TIMER_INTERRUPT
+#define SIP_S_EXTERNAL_INTERRUPT                            SIE_S_EXTERNAL_INTERRUPT
+
+
+/* ----- Sstc扩展 ----- */
+// * 旧的汇编器不认识特权级规范1.12新增的寄存器名, 因此使用编号访问, 见`read_csr_num`
+/// `stimecmp`寄存器的编号, `time`不小于`stimecmp`时`STIP`置位
+#define CSR_STIMECMP                                        0x14D
+/// `menvcfg`寄存器的编号
+#define CSR_MENVCFG                                         0x30A
+/// `menvcfg`寄存器的`STCE`位, 置位后S模式可以访问`stimecmp`, `STIP`由`stimecmp`决定
+#define MENVCFG_STCE                                        (1UL << 63)
+/// `mcounteren`寄存器的`CY`位, 置位后S模式可以使用`rdcycle`读取`cycle`
+#define MCOUNTEREN_CY                                       (1UL << 0)
+/// `mcounteren`寄存器的`TM`位, 置位后S模式可以访问`time`和`stimecmp`
+#define MCOUNTEREN_TM                                       (1UL << 1)
+
+
 /*
  * satp寄存器
  * offset:      63            60 59                 44 43                                                    0
@@ -301,7 +322,37 @@
     );                                              \
 })
 
+/**
+ * @brief `read_clear_csr`用于将`csr`寄存器的值`value`位的值设置为0, 并返回设置之前`csr`寄存器的值
+ *
+ * @param csr 要设置的`CSR`寄存器名
+ * @param value 要设置的位
+ *
+ * @return uint64_t 设置之前`csr`寄存器的值
+ *
+ * @note 使用`csrrc`指令, 读取和设置是一条指令完成的, 中间不会被中断打断
+ */
+#define read_clear_csr(csr, value) ({               \
+    register unsigned long __v;                     \
+    unsigned long __m = (unsigned long) (value);    \
+    __asm__ __volatile__(                           \
+        "csrrc %0, " #csr ", %1"                    \
+        : "=r" (__v)                                \
+        : "rK" (__m)                                \
+        : "memory"                                  \
+    );                                              \
+    __v;                                            \
+})
+
 
+/**
+ * @brief `read_csr_num`, `write_csr_num`和`set_csr_num`与`read_csr`, `write_csr`和`set_csr`相同, 但`csr`可以是展开为寄存器编号的宏, 如`CSR_STIMECMP`
+ *
+ * @note 多一层宏展开, `csr`在转为字符串之前先被展开为编号
+ */
+#define read_csr_num(csr)           read_csr(csr)
+#define write_csr_num(csr, value)   write_csr(csr, value)
+#define set_csr_num(csr, value)     set_csr(csr, value)
 
 
 #endif
\ No newline at end of file
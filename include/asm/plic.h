@@ -56,62 +56,78 @@ static inline addr_t plic_pending_addr(uint32_t hwiid){
 }
 
 /**
- * @brief `plic_enable_addr`用于计算给定`hart`的中断使能寄存器的`MMIO`地址
- * 
+ * @brief `plic_interrupt_id_t`是`QEMU Virt`开发板上的外部中断号
+ */
+typedef enum __plic_interrupt_id_t {
+    VIRTIO_INTERRUPT_BASE = 1,
+    UART0_INTERRUPT = 10,
+    RTC_INTERRUPT = 11,
+    PCIE_INTERRUPT_BASE = 32
+} plic_interrupt_id_t;
+
+/**
+ * @brief `plic_context_id`用于计算给定`hart`指定模式的`PLIC`上下文(context)编号
+ *
  * @param hid 核心的编号, 即hart id
  * @param m_mode 核心的模式, True/False
- * @return addr_t 给定核心指定模式的中断使能寄存器的`MMIO`地址
+ * @return uint64_t `PLIC`上下文编号
+ *
+ * @note `QEMU Virt`开发板上每个`hart`有M模式和S模式两个上下文, 编号依次为`2 * hid`和`2 * hid + 1`
+ * @note `SiFive FU740`的0号核是监控核, 只有M模式上下文, 因此其余核的上下文编号要减1, 移植时需要修改这里
+ */
+static inline uint64_t plic_context_id(uint64_t hid, Bool m_mode){
+    return 2 * hid + ((m_mode == True) ? 0 : 1);
+}
+
+/**
+ * @brief `plic_enable_addr`用于计算给定上下文的中断使能寄存器的`MMIO`地址
+ * 
+ * @param ctx `PLIC`上下文编号, 由`plic_context_id`计算
+ * @return addr_t 给定上下文的中断使能寄存器的`MMIO`地址
  * 
  * @note 该值参考`SiFive FU740`手册`P180`的`PLIC Memory Map`
- * @note 每个核心都有对应的中断使能寄存器, S模式需要加0x20的偏移
+ * @note 每个上下文的中断使能寄存器占0x80字节, 每位对应一个中断
  */
-static inline addr_t plic_enable_addr(uint64_t hid, Bool m_mode){
-    offset_t offset = (m_mode == True) ? 0x2000 : 0x2080;
-    return (addr_t) (PLIC_BASE_ADDR + offset + hid * 0x80);
+static inline addr_t plic_enable_addr(uint64_t ctx){
+    return (addr_t) (PLIC_BASE_ADDR + 0x2000 + ctx * 0x80);
 }
 
 /**
- * @brief `plic_threshold_addr`用于计算给定`hart`的中断优先级阈值寄存器的`MMIO`地址
+ * @brief `plic_threshold_addr`用于计算给定上下文的中断优先级阈值寄存器的`MMIO`地址
  * 
- * @param hid 核心的编号, 即hart id
- * @param m_mode 核心的模式, True/False
- * @return addr_t 给定核心指定模式的中断优先级阈值寄存器的`MMIO`地址
+ * @param ctx `PLIC`上下文编号, 由`plic_context_id`计算
+ * @return addr_t 给定上下文的中断优先级阈值寄存器的`MMIO`地址
  * 
  * @note 该值参考`SiFive FU740`手册`P180`的`PLIC Memory Map`
- * @note 每个核心都有对应的中断优先级阈值寄存器, S模式需要加0x1000的偏移
+ * @note 每个上下文的阈值寄存器和中断请求寄存器占0x1000字节
  */
-static inline addr_t plic_threshold_addr(uint64_t hid, Bool m_mode){
-    offset_t offset = (m_mode == True) ? 0x200000 : 0x201000;
-    return (addr_t) (PLIC_BASE_ADDR + offset + hid * 0x1000);
+static inline addr_t plic_threshold_addr(uint64_t ctx){
+    return (addr_t) (PLIC_BASE_ADDR + 0x200000 + ctx * 0x1000);
 }
 
 /**
- * @brief `plic_claim_addr`用于计算给定`hart`的中断请求寄存器的`MMIO`地址
+ * @brief `plic_claim_addr`用于计算给定上下文的中断请求寄存器的`MMIO`地址
  * 
- * @param hid 核心的编号, 即hart id
- * @param m_mode 核心的模式, True/False
- * @return addr_t 给定核心指定模式的中断请求寄存器的`MMIO`地址
+ * @param ctx `PLIC`上下文编号, 由`plic_context_id`计算
+ * @return addr_t 给定上下文的中断请求寄存器的`MMIO`地址
  * 
  * @note 该值参考`SiFive FU740`手册`P180`的`PLIC Memory Map`
- * @note 每个核心都有对应的中断请求寄存器, S模式需要加0x1000的偏移
  */
-static inline addr_t plic_claim_addr(uint64_t hid, Bool m_mode){
-    return plic_threshold_addr(hid, m_mode) + 0x04;
+static inline addr_t plic_claim_addr(uint64_t ctx){
+    return plic_threshold_addr(ctx) + 0x04;
 }
 
 /**
- * @brief `plic_complete_addr`用于计算给定`hart`的中断完成寄存器的`MMIO`地址
+ * @brief `plic_complete_addr`用于计算给定上下文的中断完成寄存器的`MMIO`地址
  * 
- * @param hid 核心的编号, 即hart id
- * @param m_mode 核心的模式, True/False
- * @return addr_t 给定核心指定模式的中断完成寄存器的`MMIO`地址
+ * @param ctx `PLIC`上下文编号, 由`plic_context_id`计算
+ * @return addr_t 给定上下文的中断完成寄存器的`MMIO`地址
  * 
  * @note 该值参考`SiFive FU740`手册`P180`的`PLIC Memory Map`
- * @note 每个核心都有对应的中断完成寄存器, S模式需要加0x1000的偏移
  * @note 中断完成寄存器其实就是中断请求寄存器
  */
-static inline addr_t plic_complete_addr(uint64_t hid, Bool m_mode){
-    return plic_claim_addr(hid, m_mode);
+static inline addr_t plic_complete_addr(uint64_t ctx){
+    return plic_claim_addr(ctx);
 }
 
 
@@ -83,6 +83,9 @@
 /// `UART`的`Moden`状态寄存器(`Modem Status Register`)
 #define UART_MSR                        _UART_REG(0x06)
 
+/// `UART`发送/接收缓冲区(FIFO)的字节数
+#define UART_FIFO_SIZE                  16
+
 /// `UART`的除数寄存器低八位(`Least Significant Bits`, `LSB of Divisor Latch`), 用于进行预分频, 即设置波特率
 #define UART_DL_LSB                     _UART_REG(0x00)
 /// `UART`的除数寄存器高八位(`Most Significant Bits`, `MSB of Divisor Latch`), 用于进行预分频, 即设置波特率
@@ -111,4 +114,33 @@
 /// FIFO有数据, Receive Data Ready
 #define UART_LSR_RDR                    0b00000001
 
+
+
+/* ------------------------------ UART 中断使能寄存器IER位标志 ------------------------------ */
+/// 接收缓冲区有数据中断, Receive Data Interrupt
+#define UART_IER_RDI                    0b00000001
+/// 发送缓冲区空中断, Transmit Holding Register Empty Interrupt
+#define UART_IER_THRI                   0b00000010
+/// 接收出错中断, Receive Line Status Interrupt
+#define UART_IER_RLSI                   0b00000100
+/// Modem状态变化中断, Modem Status Interrupt
+#define UART_IER_MSI                    0b00001000
+
+
+/* ------------------------------ UART 中断状态寄存器ISR取值 ------------------------------ */
+/// `ISR`中表示中断来源的位
+#define UART_ISR_ID_MASK                0b00001111
+/// 没有待处理的中断
+#define UART_ISR_NO_INTERRUPT           0b00000001
+/// 接收出错中断, 读取`LSR`后清除
+#define UART_ISR_RLS                    0b00000110
+/// 接收缓冲区数据达到FIFO触发阈值中断, 读取`RHR`后清除
+#define UART_ISR_RDA                    0b00000100
+/// 接收超时中断, 即FIFO中有数据但未达到触发阈值, 读取`RHR`后清除
+#define UART_ISR_TIMEOUT                0b00001100
+/// 发送缓冲区空中断, 写`THR`或者读`ISR`后清除
+#define UART_ISR_THRE                   0b00000010
+/// Modem状态变化中断, 读取`MSR`后清除
+#define UART_ISR_MODEM                  0b00000000
+
 #endif
\ No newline at end of file
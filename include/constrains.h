@@ -20,9 +20,35 @@
 #define DEBUG 1
 
 /**
- * @brief 当前系统`CPU`核心数
+ * @brief 当前系统`CPU`核心数, 需要和`Makefile`中`QEMU`的`-smp`参数一致
+ *
+ * @note `mhartid`大于等于`MAX_CPU_NUM`的`HART`进入`SBI`后直接挂起, 不会被启动
  */
-#define MAX_CPU_NUM 1
+#define MAX_CPU_NUM 4
+
+/// 每个`HART`的`SBI`栈的字节数, 定义在`sboot.S`中
+#define SBI_STACK_SIZE              4096
+
+/// 每个`HART`的`SBI`私有数据(`shart_scratch_t`)的字节数, 位于`SBI`栈的顶部
+#define SBI_SCRATCH_SIZE            64
+
+/// `SBI`调用快速路径的调用表的项数, 调用号小于该值的传统调用在`strap_entry.S`中查表处理, 定义在`secall.c`中
+#define SECALL_FAST_NUM             5
+
+/// 启动`HART`时每个等待阶段的最长时间, 单位为毫秒: 等待其在`SBI`中进入`STOPPED`状态, 以及启动后等待其进入内核
+#define KSMP_BOOT_TIMEOUT_MS        1000
+
+/// 每个`HART`的内核栈的字节数, 定义在`kboot.S`中
+#define KERNEL_STACK_SIZE           4096
+
+/// 每个`HART`的中断栈的字节数, 定义在`ktrap.c`中. 第一层中断切换到中断栈, 嵌套的中断在中断栈上继续分配, 需要容纳`KIRQ_MAX_PRIORITY`层嵌套
+#define KIRQ_STACK_SIZE             16384
+
+/// 中断栈底部保留的字节数, `kirq_dispatch`发现栈指针进入该区域时认为中断栈溢出, 保留的空间用于输出错误信息
+#define KIRQ_STACK_RESERVE          2048
+
+/// 每个`HART`的per-CPU数据区的字节数, `.data.percpu`段不能超过该大小, 由`kernel.ld`在链接时检查
+#define PERCPU_AREA_SIZE            4096
 
 /**
  * @brief `CPU`是否具有浮点寄存器, 若
@@ -41,6 +67,12 @@
 /// 内核的跳转地址, 在`kernel.ld`中定义
 #define KERNEL_JUMP_ADDR    0x80200000
 
+/// 一次刷新的页数超过该值时, 直接刷新整个`TLB`, 而不是逐页执行`sfence.vma`
+#define TLB_FLUSH_ALL_THRESHOLD     64
+
+/// 内核一次`TLB`击落(shootdown)最多可以批量处理的地址范围数, 超过后刷新整个`TLB`
+#define KTLB_BATCH_RANGES           8
+
 /// 系统可用内存, 目前是`16MB`
 #define MEMORY_TOTAL        (16 * 0x100000UL)
 
@@ -62,22 +94,81 @@
 /// `kprintf`和`uprintf`可以输出的字符串最大长度
 #define PRINTF_STRING_SIZE          1024
 
+/// 每个`CPU`的内核日志环形缓冲区的槽位数, 必须是2的幂
+#define KLOG_RING_SLOTS             64
+
+/// 内核控制台发送环形缓冲区的字节数, 必须是2的幂
+#define KCONSOLE_TX_RING_SIZE       4096
+
+/// 内核控制台接收环形缓冲区的字节数, 必须是2的幂
+#define KCONSOLE_RX_RING_SIZE       1024
+
+/// 内核控制台规范模式下一行的最大字节数
+#define KCONSOLE_LINE_SIZE          256
+
+/// 内核控制台原始接收环形缓冲区的字节数, 保存外部中断中读出但还没有经过行规程处理的字符, 必须是2的幂
+#define KCONSOLE_RX_RAW_SIZE        256
+
+/// 内核控制台的推迟工作一次最多使用行规程处理的字符数, 限制持有控制台的锁(关闭中断)的时间
+#define KCONSOLE_RX_BUDGET          32
+
+/// 每次中断返回或者空闲时一个`CPU`最多运行的tasklet数, 剩下的tasklet等到下一次运行
+#define KSOFTIRQ_BUDGET             16
+
+/**
+ * @brief 是否编译内核跟踪点, 若:
+ * - `KTRACE_ENABLE = 0`, `KTRACE`宏为空, 不产生任何代码
+ * - `KTRACE_ENABLE = 1`, `KTRACE`宏记录跟踪事件
+ */
+#define KTRACE_ENABLE               1
+
+/// 每个`CPU`的跟踪缓冲区可以保存的事件数, 必须是2的幂
+#define KTRACE_RING_EVENTS          256
+
+/**
+ * @brief 是否统计锁的竞争情况(lockstat), 若:
+ * - `LOCKSTAT_ENABLE = 0`, 不统计, 锁中不包含统计信息, 获取/释放锁没有额外开销
+ * - `LOCKSTAT_ENABLE = 1`, 统计每个锁的获取次数, 竞争次数, 等待和持有的`cycle`时钟周期数, 只输出使用`lockstat_register`注册的锁
+ */
+#define LOCKSTAT_ENABLE             0
+
+/// 最多可以注册的锁的数量
+#define LOCKSTAT_MAX_LOCKS          32
+
 /// `UART`设备的波特率
 #define UART_BAUD_RATE              115200
 
 /// `CLINT`中断控制器的时钟中断频率, 目前`1000次/秒`
 #define CLINT_TIMER_FREQUENCY_HZ          1000
 
+/// 负责更新时间快照的`CPU`
+#define KTIMER_TIMEKEEPER_CPU             0
+
 /// `CLINT`中断控制器的时钟中断的默认的时钟频率
 #define CLINT_TIMER_BASE_FRQENCY          10000000
 
 /// `PLIC`中断控制器最大支持的中断数量
 #define PLIC_MAX_INTERRUPTS_NUM     53
 
+/// `IMSIC`中断文件中内核使用的最大中断号, 只使用第一个`eie`寄存器
+#define KAIA_MAX_EIID               63
+
+/// 外部中断的最高优先级, `QEMU Virt`的`PLIC`支持1~7
+#define KIRQ_MAX_PRIORITY           7
+
+/// 外部中断的默认优先级
+#define KIRQ_DEFAULT_PRIORITY       1
+
 /// 最大测试函数的数量
 #define MAX_TEST_FUNCTION_NUM       20
 
 /// 中断/异常处理函数信息最大数量
 #define MAX_INTR_EXCP_INFO_NUM      64
 
+/// 陷入统计的中断/异常号数量, 只统计标准定义的中断/异常号, 见`trap/trapstat.h`
+#define TRAPSTAT_CAUSE_NUM          16
+
+/// 陷入统计中处理时间直方图的桶数, 第`i`个桶统计处理时间在`[2^i, 2^(i+1))`个时钟周期内的陷入, 最后一个桶统计所有更长的陷入
+#define TRAPSTAT_BUCKET_NUM         16
+
 #endif
\ No newline at end of file
@@ -9,7 +9,7 @@
  * @note 关于`AXI UART 16550`芯片介绍: https://wenku.baidu.com/view/6f7a176048d7c1c708a14521.html?_wkts_=1681021571718
  * @note 关于`AXI UART 16550`相关常量, 参考`AXI UART 16550`编程手册(`Programming Table`): http://byterunner.com/16550.html
  * 
- * @warning 目前使用轮询方式使用`UART`设备, 没有实现中断方式
+ * @warning `uart.c`中的函数以轮询方式使用`UART`设备, 内核中以中断方式发送字符的功能由`kernel/kconsole.c`实现
  * @warning `uart.h`仅提供`UART`相关功能, `AXI UART 16550`相关常量的定义在`asm/uart.h`中
  * 
  * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
@@ -59,12 +59,42 @@ void uart_put(char chr);
  */
 void uart_puts(const char *string);
 
+/**
+ * @brief `uart_fifo_write`以非阻塞的方式向`UART`设备的发送缓冲区(FIFO)写入字符
+ * 
+ * @param buf 要发送的字符
+ * @param len 要发送的字符数
+ * @return size_t 实际写入的字符数, 发送缓冲区非空时返回0
+ * 
+ * @note 发送缓冲区为空时一次最多写入`UART_FIFO_SIZE`个字符, 不会轮询等待
+ */
+size_t uart_fifo_write(const char *buf, size_t len);
+
+/**
+ * @brief `uart_set_interrupt`用于打开/关闭`UART`设备的中断
+ * 
+ * @param mask 中断使能寄存器`IER`中的中断位, 即`UART_IER_*`
+ * @param enable True, 打开; False, 关闭
+ */
+void uart_set_interrupt(uint8_t mask, Bool enable);
 
 /**
- * @brief `UART`外部设备的中断处理函数, 用于接受字符
+ * @brief `uart_interrupt_status`返回`UART`设备当前最高优先级的待处理中断
+ * 
+ * @return uint8_t 中断状态寄存器`ISR`中的中断来源, 即`UART_ISR_*`, 没有待处理的中断时返回`UART_ISR_NO_INTERRUPT`
+ */
+uint8_t uart_interrupt_status(void);
+
+
+/**
+ * @brief `uart_rx_drain`用于读取`UART`设备接收缓冲区(FIFO)中的所有字符
+ * 
+ * @param buf 接受字符的数组
+ * @param max 最多读取的字符数
+ * @return size_t 读取的字符数
  * 
- * @note 接受到的字符将被放入字符缓冲区
+ * @note 接收中断中应该读空FIFO, 这样一次输入多个字符时只会触发一次中断
  */
-void uart_interrupt_handler(void);
+size_t uart_rx_drain(char *buf, size_t max);
 
 #endif
@@ -0,0 +1,146 @@
+/**
+ * @file fdt.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `fdt.h`提供了扁平设备树(Flattened Device Tree, FDT)的只读解析函数
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @note 设备树由`QEMU`通过`a1`寄存器传给`SBI`, `SBI`再原样传给内核. 设备树中的数据都是大端序
+ * @note 设备树的结构块由一系列4字节对齐的令牌组成, 节点用`FDT_BEGIN_NODE`和`FDT_END_NODE`包围, 节点的属性紧跟在`FDT_BEGIN_NODE`之后.
+ *      本文件中的节点偏移都是节点的`FDT_BEGIN_NODE`令牌相对结构块起始地址的偏移
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_FDT_H
+#define __INCLUDE_FDT_H
+
+#include "types.h"
+
+/// 设备树头部的魔数
+#define FDT_MAGIC           0xD00DFEED
+
+/// 结构块令牌: 节点开始
+#define FDT_BEGIN_NODE      0x1
+/// 结构块令牌: 节点结束
+#define FDT_END_NODE        0x2
+/// 结构块令牌: 属性
+#define FDT_PROP            0x3
+/// 结构块令牌: 空
+#define FDT_NOP             0x4
+/// 结构块令牌: 结构块结束
+#define FDT_END             0x9
+
+
+/**
+ * @brief `fdt_header_t`是设备树的头部, 所有成员都是大端序
+ */
+typedef struct __fdt_header_t {
+    uint32_t magic;
+    uint32_t totalsize;
+    uint32_t off_dt_struct;
+    uint32_t off_dt_strings;
+    uint32_t off_mem_rsvmap;
+    uint32_t version;
+    uint32_t last_comp_version;
+    uint32_t boot_cpuid_phys;
+    uint32_t size_dt_strings;
+    uint32_t size_dt_struct;
+} fdt_header_t;
+
+
+/**
+ * @brief `fdt32_to_cpu`将大端序的32位整数转换为`CPU`的字节序(小端序)
+ * 
+ * @param value 大端序的32位整数
+ * @return uint32_t 小端序的32位整数
+ */
+static inline uint32_t fdt32_to_cpu(uint32_t value){
+    return ((value & 0xFF) << 24) | ((value & 0xFF00) << 8) | ((value >> 8) & 0xFF00) | (value >> 24);
+}
+
+
+/**
+ * @brief `fdt_check_header`检查`dtb`是否指向一个合法的设备树
+ * 
+ * @param dtb 设备树的地址
+ * @return Bool 合法返回True, 否则返回False
+ */
+Bool fdt_check_header(addr_t dtb);
+
+
+/**
+ * @brief `fdt_find_compatible`从`start`之后查找第一个`compatible`属性包含`compatible`的节点
+ * 
+ * @param dtb 设备树的地址
+ * @param start 从该节点之后开始查找, -1表示从头开始查找
+ * @param compatible 需要查找的`compatible`字符串
+ * @return int64_t 找到的节点的偏移, 没有找到返回-1
+ */
+int64_t fdt_find_compatible(addr_t dtb, int64_t start, const char *compatible);
+
+
+/**
+ * @brief `fdt_get_property`用于获取节点`node`的属性`name`
+ * 
+ * @param dtb 设备树的地址
+ * @param node 节点的偏移
+ * @param name 属性的名字
+ * @param len 若不为NULL, 则返回属性值的字节数
+ * @return const void* 属性值的地址, 属性不存在时返回NULL
+ */
+const void *fdt_get_property(addr_t dtb, int64_t node, const char *name, uint32_t *len);
+
+
+/**
+ * @brief `fdt_get_u32`用于读取节点`node`的第`index`个32位整数的属性值
+ * 
+ * @param dtb 设备树的地址
+ * @param node 节点的偏移
+ * @param name 属性的名字
+ * @param index 属性值中整数(cell)的下标
+ * @param value 返回读取的值
+ * @return Bool 属性存在且足够长时返回True, 否则返回False
+ */
+Bool fdt_get_u32(addr_t dtb, int64_t node, const char *name, uint32_t index, uint32_t *value);
+
+
+/**
+ * @brief `fdt_get_reg`用于读取节点`node`的`reg`属性中第`index`个地址区间
+ * 
+ * @param dtb 设备树的地址
+ * @param node 节点的偏移
+ * @param index 地址区间的下标
+ * @param addr 返回地址区间的起始地址
+ * @param size 返回地址区间的大小
+ * @return Bool `reg`属性存在且足够长时返回True, 否则返回False
+ * 
+ * @note 假设父节点的`#address-cells`和`#size-cells`都为2, `QEMU Virt`开发板的`/soc`节点满足这个条件
+ */
+Bool fdt_get_reg(addr_t dtb, int64_t node, uint64_t index, addr_t *addr, size_t *size);
+
+
+/**
+ * @brief `fdt_cpu_mask`用于获取设备树中所有可用的`CPU`的`hartid`
+ * 
+ * @param dtb 设备树的地址
+ * @return uint64_t 第`i`位表示`hartid`为`i`的`CPU`存在, 设备树不合法时返回0
+ * 
+ * @note `status`属性不为`"okay"`的`CPU`视为不存在
+ */
+uint64_t fdt_cpu_mask(addr_t dtb);
+
+
+/**
+ * @brief `fdt_isa_has_extension`用于判断设备树中所有`CPU`是否都支持多字母扩展`ext`, 例如`"sstc"`
+ * 
+ * @param dtb 设备树的地址
+ * @param ext 扩展名, 小写
+ * @return Bool 设备树合法, 至少有一个`CPU`且所有`CPU`都支持该扩展时返回True
+ * 
+ * @note 优先读取`riscv,isa-extensions`属性, 没有时解析`riscv,isa`属性中以`_`分隔的多字母扩展
+ */
+Bool fdt_isa_has_extension(addr_t dtb, const char *ext);
+
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * @file kaia.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `kaia.h`是`AIA`中断控制器(`APLIC` + `IMSIC`)内核部分的代码
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @note `SBI`已经将所有中断源委托给S模式的`APLIC`中断域, 内核将该中断域设置为`MSI`模式: 每个注册的中断源分配一个中断号(EIID),
+ *      `APLIC`的`target`寄存器决定中断发送到哪个`HART`的中断文件. 迁移中断只需要修改`target`寄存器
+ * 
+ * @note 每个`HART`上线时使能自己中断文件中所有的中断号, 因此分配中断号时不需要访问其他`HART`的`CSR`
+ * @note `IMSIC`中中断号越小优先级越高, 中断号按照中断源的优先级分段分配, 同一优先级内按照注册顺序从小到大分配.
+ *      处理中断期间将`eithreshold`设置为该中断号, 只有中断号更小的中断可以嵌套
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KAIA_H
+#define __INCLUDE_KERNEL_KAIA_H
+
+#include "types.h"
+#include "asm/aia.h"
+#include "constrains.h"
+#include "kernel/kirq.h"
+#include "trap/trapframe.h"
+
+
+/**
+ * @brief `kaia_probe`在设备树中查找S模式的`APLIC`中断域和`IMSIC`中断文件
+ * 
+ * @param dtb 设备树的地址
+ * @return Bool 找到返回True, 否则返回False
+ */
+Bool kaia_probe(addr_t dtb);
+
+
+/**
+ * @brief `kaia_init`将S模式的`APLIC`中断域设置为`MSI`模式, 并关闭所有中断源
+ * 
+ * @note 需要先调用`kaia_probe`
+ */
+void kaia_init(void);
+
+
+/**
+ * @brief `kaia_interrupt_handler`是使用`AIA`时S模式下的外部中断处理函数
+ * 
+ * @param ktf_ptr 陷入帧, S模式下中断触发后在`ktrap_enter`中构建
+ * @return int64_t 处理结果, 若为0则表示处理正常
+ * 
+ * @note 通过`stopei`寄存器认领中断, 不需要访问`MMIO`寄存器
+ */
+int64_t kaia_interrupt_handler(ktrapframe_t *ktf_ptr);
+
+
+/// `AIA`中断控制器的操作, 由`kirq`在设备树中有`AIA`时使用
+extern kirq_chip_t kaia_chip;
+
+
+#endif
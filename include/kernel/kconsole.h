@@ -0,0 +1,128 @@
+/**
+ * @file kconsole.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `kconsole.h`是内核控制台, 以中断方式驱动`UART`设备发送字符
+ * @version 0.1
+ * @date 2023-06-04
+ *
+ * @note 写入控制台的字符先保存在发送环形缓冲区中, `UART`发送缓冲区(FIFO)为空时触发`THRE`中断,
+ *      在中断处理函数中一次向FIFO写入`UART_FIFO_SIZE`个字符. 因此写入控制台不需要等待`UART`发送完成
+ *
+ * @note 接收中断中读空`UART`的FIFO, 接收到的字符经过行规程(line discipline)处理后放入接收环形缓冲区, 由`kconsole_read`读取
+ *
+ * @note `device/uart.c`同时被`SBI`和内核使用, 因此缓冲区放在内核的控制台中, `device/uart.c`只提供访问硬件的函数
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KCONSOLE_H
+#define __INCLUDE_KERNEL_KCONSOLE_H
+
+#include "types.h"
+#include "constrains.h"
+
+
+/**
+ * @brief `kconsole_discipline_t`是控制台的行规程设置
+ */
+typedef struct __kconsole_discipline_t {
+    /**
+     * @brief 是否为规范模式(canonical mode), 若:
+     * - `canonical = True`, 输入按行缓冲, 支持退格(`Backspace`/`Delete`)和删除整行(`Ctrl+U`), 按下回车后才能被读取. `Ctrl+T`将输出跟踪缓冲区, `Ctrl+L`将输出锁的竞争统计信息和内核计数器
+     * - `canonical = False`, 即原始模式(raw mode), 输入的字符立即可以被读取
+     */
+    Bool canonical;
+    /// @brief 是否回显输入的字符
+    Bool echo;
+    /**
+     * @brief 唤醒读者的字符数阈值:
+     * - 原始模式下, 接收环形缓冲区中的字符数达到`threshold`时唤醒读者
+     * - 规范模式下, 一行的长度达到`threshold`时即使没有回车也提交该行
+     */
+    size_t threshold;
+} kconsole_discipline_t;
+
+
+/**
+ * @brief `kconsole_init`是内核控制台的初始化函数
+ *
+ * @note 初始化之前写入控制台的字符将以轮询方式直接发送
+ */
+void kconsole_init(void);
+
+
+/**
+ * @brief `kconsole_write`用于向控制台写入`len`个字符
+ *
+ * @param buf 要写入的字符
+ * @param len 要写入的字符数
+ * @return size_t 写入的字符数, 即`len`
+ *
+ * @note 发送环形缓冲区满时:
+ *  - 若中断是打开的, 则使用`wfi`等待`THRE`中断腾出空间
+ *  - 若中断是关闭的(例如在中断处理函数中), 则以轮询方式向`UART`写入字符腾出空间
+ */
+size_t kconsole_write(const char *buf, size_t len);
+
+
+/**
+ * @brief `kconsole_try_write`以非阻塞的方式向控制台写入至多`len`个字符
+ *
+ * @param buf 要写入的字符
+ * @param len 要写入的字符数
+ * @return size_t 实际写入的字符数, 发送环形缓冲区满时返回0
+ */
+size_t kconsole_try_write(const char *buf, size_t len);
+
+
+/**
+ * @brief `kconsole_flush`以轮询方式发送发送环形缓冲区中的所有字符
+ *
+ * @note 切换到同步输出之前需要调用该函数, 以保证输出的顺序
+ */
+void kconsole_flush(void);
+
+
+/**
+ * @brief `kconsole_panic_flush`不获取控制台的锁, 以轮询方式发送发送环形缓冲区中的所有字符
+ *
+ * @note 只能在内核崩溃时使用: 崩溃可能发生在当前`CPU`持有控制台的锁时, 此时`kconsole_flush`会死锁
+ */
+void kconsole_panic_flush(void);
+
+
+/**
+ * @brief `kconsole_interrupt_handler`是`UART`设备的中断处理函数, 由`kirq_dispatch`通过中断注册表调用
+ *
+ * @note 一次处理`UART`设备所有待处理的中断:
+ *  - `THRE`中断: 从发送环形缓冲区向FIFO写入字符
+ *  - 接收中断: 读空接收缓冲区(FIFO), 放入原始接收环形缓冲区
+ *  行规程, 回显和输出内核日志由控制台的tasklet完成, 见`ksoftirq.h`
+ */
+void kconsole_interrupt_handler(void);
+
+
+/**
+ * @brief `kconsole_set_discipline`用于设置控制台的行规程
+ *
+ * @param discipline 行规程设置
+ *
+ * @note 从规范模式切换到原始模式时, 正在编辑的行将被提交
+ */
+void kconsole_set_discipline(const kconsole_discipline_t *discipline);
+
+
+/**
+ * @brief `kconsole_read`用于从控制台读取至多`len`个字符, 没有可读的字符时阻塞
+ *
+ * @param buf 接受字符的数组
+ * @param len 最多读取的字符数
+ * @return size_t 读取的字符数
+ *
+ * @note 规范模式下最多读取一行, 即读到`\n`时返回; 原始模式下接收环形缓冲区中的字符数达到阈值时返回
+ * @note 目前还没有进程调度, 读者在`wfi`中等待中断, 中断返回后重新检查; 关中断时以轮询方式接收字符, 并直接使用行规程处理
+ */
+size_t kconsole_read(char *buf, size_t len);
+
+
+#endif
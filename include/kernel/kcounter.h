@@ -0,0 +1,113 @@
+/**
+ * @file kcounter.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `kcounter.h`提供了每个`CPU`一份的内核统计计数器
+ * @version 0.1
+ * @date 2023-06-09
+ *
+ * @note 每个`CPU`只修改自己的计数值, 每个计数值独占一个缓存行, 因此计数时缓存行不会在`CPU`之间来回传递, 也不需要获取锁.
+ *      读取时将所有`CPU`的计数值相加, 读取的结果不是一个精确的快照, 只适用于统计信息
+ *
+ * 举例:
+ * ```c
+ * kcounter_t page_faults = KCOUNTER_INIT("page faults");
+ * kcounter_register(&page_faults);
+ * kcounter_inc(&page_faults);
+ * ```
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KCOUNTER_H
+#define __INCLUDE_KERNEL_KCOUNTER_H
+
+#include "types.h"
+#include "constrains.h"
+#include "asm/atomic.h"
+#include "kernel/ksmp.h"
+
+
+/**
+ * @brief `kcounter_slot_t`是一个`CPU`的计数值, 独占一个缓存行
+ */
+typedef struct __kcounter_slot_t {
+    /// @brief 计数值
+    atomic64_t value;
+} ALIGN64 kcounter_slot_t;
+
+
+/**
+ * @brief `kcounter_t`是内核统计计数器
+ */
+typedef struct __kcounter_t {
+    /// @brief 每个`CPU`的计数值
+    kcounter_slot_t slots[MAX_CPU_NUM];
+    /// @brief 计数器的名字
+    const char *name;
+    /// @brief 已注册的计数器链表中的下一个计数器
+    struct __kcounter_t *next;
+} kcounter_t;
+
+/// 静态初始化计数器
+#define KCOUNTER_INIT(counter_name)     {.name = (counter_name), .next = NULL}
+
+
+/**
+ * @brief `kcounter_add`用于将当前`CPU`的计数值加`n`
+ *
+ * @param counter 计数器
+ * @param n 增加的值
+ *
+ * @note 同一个`CPU`上的中断可能打断计数, 因此使用`amoadd`而不是普通的加法, 但是不需要任何内存顺序
+ */
+static inline void kcounter_add(kcounter_t *counter, int64_t n){
+    atomic64_add(&counter->slots[cpu_id()].value, n);
+}
+
+
+/**
+ * @brief `kcounter_inc`用于将当前`CPU`的计数值加1
+ *
+ * @param counter 计数器
+ */
+static inline void kcounter_inc(kcounter_t *counter){
+    kcounter_add(counter, 1);
+}
+
+
+/**
+ * @brief `kcounter_read`用于读取计数器的值, 即所有`CPU`的计数值之和
+ *
+ * @param counter 计数器
+ * @return int64_t 计数器的值
+ */
+int64_t kcounter_read(kcounter_t *counter);
+
+
+/**
+ * @brief `kcounter_read_cpu`用于读取计数器在指定`CPU`上的计数值
+ *
+ * @param counter 计数器
+ * @param cpu `CPU`的编号
+ * @return int64_t 计数值
+ */
+int64_t kcounter_read_cpu(kcounter_t *counter, uint64_t cpu);
+
+
+/**
+ * @brief `kcounter_register`用于注册计数器, 注册后的计数器将在`kcounter_dump`中输出
+ *
+ * @param counter 计数器
+ *
+ * @note 重复注册同一个计数器没有效果
+ */
+void kcounter_register(kcounter_t *counter);
+
+
+/**
+ * @brief `kcounter_dump`用于输出所有已注册的计数器
+ */
+void kcounter_dump(void);
+
+
+#endif
@@ -11,6 +11,7 @@
 #define __INCLUDE_KERNEL_KDEBUG_H
 
 #include "constrains.h"
+#include "kernel/klog.h"
 #include "kernel/ktrap.h"
 #include "kernel/kstdio.h"
 
@@ -27,6 +28,8 @@
  */
 static inline void kpanic_spin(char *filename, int line, const char* func, const char* condition, const char*msg, ...){
     supervisor_interrupt_disable();
+    // 切换到同步模式, 确保错误信息一定可以输出
+    klog_panic();
     kprintf("===================== Error Message =====================%c", '\n');
     kprintf("filename: %s, at line %d\n", filename, line);
     kprintf("unsatisfied condition: %s\n", condition);
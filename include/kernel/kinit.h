@@ -20,8 +20,10 @@
  * 
  * @note `kinit_all`的初始化顺序:
  *  1. `uart_init`: 初始化`uart`设备. 已经交给`SBI`来初始化了
+ * 
+ * @param dtb 设备树的地址, 由`SBI`传入
  */
-void kinit_all(void);
+void kinit_all(addr_t dtb);
 
 
 #endif
\ No newline at end of file
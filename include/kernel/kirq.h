@@ -0,0 +1,154 @@
+/**
+ * @file kirq.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `kirq.h`是内核的外部中断管理模块, 在`PLIC`和`AIA`两种中断控制器之上提供统一的中断注册和亲和性接口
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @note 启动时根据设备树选择中断控制器: 设备树中有S模式的`APLIC`和`IMSIC`时使用`AIA`(见`kaia.h`), 否则使用`PLIC`(见`kplic.h`).
+ *      设备驱动只使用本文件中的接口, 不需要关心使用的是哪一种中断控制器
+ * 
+ * @note 中断使用中断源编号(硬件中断号)标识, 两种中断控制器的中断源编号相同, 见`asm/plic.h`中的`plic_interrupt_id_t`
+ * 
+ * @note 中断的优先级从高到低为: 时钟中断, 软件中断, 外部中断. 外部中断之间再按照`kirq_set_priority`设置的优先级区分,
+ *      处理外部中断期间中断控制器只发送优先级更高的外部中断, 见`kirq_dispatch`
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KIRQ_H
+#define __INCLUDE_KERNEL_KIRQ_H
+
+#include "types.h"
+#include "asm/plic.h"
+#include "constrains.h"
+#include "trap/trapframe.h"
+
+
+/// 由内核在在线的`CPU`之间轮流分配中断
+#define KIRQ_AFFINITY_AUTO      (-1)
+
+
+/**
+ * @brief `kirq_handler_t`是外部中断的处理函数, 在收到中断的`CPU`上调用
+ * 
+ * @note 调用时中断是打开的, 可能被时钟中断, 软件中断和优先级更高的外部中断打断, 与中断上下文共享的数据需要使用`spinlock_acquire_irqsave`保护
+ */
+typedef void (*kirq_handler_t)(void);
+
+
+/**
+ * @brief `kirq_desc_t`是一个外部中断的注册信息
+ */
+typedef struct __kirq_desc_t {
+    /// @brief 中断的名字
+    const char *name;
+    /// @brief 中断的处理函数, 为NULL表示未注册
+    kirq_handler_t handler;
+    /// @brief 处理该中断的`CPU`, 为`MAX_CPU_NUM`表示没有路由到任何`CPU`
+    uint64_t cpu;
+    /// @brief 是否由内核自动分配`CPU`
+    Bool auto_affinity;
+    /// @brief 中断的优先级, 1~`KIRQ_MAX_PRIORITY`, 数字越大优先级越高
+    uint32_t priority;
+} kirq_desc_t;
+
+
+/**
+ * @brief `kirq_chip_t`是中断控制器需要提供的操作
+ */
+typedef struct __kirq_chip_t {
+    /// @brief 中断控制器的名字
+    const char *name;
+    /**
+     * @brief 将中断源`hwiid`从`old_cpu`迁移到`new_cpu`, `old_cpu`为`MAX_CPU_NUM`表示第一次路由. 调用时持有`kirq`的锁
+     */
+    void (*route)(uint32_t hwiid, uint64_t old_cpu, uint64_t new_cpu);
+    /**
+     * @brief `CPU`上线时在该`CPU`上调用, 初始化该`CPU`私有的中断控制器状态
+     */
+    void (*cpu_online)(uint64_t cpu);
+    /**
+     * @brief 设置中断源`hwiid`的优先级, 中断源可能还没有路由. 调用时持有`kirq`的锁
+     */
+    void (*set_priority)(uint32_t hwiid, uint32_t priority);
+    /**
+     * @brief S模式外部中断处理函数, 注册到`ktrap`中
+     */
+    int64_t (*interrupt_handler)(ktrapframe_t *ktf_ptr);
+} kirq_chip_t;
+
+
+/**
+ * @brief `kirq_init`根据设备树选择并初始化中断控制器
+ * 
+ * @param dtb 设备树的地址, 由`SBI`传入, 为0或者不合法时使用`PLIC`
+ * 
+ * @note 需要在`memory_init`之前调用, 之后设备树所在的内存可能被分配出去
+ */
+void kirq_init(addr_t dtb);
+
+
+/**
+ * @brief `kirq_register`用于注册外部中断的处理函数, 并将中断路由到指定的`CPU`
+ * 
+ * @param hwiid 硬件中断号, hardware interrupt id
+ * @param name 中断的名字
+ * @param handler 中断的处理函数
+ * @param cpu 处理中断的`CPU`, `KIRQ_AFFINITY_AUTO`表示轮流分配
+ * @return int64_t 0表示注册成功, -1表示参数错误或者中断已经注册
+ */
+int64_t kirq_register(uint32_t hwiid, const char *name, kirq_handler_t handler, int64_t cpu);
+
+
+/**
+ * @brief `kirq_set_affinity`用于将已注册的外部中断迁移到指定的`CPU`
+ * 
+ * @param hwiid 硬件中断号, hardware interrupt id
+ * @param cpu 处理中断的`CPU`, `KIRQ_AFFINITY_AUTO`表示轮流分配
+ * @return int64_t 0表示迁移成功, -1表示参数错误或者中断未注册
+ */
+int64_t kirq_set_affinity(uint32_t hwiid, int64_t cpu);
+
+
+/**
+ * @brief `kirq_set_priority`用于设置外部中断的优先级, 可以在注册之前调用
+ * 
+ * @param hwiid 硬件中断号, hardware interrupt id
+ * @param priority 中断的优先级, 1~`KIRQ_MAX_PRIORITY`, 数字越大优先级越高, 默认为`KIRQ_DEFAULT_PRIORITY`
+ * @return int64_t 0表示设置成功, -1表示参数错误
+ * 
+ * @note 延迟敏感的设备应设置更高的优先级, 以便打断处理时间较长的设备的处理函数
+ */
+int64_t kirq_set_priority(uint32_t hwiid, uint32_t priority);
+
+
+/**
+ * @brief `kirq_cpu_online`在`CPU`上线时在该`CPU`上调用, 初始化该`CPU`的中断控制器, 并将自动分配的中断重新分配到所有在线的`CPU`上
+ * 
+ * @param cpu 上线的`CPU`
+ */
+void kirq_cpu_online(uint64_t cpu);
+
+
+/**
+ * @brief `kirq_interrupt_handler`是S模式下的外部中断处理函数, 调用当前中断控制器的中断处理函数
+ * 
+ * @param ktf_ptr 陷入帧
+ * @return int64_t 处理结果, 若为0则表示处理正常
+ */
+int64_t kirq_interrupt_handler(ktrapframe_t *ktf_ptr);
+
+
+/**
+ * @brief `kirq_dispatch`由中断控制器的中断处理函数调用, 调用中断源`hwiid`的处理函数
+ * 
+ * @param hwiid 硬件中断号, hardware interrupt id
+ * 
+ * @note 调用前中断控制器需要将当前`CPU`的优先级阈值提高到`hwiid`的优先级, 之后处理函数在打开中断的情况下运行, 返回时中断重新关闭
+ * @note 打开中断前检查中断栈, 栈底的`KIRQ_STACK_CANARY`被覆盖或者剩余空间不足`KIRQ_STACK_RESERVE`时挂起内核
+ */
+void kirq_dispatch(uint32_t hwiid);
+
+
+#endif
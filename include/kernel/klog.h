@@ -0,0 +1,150 @@
+/**
+ * @file klog.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `klog.h`提供了内核日志缓冲区, `kprintf`的输出将先写入每个`CPU`的日志环形缓冲区, 再异步输出到`UART`
+ * @version 0.1
+ * @date 2023-06-02
+ *
+ * @note 日志环形缓冲区是无锁的, 写入日志只需要拷贝字符串, 不需要等待`UART`发送完成.
+ *      日志的输出(drain)在时钟中断和`UART`的`THRE`中断中进行, 每次只向控制台的发送环形缓冲区写入其可以接受的字节数, 不会轮询等待
+ *
+ * @note 内核崩溃时需要调用`klog_panic`切换到同步模式, 以确保错误信息一定可以输出
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KLOG_H
+#define __INCLUDE_KERNEL_KLOG_H
+
+#include "types.h"
+#include "constrains.h"
+
+
+/// 每个日志槽位可以保存的最大字符数, 超出的部分将被保存到后续的槽位中
+#define KLOG_SLOT_TEXT_SIZE     110
+
+
+/**
+ * @brief `klog_level_t`是日志的等级
+ */
+typedef enum __klog_level_t {
+    /// @brief 调试信息
+    KLOG_DEBUG = 0,
+    /// @brief 一般信息, `kprintf`的默认等级
+    KLOG_INFO,
+    /// @brief 警告信息
+    KLOG_WARN,
+    /// @brief 错误信息
+    KLOG_ERROR
+} klog_level_t;
+
+
+/**
+ * @brief `klog_mode_t`是日志的输出模式
+ */
+typedef enum __klog_mode_t {
+    /// @brief 同步模式, 日志直接以轮询方式输出到`UART`, 用于启动阶段和内核崩溃时
+    KLOG_MODE_SYNC = 0,
+    /// @brief 异步模式, 日志写入环形缓冲区, 由时钟中断和`UART`中断输出到控制台
+    KLOG_MODE_ASYNC
+} klog_mode_t;
+
+
+/**
+ * @brief `klog_slot_t`是日志环形缓冲区中的一个槽位, 保存一条日志记录(或者一条长日志的一部分)
+ *
+ * @note `sequence`用于无锁的生产者/消费者同步:
+ *  - `sequence == pos`: 槽位空闲, 生产者可以写入
+ *  - `sequence == pos + 1`: 槽位已写入, 消费者可以读取
+ *  - 消费者读取后将`sequence`设置为`pos + KLOG_RING_SLOTS`, 即下一轮的空闲状态
+ */
+typedef struct __klog_slot_t {
+    /// @brief 槽位的序号
+    uint64_t volatile sequence;
+    /// @brief 写入日志时的时钟周期数
+    uint64_t timestamp;
+    /// @brief 日志等级, 即`klog_level_t`
+    uint8_t level;
+    /// @brief `text`中的字符数
+    uint8_t length;
+    /// @brief 日志文本, 不以`\0`结尾
+    char text[KLOG_SLOT_TEXT_SIZE];
+} klog_slot_t;
+
+
+/**
+ * @brief `klog_ring_t`是每个`CPU`的日志环形缓冲区
+ */
+typedef struct __klog_ring_t {
+    /// @brief 生产者的位置, 即下一个要写入的槽位
+    uint64_t volatile head;
+    /// @brief 消费者的位置, 即下一个要读取的槽位
+    uint64_t volatile tail;
+    /// @brief 因为缓冲区满而被丢弃的日志数, 长日志的每个分段(槽位)计为一条
+    uint64_t volatile dropped;
+    /// @brief 消费者是否位于一行的开头, 位于行首时需要输出时间戳
+    Bool line_start;
+    /// @brief 日志槽位
+    klog_slot_t slots[KLOG_RING_SLOTS];
+} klog_ring_t;
+
+
+/**
+ * @brief `klog_init`用于初始化所有`CPU`的日志环形缓冲区
+ *
+ * @note 初始化之前以及初始化之后, 日志都处于同步模式, 需要调用`klog_set_mode`切换到异步模式
+ */
+void klog_init(void);
+
+
+/**
+ * @brief `klog_set_mode`用于设置日志的输出模式
+ *
+ * @param mode 日志的输出模式
+ *
+ * @note 切换到同步模式时会等待正在输出日志的`CPU`完成, 而后以轮询的方式输出缓冲区中所有尚未输出的日志. 内核崩溃时需要使用`klog_panic`
+ */
+void klog_set_mode(klog_mode_t mode);
+
+
+/**
+ * @brief `klog_panic`用于在内核崩溃时切换到同步模式, 以轮询的方式输出缓冲区中所有尚未输出的日志, 确保之前的日志不会丢失
+ *
+ * @note 与`klog_set_mode(KLOG_MODE_SYNC)`不同, 不等待正在输出日志的`CPU`, 因为被打断的可能正是当前`CPU`; 也不获取控制台的锁, 见`kconsole_panic_flush`
+ */
+void klog_panic(void);
+
+
+/**
+ * @brief `klog_write`用于向当前`CPU`的日志环形缓冲区写入一条日志
+ *
+ * @param level 日志等级
+ * @param text 日志文本
+ * @param len 日志文本的长度
+ *
+ * @note 同步模式下日志直接输出到`UART`; 异步模式下缓冲区满时日志将被丢弃, 丢弃的日志数将在之后输出
+ */
+void klog_write(klog_level_t level, const char *text, size_t len);
+
+
+/**
+ * @brief `klogf`用于以指定的等级格式化输出日志
+ *
+ * @param level 日志等级
+ * @param format 含格式控制字符的格式字符串
+ * @param ... 可变参数列表
+ * @return size_t 输出的字符串中的字符数
+ */
+size_t klogf(klog_level_t level, const char *format, ...);
+
+
+/**
+ * @brief `klog_drain`用于将日志环形缓冲区中的日志输出到`UART`
+ *
+ * @note `klog_drain`不会轮询等待`UART`, 每次只写入控制台发送环形缓冲区可以接受的字节数, 因此可以在中断处理函数中调用
+ * @note 同一时刻只有一个`CPU`可以输出日志, 其他`CPU`调用时将直接返回
+ */
+void klog_drain(void);
+
+
+#endif
@@ -83,8 +83,11 @@ extern char _s_bss[],            _e_bss[];
 
 /**
  * @brief `kernel_main`是内核的入口函数
+ * 
+ * @param hartid 当前`HART`的编号
+ * @param dtb 设备树的地址, 由`SBI`通过`a1`寄存器传入
  */
-void kernel_main(void);         // make gcc happy :)
+void kernel_main(uint64_t hartid, addr_t dtb);         // make gcc happy :)
 
 /**
  * @brief `print_kmem`用于输出内核在内存中的地址信息
@@ -14,16 +14,30 @@
 #include "types.h"
 #include "asm/plic.h"
 #include "constrains.h"
+#include "kernel/kirq.h"
 #include "trap/trapframe.h"
 
 /**
  * @brief `kplic_init`是`PLIC`中断控制器的初始化函数
  * 
- * @note 目前只对一个核心进行了初始化, 未来多核心要考虑这个问题
+ * @note 关闭所有`CPU`上的所有中断, 设备需要通过`kirq_register`注册并使能中断
  */
 void kplic_init(void);
 
 
+/// `PLIC`中断控制器的操作, 由`kirq`在设备树中没有`AIA`时使用
+extern kirq_chip_t kplic_chip;
+
+
+/**
+ * @brief `kplic_set_threshold`用于设置指定CPU的S模式上下文的中断优先级阈值, 优先级不大于阈值的中断被屏蔽
+ *
+ * @param cid CPU id
+ * @param threshold 优先级阈值, 0~7
+ */
+void kplic_set_threshold(uint64_t cid, uint32_t threshold);
+
+
 /**
  * @brief `kplic_set_priority`用于设置
  * 
@@ -38,6 +52,7 @@ void kplic_set_priority(uint32_t hwiid, uint32_t priority);
  * @param cid CPU id
  * @param hwiid 硬件中断号, hardware interrupt id
  * @param enable True, 使能; False, 不使能
+ * @param m_mode True, M模式上下文; False, S模式上下文
  */
 void kplic_enable_interrupt(uint64_t cid, uint32_t hwiid, Bool enable, Bool m_mode);
 
@@ -48,7 +63,8 @@ void kplic_enable_interrupt(uint64_t cid, uint32_t hwiid, Bool enable, Bool m_mo
  * @param ktf_ptr 陷入帧, S模式下中断触发后在`ktrap_enter`中构建
  * @return int64_t 处理结果, 若为0则表示处理正常, -1表示处理失败
  * 
- * @note 目前所有中断都是CPU0处理的, 未来多核设计的时候需要修改一个版本
+ * @note 只读取当前`CPU`的S模式上下文的中断请求寄存器, 通过注册表以O(1)的时间找到处理函数
+ * @note 处理每个中断期间将优先级阈值提高到该中断的优先级, 优先级更高的中断可以打断处理函数
  */
 int64_t kplic_interrupt_handler(ktrapframe_t *ktf_ptr);
 
@@ -0,0 +1,105 @@
+/**
+ * @file ksmp.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `ksmp.h`是内核的多核(SMP)启动模块
+ * @version 0.1
+ * @date 2023-06-10
+ *
+ * @note 多核启动流程:
+ *  1. 所有的`HART`进入`SBI`, `HART0`跳转到内核, 其余`HART`在`SBI`中挂起
+ *  2. `HART0`初始化内核后调用`smp_boot_secondary`, 依次等待设备树中存在的`HART`在`SBI`中进入`STOPPED`状态, 再通过`SBICALL_HART_START`调用启动
+ *  3. 被启动的`HART`从`kernel_secondary_start`(定义在`kboot.S`中)进入内核, 设置自己的栈后运行`kernel_secondary_main`
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KSMP_H
+#define __INCLUDE_KERNEL_KSMP_H
+
+#include "types.h"
+#include "constrains.h"
+#include "kernel/percpu.h"
+#include "trap/trapframe.h"
+
+
+/// 当前`CPU`的编号, 即当前`HART`的`mhartid`, 由`percpu_init_hart`设置
+DECLARE_PER_CPU(uint64_t, cpu_number);
+
+
+/**
+ * @brief `cpu_id`用于获取当前`CPU`的编号, 即当前`HART`的`mhartid`
+ */
+static inline uint64_t cpu_id(void){
+    return this_cpu_read(cpu_number);
+}
+
+
+/// 已经进入内核的`CPU`, 每个`CPU`一位, 定义在`ksmp.c`中
+extern uint64_t volatile cpu_online_mask;
+
+
+/**
+ * @brief `ipi_type_t`是核间中断的类型, 同时发送的多种类型的核间中断只会触发一次中断
+ */
+typedef enum __ipi_type_t {
+    /// `TLB`击落请求, 见`ktlb.h`
+    IPI_TLB_SHOOTDOWN = 0,
+    /// 核间中断类型的数量
+    IPI_TYPE_NUM
+} ipi_type_t;
+
+
+/**
+ * @brief `kernel_secondary_start`是`HART0`之外的`HART`进入内核的入口, 定义在`kboot.S`中
+ */
+extern void kernel_secondary_start(void);
+
+
+/**
+ * @brief `smp_init`从设备树中读取存在的`HART`, 需要在`paging_init`之前调用
+ * 
+ * @param dtb 设备树的地址
+ */
+void smp_init(addr_t dtb);
+
+
+/**
+ * @brief `smp_boot_secondary`由`HART0`在内核初始化完成后调用, 依次启动其余的`HART`, 并等待其进入内核
+ * 
+ * @note 设备树中不存在的`HART`会被跳过; 存在的`HART`会等待其在`SBI`中进入`STOPPED`状态后再启动,
+ *  超过`KSMP_BOOT_TIMEOUT_MS`仍未进入的`HART`会被跳过; 启动后超过`KSMP_BOOT_TIMEOUT_MS`仍未进入内核的`HART`被报告为启动失败
+ */
+void smp_boot_secondary(void);
+
+
+/**
+ * @brief `smp_send_ipi`向`cpu_mask`中的`CPU`发送`type`类型的核间中断
+ *
+ * @param cpu_mask 目标`CPU`的掩码, 第`i`位表示`CPUi`
+ * @param type 核间中断的类型
+ *
+ * @note 所有目标`CPU`通过一次`SBI`调用发送, 目标`CPU`在S模式软件中断中处理
+ */
+void smp_send_ipi(uint64_t cpu_mask, ipi_type_t type);
+
+
+/**
+ * @brief `smp_ipi_handler`是S模式软件中断的处理函数, 处理发给当前`CPU`的所有核间中断
+ *
+ * @param ktf_ptr 陷入帧
+ * @return int64_t 处理结果, 总是0
+ */
+int64_t smp_ipi_handler(ktrapframe_t *ktf_ptr);
+
+
+/**
+ * @brief `kernel_secondary_main`是`HART0`之外的`HART`的内核主函数
+ *
+ * @param hartid 当前`HART`的编号
+ *
+ * @note 内核的全局数据结构已经由`HART0`初始化, 这里只需要初始化每个`HART`独有的寄存器
+ */
+NO_RETURN void kernel_secondary_main(uint64_t hartid);
+
+
+#endif
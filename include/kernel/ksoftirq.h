@@ -0,0 +1,77 @@
+/**
+ * @file ksoftirq.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `ksoftirq.h`提供了每个`CPU`一份的推迟工作(tasklet)机制
+ * @version 0.1
+ * @date 2023-06-16
+ *
+ * @note 外部中断的处理函数只做必须立即完成的工作(应答设备, 读出数据), 其余工作放入tasklet, 由`ksoftirq_run`在打开中断的情况下运行.
+ *      `ksoftirq_run`在两个地方调用:
+ *  - 最外层的中断返回前, 见`ktrap.c`
+ *  - `CPU`空闲时, 即`wfi`之前
+ *
+ * @note 每次运行最多运行`KSOFTIRQ_BUDGET`个tasklet, 剩下的tasklet留在队列中等到下一次运行, 因此一次中断返回的延迟是有界的
+ * @note 已经在队列中的tasklet再次调度时不会重复加入, 因此突发的中断只运行一次tasklet, tasklet需要一次处理完所有积累的数据
+ *
+ * 举例:
+ * ```c
+ * static void rx_work(ktasklet_t *tasklet);
+ * static ktasklet_t rx_tasklet = KTASKLET_INIT("uart rx", rx_work);
+ * // 外部中断处理函数中
+ * ktasklet_schedule(&rx_tasklet);
+ * ```
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KSOFTIRQ_H
+#define __INCLUDE_KERNEL_KSOFTIRQ_H
+
+#include "types.h"
+#include "constrains.h"
+
+
+/**
+ * @brief `ktasklet_t`是一个推迟运行的工作
+ */
+typedef struct __ktasklet_t {
+    /// @brief 队列中的下一个tasklet
+    struct __ktasklet_t *next;
+    /// @brief tasklet的工作函数, 运行时中断是打开的
+    void (*func)(struct __ktasklet_t *tasklet);
+    /// @brief tasklet是否已经在某个`CPU`的队列中
+    uint64_t volatile pending;
+    /// @brief tasklet的名字
+    const char *name;
+} ktasklet_t;
+
+/// 静态初始化tasklet
+#define KTASKLET_INIT(tasklet_name, tasklet_func)   {.next = NULL, .func = (tasklet_func), .pending = 0, .name = (tasklet_name)}
+
+
+/**
+ * @brief `ksoftirq_init`用于初始化推迟工作机制, 注册统计计数器
+ */
+void ksoftirq_init(void);
+
+
+/**
+ * @brief `ktasklet_schedule`将`tasklet`加入当前`CPU`的队列
+ *
+ * @param tasklet 需要运行的tasklet
+ *
+ * @note tasklet已经在队列中时不会重复加入. 运行之前会先从队列中取下, 因此工作函数可以重新调度自己以处理剩下的工作
+ * @note 同一个tasklet可能同时在不同的`CPU`上运行, 工作函数需要自行加锁
+ */
+void ktasklet_schedule(ktasklet_t *tasklet);
+
+
+/**
+ * @brief `ksoftirq_run`用于运行当前`CPU`队列中的tasklet, 最多运行`KSOFTIRQ_BUDGET`个
+ *
+ * @note 可以在中断中调用, 运行tasklet时打开中断, 返回时恢复调用之前的中断状态. 同一个`CPU`上不会嵌套运行
+ */
+void ksoftirq_run(void);
+
+
+#endif
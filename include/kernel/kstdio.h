@@ -62,7 +62,7 @@
  * 
  * @warning `kprintf`函数仅供内核使用, 用户程序请使用`uprintf`函数
  * 
- * @warning 目前`kprintf`最终向`uart`输出字符串
+ * @warning `kprintf`以`KLOG_INFO`等级写入内核日志缓冲区, 异步模式下由时钟中断输出到`uart`, 详见`kernel/klog.h`
  */
 size_t kprintf(const char* format, ...);
 
@@ -20,6 +20,19 @@
 #include "kernel/ktrap.h"
 
 
+/**
+ * @brief `ktime_t`是内核时间的快照, 在时钟中断中更新
+ */
+typedef struct __ktime_t {
+    /// @brief 启动后时钟中断的次数
+    uint64_t ticks;
+    /// @brief 更新快照时的时钟周期数
+    uint64_t cycle;
+    /// @brief 更新快照时的墙上时间, 单位为纳秒. 没有设置墙上时间时为启动后经过的时间
+    uint64_t wall_ns;
+} ktime_t;
+
+
 #if RDTIME_SUPPORT == 1
 /**
  * @brief `get_cycle`函数将通过`rdtime`指令以获取系统当前的时钟周期数
@@ -61,18 +74,62 @@ static inline uint64_t get_cycle(void){
  *  当`mtime`寄存器的值大于`mtimecmp`寄存器的值之后, 就会通知当前HART发生了一个时钟中断.
  *  因此, `reset_timer`寄存器其实就是重新设置`mtimecmp`寄存器的值
  * 
+ * @note 支持`Sstc`扩展时直接写`stimecmp`寄存器, 不再经过`SBI`调用和M模式的时钟中断, 否则通过`sbi_settimer`设置`mtimecmp`
+ * 
  * @note 假设驱动`mtime`的时钟频率是10GHz（目前还没有哪个CPU主频能到10GHz的吧），那么要让64位的mtime溢出，那么需要
  *  `0x10000000000000000 / 10000000000 / 60 / 60 / 24 / 365`年，也就是58年。
  *  `HiFive1`开发板驱动`mtime`的时钟频率是`32768Hz`，那么需要17851025年`mtime`才会溢出
  */
 void reset_timer(void);
 
-/// @brief `ktimer_init`是时钟的初始化函数
-void ktimer_init(void);
+/**
+ * @brief `ktimer_init`是时钟的初始化函数, 由`HART0`调用, 根据设备树判断是否支持`Sstc`扩展, 初始化时间快照并启动`HART0`的时钟
+ *
+ * @param dtb 设备树的地址, 需要在`memory_init`之前调用
+ */
+void ktimer_init(addr_t dtb);
+
+
+/**
+ * @brief `ktimer_init_hart`用于启动当前`HART`的时钟中断, `HART0`之外的`HART`启动时调用
+ *
+ * @note 每个`HART`都有自己的`mtimecmp`寄存器, 因此每个`HART`的时钟中断是独立的
+ */
+void ktimer_init_hart(void);
+
+
+/**
+ * @brief `ktimer_get_ticks`用于获取启动后时钟中断的次数
+ *
+ * @return uint64_t 时钟中断的次数
+ *
+ * @note 使用顺序锁读取, 不获取锁也不关中断, 可以在任意`CPU`上频繁调用
+ */
+uint64_t ktimer_get_ticks(void);
+
+
+/**
+ * @brief `ktimer_get_time`用于获取当前的内核时间
+ *
+ * @param time 保存内核时间, 其中`cycle`为当前的时钟周期数, `wall_ns`为根据快照和当前时钟周期数计算的当前墙上时间
+ *
+ * @note 使用顺序锁读取, 不获取锁也不关中断, 可以在任意`CPU`上频繁调用
+ */
+void ktimer_get_time(ktime_t *time);
+
+
+/**
+ * @brief `ktimer_set_wallclock`用于设置当前的墙上时间
+ *
+ * @param wall_ns 当前的墙上时间, 例如从1970年1月1日起经过的纳秒数
+ */
+void ktimer_set_wallclock(uint64_t wall_ns);
 
 /**
  * @brief `ktimer_interrupt_handler`是S模式下的时钟中断处理函数
  * 
+ * @note 每个`HART`都会运行时钟中断, 但是只有`KTIMER_TIMEKEEPER_CPU`更新时间快照, 避免多个`CPU`竞争顺序锁
+ * 
  * @param ktf_ptr 陷入帧, S模式下中断触发后在`ktrap_enter`中构建
  * @return int64_t 处理结果, 若为0则表示处理正常, -1表示处理失败
  */
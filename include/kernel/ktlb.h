@@ -0,0 +1,107 @@
+/**
+ * @file ktlb.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `ktlb.h`提供了多核的`TLB`击落(shootdown)
+ * @version 0.1
+ * @date 2023-06-12
+ *
+ * @note 修改页表后, 其他`CPU`的`TLB`中可能还缓存着旧的表项, 需要通知其他`CPU`刷新. 逐页发送核间中断的开销太大,
+ *      因此先将需要刷新的地址范围加入`ktlb_batch_t`中, 最后调用`ktlb_batch_flush`一次性刷新: 每个目标`CPU`只收到一次核间中断, 并刷新整个批次
+ *
+ * 举例:
+ * ```c
+ * ktlb_batch_t batch;
+ * ktlb_batch_init(&batch);
+ * // 修改页表
+ * ktlb_batch_add(&batch, vaddr, PAGE_SIZE);
+ * ...
+ * ktlb_batch_flush(&batch);
+ * ```
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KTLB_H
+#define __INCLUDE_KERNEL_KTLB_H
+
+#include "types.h"
+#include "constrains.h"
+
+
+/**
+ * @brief `ktlb_range_t`是需要刷新的一段虚拟地址范围
+ */
+typedef struct __ktlb_range_t {
+    /// @brief 起始虚拟地址, 页对齐
+    addr_t start;
+    /// @brief 字节数, 页对齐
+    uint64_t size;
+} ktlb_range_t;
+
+
+/**
+ * @brief `ktlb_batch_t`是一批需要刷新的虚拟地址范围
+ */
+typedef struct __ktlb_batch_t {
+    /// @brief 地址范围的数量
+    uint64_t nr;
+    /// @brief 地址范围的总页数
+    uint64_t pages;
+    /// @brief 为`True`时刷新整个`TLB`, 地址范围超过`KTLB_BATCH_RANGES`个或者总页数超过`TLB_FLUSH_ALL_THRESHOLD`时设置
+    Bool full;
+    /// @brief 地址范围
+    ktlb_range_t ranges[KTLB_BATCH_RANGES];
+} ktlb_batch_t;
+
+
+/**
+ * @brief `ktlb_batch_init`用于初始化一个空的批次
+ *
+ * @param batch 批次
+ */
+void ktlb_batch_init(ktlb_batch_t *batch);
+
+
+/**
+ * @brief `ktlb_batch_add`将`[start, start + size)`加入批次中, 与上一个地址范围相邻时合并
+ *
+ * @param batch 批次
+ * @param start 起始虚拟地址
+ * @param size 字节数
+ */
+void ktlb_batch_add(ktlb_batch_t *batch, addr_t start, uint64_t size);
+
+
+/**
+ * @brief `ktlb_batch_flush`在所有在线的`CPU`上刷新批次中的地址范围, 所有`CPU`完成后返回, 而后清空批次
+ *
+ * @param batch 批次
+ *
+ * @note 等待期间关闭中断, 并主动处理其他`CPU`发给当前`CPU`的击落请求, 因此多个`CPU`同时击落不会死锁
+ * @warning 不能在持有自旋锁或者读写锁时调用: 其他`CPU`可能关中断等待该锁, 无法响应核间中断
+ */
+void ktlb_batch_flush(ktlb_batch_t *batch);
+
+
+/**
+ * @brief `ktlb_flush_range`在所有在线的`CPU`上刷新`[start, start + size)`, 相当于只有一个地址范围的批次
+ *
+ * @param start 起始虚拟地址
+ * @param size 字节数
+ */
+void ktlb_flush_range(addr_t start, uint64_t size);
+
+
+/**
+ * @brief `ktlb_flush_all`在所有在线的`CPU`上刷新整个`TLB`
+ */
+void ktlb_flush_all(void);
+
+
+/**
+ * @brief `ktlb_handle_ipi`处理其他`CPU`发给当前`CPU`的击落请求, 在`IPI_TLB_SHOOTDOWN`核间中断中调用
+ */
+void ktlb_handle_ipi(void);
+
+
+#endif
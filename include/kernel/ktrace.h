@@ -0,0 +1,118 @@
+/**
+ * @file ktrace.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `ktrace.h`提供了内核的二进制跟踪点(tracepoint)
+ * @version 0.1
+ * @date 2023-06-06
+ *
+ * @note 跟踪点只记录格式字符串的地址和至多4个64位参数, 不在内核中进行格式化, 因此可以在中断处理函数, `create_mapping`等热点路径中使用.
+ *      格式字符串保存在`.rodata.ktrace`段中, 链接后位于内核`.rodata`段内, 其地址即为格式字符串的ID
+ *
+ * @note 使用`ktrace_dump`以十六进制文本的方式输出跟踪缓冲区, 保存串口输出后使用`scripts/ktrace_decode.py`脚本结合内核的ELF文件(`build/os.elf`)解码:
+ * ```bash
+ * python3 scripts/ktrace_decode.py build/os.elf console.log
+ * ```
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_KTRACE_H
+#define __INCLUDE_KERNEL_KTRACE_H
+
+#include "types.h"
+#include "constrains.h"
+
+
+/**
+ * @brief `ktrace_event_t`是一个跟踪事件, 64字节, 与缓存行对齐
+ *
+ * @note `sequence`在写入事件前被清零, 写入完成后设置为事件的序号加1, 输出时据此跳过正在写入的事件
+ */
+typedef struct __ktrace_event_t {
+    /// @brief 事件的序号加1, 为0时表示事件正在写入
+    uint64_t volatile sequence;
+    /// @brief 事件发生时的时钟周期数
+    uint64_t timestamp;
+    /// @brief 格式字符串, 其地址即为格式字符串的ID
+    const char *fmt;
+    /// @brief 事件的参数
+    uint64_t args[4];
+    /// @brief 保留, 用于对齐
+    uint64_t reserved;
+} ALIGN64 ktrace_event_t;
+
+
+/**
+ * @brief `ktrace_ring_t`是每个`CPU`的跟踪缓冲区, 缓冲区满后覆盖最早的事件
+ */
+typedef struct __ktrace_ring_t {
+    /// @brief 下一个事件的序号
+    uint64_t volatile head;
+    /// @brief 跟踪事件
+    ktrace_event_t events[KTRACE_RING_EVENTS];
+} ktrace_ring_t;
+
+
+/**
+ * @brief `ktrace_record`用于向当前`CPU`的跟踪缓冲区记录一个事件, 请使用`KTRACE`宏而不是直接调用该函数
+ *
+ * @param fmt 格式字符串, 需要位于`.rodata`段中
+ * @param a0 第一个参数
+ * @param a1 第二个参数
+ * @param a2 第三个参数
+ * @param a3 第四个参数
+ */
+void ktrace_record(const char *fmt, uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3);
+
+
+/**
+ * @brief `ktrace_set_enable`用于在运行时打开/关闭跟踪
+ *
+ * @param enable True, 打开; False, 关闭
+ */
+void ktrace_set_enable(Bool enable);
+
+
+/**
+ * @brief `ktrace_dump`用于以十六进制文本的方式将所有`CPU`的跟踪缓冲区输出到控制台
+ *
+ * @note 输出的格式为:
+ * ```
+ * KTRACE BEGIN <时钟频率>
+ * KT <cpu> <序号> <时钟周期数> <格式字符串地址> <参数0> <参数1> <参数2> <参数3>
+ * ...
+ * KTRACE END
+ * ```
+ * 所有数字均为十六进制, 解码请使用`scripts/ktrace_decode.py`
+ *
+ * @note 输出期间跟踪将被暂时关闭; 已经有`CPU`正在输出时直接返回
+ */
+void ktrace_dump(void);
+
+
+#if KTRACE_ENABLE == 1
+/**
+ * @brief `KTRACE`宏用于记录一个跟踪事件
+ *
+ * @param fmt 格式字符串, 必须是字符串常量, 支持`stdfmt`中的格式控制字符, `%s`对应的参数需要是`.rodata`段中的字符串
+ * @param ... 至多4个整数/指针参数, 均将被转换为`uint64_t`
+ *
+ * 举例:
+ * ```c
+ * KTRACE("map vpage %#lx to ppage %#lx", vaddr, paddr);
+ * ```
+ */
+#define KTRACE(fmt, ...)                                                                        \
+    do {                                                                                        \
+        static const char __ktrace_fmt[] __attribute__((section(".rodata.ktrace"))) = fmt;      \
+        _KTRACE_RECORD(__ktrace_fmt, ##__VA_ARGS__, 0, 0, 0, 0);                                \
+    } while (0)
+
+#define _KTRACE_RECORD(fmt, a0, a1, a2, a3, ...)                                                \
+    ktrace_record(fmt, (uint64_t)(a0), (uint64_t)(a1), (uint64_t)(a2), (uint64_t)(a3))
+#else
+#define KTRACE(fmt, ...) ((void) 0)
+#endif
+
+
+#endif
@@ -14,6 +14,7 @@
 #include "types.h"
 #include "asm/csr.h"
 #include "constrains.h"
+#include "kernel/percpu.h"
 #include "trap/trapframe.h"
 #include "trap/trap_entry.h"
 
@@ -45,6 +46,61 @@ static inline void supervisor_interrupt_disable(void){
     clear_csr(sstatus, SSTATUS_SIE);
 }
 
+/**
+ * @brief `supervisor_interrupt_save`用于关闭S模式下的中断, 并返回关闭之前中断是否是打开的
+ *
+ * @return Bool 关闭之前`sstatus`寄存器的`SIE`位
+ */
+static inline Bool supervisor_interrupt_save(void){
+    return (read_clear_csr(sstatus, SSTATUS_SIE) & SSTATUS_SIE) != 0;
+}
+
+/**
+ * @brief `supervisor_interrupt_restore`用于恢复`supervisor_interrupt_save`之前的S模式中断状态
+ *
+ * @param enabled `supervisor_interrupt_save`的返回值
+ */
+static inline void supervisor_interrupt_restore(Bool enabled){
+    if (enabled)
+        supervisor_interrupt_enable();
+}
+
+/**
+ * @brief `kirq_stack_t`是每个`HART`的中断栈
+ *
+ * @note 中断的快速入口在`nesting`为0时切换到`top`, 嵌套的中断已经位于中断栈上, 不再切换. 布局需要和`tfoffset.h`中的`KIRQ_STACK_*`保持一致
+ */
+typedef struct __kirq_stack_t {
+    /// @brief 当前`HART`上正在处理的中断的嵌套深度
+    uint64_t nesting;
+    /// @brief 中断栈的栈顶
+    addr_t top;
+    /// @brief 中断栈的栈底, 保存`KIRQ_STACK_CANARY`, 用于检查中断栈溢出
+    addr_t bottom;
+} kirq_stack_t;
+
+/// 写在中断栈栈底的值, 被覆盖说明中断栈已经溢出
+#define KIRQ_STACK_CANARY   0x4B495251535441CBUL
+
+_Static_assert(__builtin_offsetof(kirq_stack_t, nesting) == KIRQ_STACK_NESTING, "kirq_stack_t does not match KIRQ_STACK_NESTING");
+_Static_assert(__builtin_offsetof(kirq_stack_t, top) == KIRQ_STACK_TOP, "kirq_stack_t does not match KIRQ_STACK_TOP");
+
+/// 每个`HART`的中断栈, 定义在`ktrap.c`中
+DECLARE_PER_CPU(kirq_stack_t, ktrap_irq_stack);
+
+
+/**
+ * @brief `in_interrupt`用于判断当前`CPU`是否正在处理中断
+ *
+ * @return Bool 正在处理中断时返回True
+ *
+ * @note 只统计经过快速入口的中断, 即S模式的软件中断, 时钟中断和外部中断
+ */
+static inline Bool in_interrupt(void){
+    return this_cpu_read(ktrap_irq_stack).nesting != 0;
+}
+
+
 /**
  * @brief `ktrap_init`是内核的异常/中断初始化函数, 主要:
  *      1. 设置了`sstvec`寄存器
@@ -54,6 +110,14 @@ static inline void supervisor_interrupt_disable(void){
 void ktrap_init(void);
 
 
+/**
+ * @brief `ktrap_init_hart`用于设置当前`HART`的`sscratch`, `stvec`和`sie`寄存器
+ *
+ * @note 异常/中断处理函数表是所有`HART`共享的, 只需要`HART0`在`ktrap_init`中初始化一次, 其余`HART`启动时只需要调用`ktrap_init_hart`
+ */
+void ktrap_init_hart(void);
+
+
 /**
  * @brief `ktrap_dispatcher`是通用异常/中断处理函数, 将会根据`scause`寄存器的值运行不同的中断处理函数
  * 
@@ -62,6 +126,43 @@ void ktrap_init(void);
 void ktrap_dispatcher(ktrapframe_t *ktf_ptr);
 
 
+/**
+ * @brief `ktrap_stat_dump`用于输出内核中每个`CPU`每个中断/异常的次数和处理时间, 时间以`get_cycle`的时钟周期为单位
+ * 
+ * @note 快速入口的中断同样统计在内. 外部中断的处理时间包含嵌套的中断, 不包含中断返回前运行的推迟工作
+ */
+void ktrap_stat_dump(void);
+
+
+/**
+ * @brief `ktrap_fast_software`由软件中断的快速入口`ktrap_fast_software_enter`调用, 不查处理函数表, 直接调用`smp_ipi_handler`
+ * 
+ * @param ktf_ptr 部分陷入帧, 在`ktrap_fast_software_enter`中构建
+ */
+void ktrap_fast_software(ktrapframe_t *ktf_ptr);
+
+
+/**
+ * @brief `ktrap_fast_timer`由时钟中断的快速入口`ktrap_fast_timer_enter`调用, 不查处理函数表, 直接调用`ktimer_interrupt_handler`
+ * 
+ * @param ktf_ptr 只保存了调用者保存的寄存器以及`sstatus`和`sepc`的陷入帧, 在`ktrap_fast_timer_enter`中构建
+ * 
+ * @note 从用户态陷入的时钟中断仍然经过`ktrap_dispatcher`, 因此处理函数表中的时钟中断处理函数需要和这里保持一致
+ * @note 时钟中断的优先级最高, 处理期间不打开中断, 因此不会被其他中断打断
+ */
+void ktrap_fast_timer(ktrapframe_t *ktf_ptr);
+
+
+/**
+ * @brief `ktrap_fast_external`由外部中断的快速入口`ktrap_fast_external_enter`调用, 不查处理函数表, 直接调用`kirq_interrupt_handler`
+ * 
+ * @param ktf_ptr 只保存了调用者保存的寄存器以及`sstatus`和`sepc`的陷入帧, 在`ktrap_fast_external_enter`中构建
+ * 
+ * @note 外部中断的优先级最低, 设备的处理函数运行时打开中断, 时钟中断, 软件中断以及优先级更高的外部中断可以打断, 见`kirq_dispatch`
+ */
+void ktrap_fast_external(ktrapframe_t *ktf_ptr);
+
+
 /**
  * @brief `register_ktrap_handler`是`SBI`异常/中断注册函数, 用于将编号为`trap_code`的异常/中断的处理函数`ktrap_func`注册到`SBI`的异常/中断处理函数表中
  * 
@@ -2,15 +2,27 @@
  * @file locks.h
  * @author Shihong Wang (jack4shihong@gmail.com)
  * @brief `locks.h`为操作系统提供了锁的实现
- * @version 0.1
+ * @version 0.2
  * @date 2023-05-15
- * 
+ *
  * @note 目前版本的自旋锁/互斥锁未来需要改成信号量
- * 
- * @warning 可能存在bug, 需要在完成内核线程后进行测试
- * 
+ *
+ * @note 提供了两种自旋锁:
+ *  - `spinlock_t`: 排号自旋锁(ticket lock), 按照申请的顺序获得锁, 是公平的. 所有等待者自旋在同一个变量上, 适用于一般的锁
+ *  - `mcslock_t`: MCS队列锁, 每个等待者自旋在自己的队列节点上, 释放锁时只有下一个等待者的缓存行失效, 适用于竞争激烈的锁
+ *
+ * @note 对于读多写少的数据, 提供了顺序锁`seqlock_t`: 读者不获取锁也不关中断, 只读取序号, 与写者冲突时重新读取
+ *
+ * @note 对于读者需要持有数据一段时间的情况(例如遍历页表), 提供了公平的读写锁`rwlock_t`: 读者之间可以并行, 写者之间以及写者和读者之间互斥
+ *
+ * @note 打开`constrains.h`中的`LOCKSTAT_ENABLE`后, 每个锁都会统计获取次数, 竞争次数, 等待和持有的`cycle`时钟周期数(cycles),
+ *      使用`lockstat_register`注册的锁可以使用`lockstat_dump`按照等待时间从多到少输出
+ *
+ * @note 获取锁时会关闭中断以避免死锁, 关中断是可以嵌套的: 只有最外层的锁被释放后才会恢复获取第一个锁之前的中断状态.
+ *      也可以使用`spinlock_acquire_irqsave`/`spinlock_release_irqrestore`显式地保存/恢复中断状态
+ *
  * @todo 实现信号量
- * 
+ *
  * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
  */
 
@@ -18,23 +30,134 @@
 #define __INCLUDE_KERNEL_LOCKS_H
 
 #include "types.h"
+#include "constrains.h"
+
+
+/**
+ * @brief `lockstat_t`是锁的竞争统计信息, 只在`LOCKSTAT_ENABLE = 1`时包含在锁中
+ *
+ * @note 时间均以`rdcycle`读取的`cycle`寄存器的时钟周期为单位, `SBI`在每个`HART`上设置了`mcounteren.CY`. 统计信息只在持有锁时修改, 因此不需要原子操作
+ */
+typedef struct __lockstat_t {
+    /// @brief 获取锁的次数
+    uint64_t acquisitions;
+    /// @brief 获取锁时锁已经被持有的次数
+    uint64_t contended;
+    /// @brief 等待锁的总时钟周期数
+    uint64_t wait_total;
+    /// @brief 等待锁的最大时钟周期数
+    uint64_t wait_max;
+    /// @brief 持有锁的总时钟周期数
+    uint64_t hold_total;
+    /// @brief 持有锁的最大时钟周期数
+    uint64_t hold_max;
+    /// @brief 本次获得锁时的时钟周期数
+    uint64_t hold_start;
+    /// @brief 锁的名字
+    const char *name;
+    /// @brief 是否已经加入统计列表, 由`lockstat_register`加入
+    uint64_t volatile registered;
+} lockstat_t;
+
 
 /**
  * @brief `spinlock_t`是自旋锁类型, 是互斥锁的一种, 用于保证变量的唯一访问
- * 
+ *
+ * @note 自旋锁是排号锁: 获取锁时领取一个号码(`next`), 等到叫号(`owner`)等于自己的号码时获得锁, 释放锁时叫下一个号.
+ *      因此等待者按照申请的顺序获得锁, 不会出现某个`CPU`一直获取不到锁的情况
+ *
  * @note 目前版本的自旋锁会浪费CPU, 未来实现信号量之后需要修改为信号量让当前线程主动让出CPU
 */
 typedef struct __spinlock_t {
-    /// @brief `locked`用于表示自旋锁是否被持有
-    Bool locked;
+    /// @brief 下一个等待者领取的号码
+    uint64_t volatile next;
+    /// @brief 当前持有锁的号码
+    uint64_t volatile owner;
     /// @brief 自旋锁的名字
     char *name;
+#if LOCKSTAT_ENABLE == 1
+    /// @brief 竞争统计信息
+    lockstat_t stat;
+#endif
 } spinlock_t;
 
 
+/**
+ * @brief `mcs_node_t`是MCS锁的队列节点, 每个等待者一个, 通常分配在等待者的栈上
+ */
+typedef struct __mcs_node_t {
+    /// @brief 队列中的下一个等待者
+    struct __mcs_node_t * volatile next;
+    /// @brief 为True时表示需要继续等待, 前一个等待者释放锁时将其设置为False
+    uint64_t volatile waiting;
+} mcs_node_t;
+
+
+/**
+ * @brief `mcslock_t`是MCS队列锁类型
+ *
+ * @note 等待者组成一个链表, `tail`指向最后一个等待者, 每个等待者只在自己的节点上自旋
+ */
+typedef struct __mcslock_t {
+    /// @brief 最后一个等待者的节点, 为NULL时表示锁是空闲的
+    mcs_node_t * volatile tail;
+    /// @brief 锁的名字
+    char *name;
+#if LOCKSTAT_ENABLE == 1
+    /// @brief 竞争统计信息
+    lockstat_t stat;
+#endif
+} mcslock_t;
+
+
+/**
+ * @brief `seqlock_t`是顺序锁类型, 用于读多写少的数据
+ *
+ * @note 写者之间使用自旋锁互斥, 写入前后各将`sequence`加1, 因此`sequence`为奇数时表示正在写入.
+ *      读者读取数据前后各读取一次`sequence`, 两次相同且为偶数时读取的数据才是一致的, 否则重新读取.
+ *      读者不写入任何共享变量, 因此多个`CPU`同时读取时不会导致缓存行在`CPU`之间来回传递
+ *
+ * 举例:
+ * ```c
+ * uint64_t seq;
+ * do {
+ *     seq = seqlock_read_begin(&lock);
+ *     copy = data;
+ * } while (seqlock_read_retry(&lock, seq));
+ * ```
+ */
+typedef struct __seqlock_t {
+    /// @brief 序号, 为奇数时表示写者正在写入
+    uint64_t volatile sequence;
+    /// @brief 写者之间互斥的锁
+    spinlock_t lock;
+} seqlock_t;
+
+
+/**
+ * @brief `rwlock_t`是公平的读写锁类型, 基于排号锁实现
+ *
+ * @note 读者和写者都领取号码(`next`), 按照领取的顺序获得锁:
+ *  - 读者等到`read_owner`等于自己的号码时获得锁, 并立即将`read_owner`加1, 因此连续的读者可以同时持有锁. 释放时将`write_owner`加1
+ *  - 写者等到`write_owner`等于自己的号码时获得锁, 即之前的读者和写者都已经释放了锁. 释放时将`read_owner`和`write_owner`都加1
+ *
+ * @note 后到的读者不会越过正在等待的写者, 因此写者不会饿死
+ */
+typedef struct __rwlock_t {
+    /// @brief 下一个等待者领取的号码
+    uint64_t volatile next;
+    /// @brief 号码等于`read_owner`的读者可以获得锁
+    uint64_t volatile read_owner;
+    /// @brief 号码等于`write_owner`的写者可以获得锁
+    uint64_t volatile write_owner;
+    /// @brief 读写锁的名字
+    char *name;
+} rwlock_t;
+
+
 /**
  * @brief `spinlock_init`用于初始化自旋锁`lock`
- * 
+ *
  * @param lock 需要被初始化的自旋锁
  * @param name 自旋锁的名字
  */
@@ -43,22 +166,228 @@ void spinlock_init(spinlock_t *lock, char *name);
 
 /**
  * @brief `spinlock_acquire`用于获得自旋锁`lock`, 若未能获得自旋锁, 则当前线程将循环在此
- * 
+ *
  * @param lock 需要获取的自旋锁
- * 
- * @note 目前版本使用`GCC`内置的`__sync_lock_test_and_set`获取锁, 避免手写`LR/SC`指令
+ *
+ * @note 获取锁之前会关闭中断, 可以嵌套获取多个锁
  */
 void spinlock_acquire(spinlock_t *lock);
 
 
 /**
  * @brief `spinlock_release`用于释放自旋锁`lock`
- * 
+ *
  * @param lock 需要释放的自旋锁
- * 
- * @note 目前版本的使用`GCC`内置的`__sync_lock_release`释放锁, 避免手写`LR/SC`指令
+ *
+ * @note 只有释放最外层的锁时才会恢复获取第一个锁之前的中断状态, 因此在中断处理函数中释放锁不会打开中断
  */
 void spinlock_release(spinlock_t *lock);
 
 
-#endif
\ No newline at end of file
+/**
+ * @brief `spinlock_acquire_irqsave`用于关闭中断并获得自旋锁`lock`
+ *
+ * @param lock 需要获取的自旋锁
+ * @return Bool 获取锁之前`sstatus`寄存器的`SIE`位, 需要传给`spinlock_release_irqrestore`
+ */
+Bool spinlock_acquire_irqsave(spinlock_t *lock);
+
+
+/**
+ * @brief `spinlock_release_irqrestore`用于释放自旋锁`lock`并恢复获取锁之前的中断状态
+ *
+ * @param lock 需要释放的自旋锁
+ * @param enabled `spinlock_acquire_irqsave`的返回值
+ */
+void spinlock_release_irqrestore(spinlock_t *lock, Bool enabled);
+
+
+/**
+ * @brief `spinlock_holding`用于判断自旋锁`lock`是否被持有
+ *
+ * @param lock 需要判断的自旋锁
+ * @return Bool 被持有时返回True
+ */
+Bool spinlock_holding(spinlock_t *lock);
+
+
+/**
+ * @brief `mcslock_init`用于初始化MCS锁`lock`
+ *
+ * @param lock 需要被初始化的MCS锁
+ * @param name MCS锁的名字
+ */
+void mcslock_init(mcslock_t *lock, char *name);
+
+
+/**
+ * @brief `mcslock_acquire`用于获得MCS锁`lock`, 若未能获得锁, 则在`node`上自旋
+ *
+ * @param lock 需要获取的MCS锁
+ * @param node 当前等待者的队列节点, 在释放锁之前不能被释放
+ *
+ * @note 与`spinlock_acquire`一样会关闭中断, 可以嵌套
+ */
+void mcslock_acquire(mcslock_t *lock, mcs_node_t *node);
+
+
+/**
+ * @brief `mcslock_release`用于释放MCS锁`lock`, 并将锁交给下一个等待者
+ *
+ * @param lock 需要释放的MCS锁
+ * @param node 获取锁时使用的队列节点
+ */
+void mcslock_release(mcslock_t *lock, mcs_node_t *node);
+
+
+/**
+ * @brief `rwlock_init`用于初始化读写锁`lock`
+ *
+ * @param lock 需要被初始化的读写锁
+ * @param name 读写锁的名字
+ */
+void rwlock_init(rwlock_t *lock, char *name);
+
+
+/**
+ * @brief `rwlock_read_acquire`用于获得读写锁`lock`的读锁, 多个读者可以同时持有读锁
+ *
+ * @param lock 需要获取的读写锁
+ *
+ * @note 与`spinlock_acquire`一样会关闭中断, 可以嵌套
+ */
+void rwlock_read_acquire(rwlock_t *lock);
+
+
+/**
+ * @brief `rwlock_try_read_acquire`用于尝试获得读写锁`lock`的读锁, 不会等待
+ *
+ * @param lock 需要获取的读写锁
+ * @return Bool 获得读锁时返回True. 有写者持有锁或者正在等待时返回False
+ *
+ * @note 用于异常处理函数等不能等待的地方, 例如发生异常时当前`CPU`可能正持有写锁
+ */
+Bool rwlock_try_read_acquire(rwlock_t *lock);
+
+
+/**
+ * @brief `rwlock_read_release`用于释放读写锁`lock`的读锁
+ *
+ * @param lock 需要释放的读写锁
+ */
+void rwlock_read_release(rwlock_t *lock);
+
+
+/**
+ * @brief `rwlock_write_acquire`用于获得读写锁`lock`的写锁, 同一时刻只有一个写者可以持有写锁, 且没有读者持有读锁
+ *
+ * @param lock 需要获取的读写锁
+ *
+ * @note 与`spinlock_acquire`一样会关闭中断, 可以嵌套
+ */
+void rwlock_write_acquire(rwlock_t *lock);
+
+
+/**
+ * @brief `rwlock_write_release`用于释放读写锁`lock`的写锁
+ *
+ * @param lock 需要释放的读写锁
+ */
+void rwlock_write_release(rwlock_t *lock);
+
+
+/**
+ * @brief `seqlock_init`用于初始化顺序锁`lock`
+ *
+ * @param lock 需要被初始化的顺序锁
+ * @param name 顺序锁的名字
+ */
+void seqlock_init(seqlock_t *lock, char *name);
+
+
+/**
+ * @brief `seqlock_write_begin`用于获取顺序锁`lock`的写锁, 获取后序号为奇数
+ *
+ * @param lock 需要获取的顺序锁
+ *
+ * @note 与`spinlock_acquire`一样会关闭中断, 因此读者不会在同一个`CPU`上打断写者
+ */
+void seqlock_write_begin(seqlock_t *lock);
+
+
+/**
+ * @brief `seqlock_write_end`用于释放顺序锁`lock`的写锁, 释放后序号为偶数
+ *
+ * @param lock 需要释放的顺序锁
+ */
+void seqlock_write_end(seqlock_t *lock);
+
+
+/**
+ * @brief `seqlock_read_begin`用于开始读取顺序锁`lock`保护的数据
+ *
+ * @param lock 顺序锁
+ * @return uint64_t 开始读取时的序号, 需要传给`seqlock_read_retry`
+ *
+ * @note 写者正在写入时等待写入完成
+ * @note 读取序号后的`fence r,r`保证之后读取数据的指令不会在读取序号之前执行
+ */
+static inline uint64_t seqlock_read_begin(const seqlock_t *lock){
+    uint64_t sequence;
+    while ((sequence = lock->sequence) & 1);
+    asm volatile("fence r,r" ::: "memory");
+    return sequence;
+}
+
+
+/**
+ * @brief `seqlock_read_retry`用于判断读取的数据是否需要重新读取
+ *
+ * @param lock 顺序锁
+ * @param sequence `seqlock_read_begin`的返回值
+ * @return Bool 读取期间写者修改过数据时返回True, 此时需要重新读取
+ *
+ * @note 读取序号前的`fence r,r`保证之前读取数据的指令一定在读取序号之前执行
+ */
+static inline Bool seqlock_read_retry(const seqlock_t *lock, uint64_t sequence){
+    asm volatile("fence r,r" ::: "memory");
+    return lock->sequence != sequence;
+}
+
+
+/**
+ * @brief `lockstat_register_stat`用于将锁的统计信息加入统计列表, 请使用`lockstat_register`
+ *
+ * @param stat 锁的统计信息
+ * @param name 锁的名字
+ */
+void lockstat_register_stat(lockstat_t *stat, const char *name);
+
+
+#if LOCKSTAT_ENABLE == 1
+/**
+ * @brief `lockstat_register`用于将自旋锁或者MCS锁加入统计列表, 之后`lockstat_dump`才会输出该锁
+ *
+ * @note 统计列表保存锁的地址且不会删除, 因此只能注册静态分配的锁, 在锁初始化之后调用. 重复注册同一个锁时只加入一次
+ */
+#define lockstat_register(lock)         lockstat_register_stat(&(lock)->stat, (lock)->name)
+#else
+#define lockstat_register(lock)         ((void)(lock))
+#endif
+
+
+/**
+ * @brief `lockstat_dump`用于按照等待锁的总时钟周期数从多到少输出所有已注册的锁的竞争统计信息
+ *
+ * @note `LOCKSTAT_ENABLE = 0`时只输出提示信息
+ */
+void lockstat_dump(void);
+
+
+/**
+ * @brief `lockstat_reset`用于清空所有已注册的锁的竞争统计信息
+ */
+void lockstat_reset(void);
+
+
+#endif
@@ -31,8 +31,8 @@ typedef struct __ppool_t {
     addr_t paddr_start;
     /// 内存池管理的总页数
     size_t size;
-    /// 内存池的锁
-    spinlock_t lock;
+    /// 内存池的锁, 所有CPU分配物理页时都会竞争该锁, 因此使用MCS锁
+    mcslock_t lock;
 } ppool_t;
 
 
@@ -183,6 +183,8 @@ void parse_pgd(pgd_t *pgd, addr_t s_vaddr, size_t size);
  * @note 目前该函数会将`PGD`打印到屏幕上
  * 
  * @note 运行该函数时, 需要关闭虚拟地址翻译
+ *
+ * @note 调用者需要持有`pgd`的读锁. 页错误处理函数中当前`CPU`可能正持有写锁, 因此使用`rwlock_try_read_acquire`
  */
 void dump_pgd(pgd_t *pgd, addr_t s_vaddr, addr_t e_vaddr);
 
@@ -454,6 +456,8 @@ void make_pgd_entry(
  * 
  * @note `vaddr`和`paddr`不一定是页起始地址, 因此会将其所在的前一个页也进行映射, 
  *      即将`page_align(vaddr, False)`和`page_align(paddr, False)`进行映射
+ *
+ * @note 修改页表期间持有`pgd`的写锁
  */
 void create_mapping(
     pgd_t *pgd,
@@ -464,6 +468,45 @@ void create_mapping(
     uint64_t flags
 );
 
+
+/**
+ * @brief `remove_mapping`用于在`pgd`指向的页目录表中删除`[vaddr, vaddr + size)`的映射, 并刷新所有`CPU`的`TLB`
+ *
+ * @param pgd 全局页目录表
+ * @param vaddr 起始虚拟地址
+ * @param size 字节数
+ *
+ * @note 修改时获取`pgd`的写锁, 所有表项清除后通过`ktlb_batch_flush`一次性击落, 每个`CPU`只收到一次核间中断
+ * @note 函数返回后所有`CPU`都不会再访问原来映射的物理页, 调用者可以释放这些物理页
+ * @warning 目前不支持拆分巨页, 要删除的范围必须包含完整的巨页
+ */
+void remove_mapping(pgd_t *pgd, addr_t vaddr, uint64_t size);
+
+
+/**
+ * @brief `get_pgd_lock`用于获得保护全局页目录表`pgd`的读写锁
+ *
+ * @param pgd 全局页目录表
+ * @return rwlock_t* 保护`pgd`的读写锁
+ *
+ * @note 每个地址空间一个读写锁: 遍历和查询页表时获取读锁, 多个`CPU`上的页错误处理可以并行查询; 修改页表时获取写锁
+ * @note 目前只有内核一个地址空间, 因此总是返回内核页目录表的读写锁
+ */
+rwlock_t *get_pgd_lock(pgd_t *pgd);
+
+
+/**
+ * @brief `lookup_mapping`用于在`pgd`指向的页目录表中查询虚拟地址`vaddr`映射到的物理地址
+ *
+ * @param pgd 全局页目录表
+ * @param vaddr 要查询的虚拟地址
+ * @param entry 若不为NULL, 则保存映射`vaddr`的最后一级表项的值, 没有映射时为0
+ * @return addr_t `vaddr`映射到的物理地址, 没有映射时返回0
+ *
+ * @note 查询时获取`pgd`的读锁, 多个`CPU`可以并行查询. 持有`pgd`写锁的`CPU`不能调用, 否则死锁
+ */
+addr_t lookup_mapping(pgd_t *pgd, addr_t vaddr, uint64_t *entry);
+
 // **********************************************************************************************************
 // * 分页机制函数定义
 // **********************************************************************************************************
@@ -0,0 +1,91 @@
+/**
+ * @file percpu.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `percpu.h`提供了每个`CPU`一份的变量(per-CPU变量)
+ * @version 0.1
+ * @date 2023-06-11
+ *
+ * @note 使用`DEFINE_PER_CPU`定义的变量放在`.data.percpu`段中, 该段只是模板. 每个`HART`进入内核时将模板复制一份到自己的数据区,
+ *      并将数据区的基地址保存在`tp`寄存器中. 此后访问当前`CPU`的副本只需要用变量相对`.data.percpu`段的偏移加上`tp`, 不需要获取锁, 也不需要读取`CPU`编号
+ *
+ * @note 内核运行时`tp`始终保存当前`HART`的数据区基地址, `ktrap_enter`负责在陷入时恢复`tp`
+ *
+ * 举例:
+ * ```c
+ * DEFINE_PER_CPU(uint64_t, irq_count);
+ * this_cpu_inc(irq_count);
+ * uint64_t count = *per_cpu_ptr(irq_count, 1);
+ * ```
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_PERCPU_H
+#define __INCLUDE_KERNEL_PERCPU_H
+
+#include "types.h"
+#include "constrains.h"
+
+
+/// `.data.percpu`段的起始地址和终止地址, 定义在`kernel.ld`中
+extern char _s_percpu[], _e_percpu[];
+
+/// 每个`CPU`的数据区相对`.data.percpu`段的偏移, 定义在`percpu.c`中
+extern addr_t percpu_offset[MAX_CPU_NUM];
+
+
+/// 定义per-CPU变量
+#define DEFINE_PER_CPU(type, name)      __attribute__((section(".data.percpu"))) type name
+
+/// 声明在其他文件中定义的per-CPU变量
+#define DECLARE_PER_CPU(type, name)     extern __attribute__((section(".data.percpu"))) type name
+
+
+/**
+ * @brief `this_cpu_base`用于获取当前`CPU`的数据区基地址, 即`tp`寄存器的值
+ */
+static inline addr_t this_cpu_base(void){
+    addr_t base;
+    asm ("mv %0, tp" : "=r" (base));
+    return base;
+}
+
+
+/// 获取per-CPU变量`var`在当前`CPU`上的副本的指针
+#define this_cpu_ptr(var)               ((__typeof__(&(var)))((addr_t)&(var) - (addr_t)_s_percpu + this_cpu_base()))
+
+/// 获取per-CPU变量`var`在`cpu`上的副本的指针
+#define per_cpu_ptr(var, cpu)           ((__typeof__(&(var)))((addr_t)&(var) + percpu_offset[(cpu)]))
+
+/// 读取per-CPU变量`var`在当前`CPU`上的副本
+#define this_cpu_read(var)              (*this_cpu_ptr(var))
+
+/// 设置per-CPU变量`var`在当前`CPU`上的副本
+#define this_cpu_write(var, value)      (*this_cpu_ptr(var) = (value))
+
+/**
+ * @brief 将per-CPU变量`var`在当前`CPU`上的副本加`n`
+ *
+ * @note 使用`amoadd`指令, 因此不会被同一个`CPU`上的中断打断, 只能用于4字节和8字节的整数
+ */
+#define this_cpu_add(var, n)            ((void)__atomic_fetch_add(this_cpu_ptr(var), (n), __ATOMIC_RELAXED))
+
+/// 将per-CPU变量`var`在当前`CPU`上的副本加1
+#define this_cpu_inc(var)               this_cpu_add(var, 1)
+
+/// 将per-CPU变量`var`在当前`CPU`上的副本减1
+#define this_cpu_dec(var)               this_cpu_add(var, -1)
+
+
+/**
+ * @brief `percpu_init_hart`将`.data.percpu`段复制到`hartid`的数据区, 由`kboot.S`在每个`HART`进入内核时调用
+ *
+ * @param hartid 当前`HART`的编号
+ * @return addr_t 当前`HART`的数据区基地址, `kboot.S`将其保存在`tp`寄存器中
+ *
+ * @note 调用时`tp`寄存器还没有设置, 因此不能使用per-CPU变量, 也不能调用`kprintf`
+ */
+addr_t percpu_init_hart(uint64_t hartid);
+
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file rcu.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `rcu.h`提供了基于静止状态(Quiescent-State-Based)的RCU(Read-Copy-Update)机制
+ * @version 0.1
+ * @date 2023-06-08
+ *
+ * @note RCU用于读多写少的数据结构: 读者不获取锁, 写者先将节点从数据结构中摘下, 等到所有`CPU`都经过一次静止状态(宽限期, grace period)之后,
+ *      不可能再有读者持有该节点, 此时才释放节点
+ *
+ * @note 静止状态是指`CPU`不处于RCU读临界区的时刻, 目前有两个:
+ *  - 时钟中断打断的上下文不在读临界区内, 见`rcu_check_tick`
+ *  - 上下文切换时, 见`rcu_quiescent_state`. 目前还没有进程调度, 实现调度器后需要在切换时调用
+ *
+ * @note 读临界区内不能睡眠或者主动让出CPU
+ *
+ * 举例:
+ * ```c
+ * // 读者
+ * rcu_read_lock();
+ * for (list_elem_t *e = list_first_rcu(&list); e != &list.tail; e = list_next_rcu(e))
+ *     ...;
+ * rcu_read_unlock();
+ *
+ * // 写者, 写者之间需要使用锁互斥
+ * spinlock_acquire(&lock);
+ * list_remove_rcu(&node->elem);
+ * spinlock_release(&lock);
+ * call_rcu(&node->rcu, free_node);
+ * ```
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_KERNEL_RCU_H
+#define __INCLUDE_KERNEL_RCU_H
+
+#include "types.h"
+#include "constrains.h"
+#include "kernel/ksmp.h"
+
+
+/**
+ * @brief `rcu_head_t`是RCU回调函数的节点, 需要作为被释放的结构体的成员
+ */
+typedef struct __rcu_head_t {
+    /// @brief 下一个回调函数节点
+    struct __rcu_head_t *next;
+    /// @brief 宽限期结束后调用的回调函数, 通常用于释放结构体
+    void (*func)(struct __rcu_head_t *head);
+} rcu_head_t;
+
+
+/**
+ * @brief `rcu_cpu_t`是每个`CPU`的RCU状态
+ */
+typedef struct __rcu_cpu_t {
+    /// @brief 读临界区的嵌套深度
+    uint64_t volatile nesting;
+    /// @brief 该`CPU`最近一次经过静止状态时已经开始的宽限期
+    uint64_t volatile qs_gp;
+    /// @brief 等待下一个宽限期开始的回调函数
+    rcu_head_t *next_list;
+    rcu_head_t **next_tail;
+    /// @brief 等待宽限期`wait_gp`结束的回调函数
+    rcu_head_t *wait_list;
+    uint64_t wait_gp;
+} ALIGN64 rcu_cpu_t;
+
+
+/// 每个`CPU`的RCU状态, 定义在`rcu.c`中
+extern rcu_cpu_t rcu_cpus[MAX_CPU_NUM];
+
+
+/**
+ * @brief `rcu_read_lock`用于进入RCU读临界区
+ *
+ * @note 只增加当前`CPU`的嵌套深度, 不获取锁, 也不关中断. 时钟中断据此判断被打断的上下文是否处于读临界区
+ */
+static inline void rcu_read_lock(void){
+    rcu_cpus[cpu_id()].nesting++;
+    asm volatile("" ::: "memory");
+}
+
+
+/**
+ * @brief `rcu_read_unlock`用于退出RCU读临界区
+ */
+static inline void rcu_read_unlock(void){
+    asm volatile("" ::: "memory");
+    rcu_cpus[cpu_id()].nesting--;
+}
+
+
+/**
+ * @brief `rcu_dereference`用于在读临界区内读取被RCU保护的指针
+ *
+ * @note RVWMO保证存在地址依赖的读取是有序的, 因此只需要保证编译器只读取一次指针
+ */
+#define rcu_dereference(p)          __atomic_load_n(&(p), __ATOMIC_RELAXED)
+
+
+/**
+ * @brief `rcu_assign_pointer`用于发布被RCU保护的指针, 保证读者读取到指针时, 指针指向的数据已经初始化完成
+ *
+ * @note release语义对应`fence rw,w`
+ */
+#define rcu_assign_pointer(p, v)    __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+
+/**
+ * @brief `rcu_init`用于初始化RCU
+ */
+void rcu_init(void);
+
+
+/**
+ * @brief `rcu_cpu_online`用于将`cpu`加入宽限期的检测中, 此后每个宽限期都需要等待该`CPU`经过静止状态
+ *
+ * @param cpu `CPU`的编号
+ */
+void rcu_cpu_online(uint64_t cpu);
+
+
+/**
+ * @brief `call_rcu`用于在下一个完整的宽限期结束后调用`func`
+ *
+ * @param head 回调函数节点, 通常是被释放的结构体的成员
+ * @param func 回调函数
+ *
+ * @note 回调函数在当前`CPU`上按批次调用, 调用时位于时钟中断中, 因此回调函数中不能睡眠
+ */
+void call_rcu(rcu_head_t *head, void (*func)(rcu_head_t *head));
+
+
+/**
+ * @brief `synchronize_rcu`用于等待一个完整的宽限期结束
+ *
+ * @note 不能在读临界区内调用
+ */
+void synchronize_rcu(void);
+
+
+/**
+ * @brief `rcu_quiescent_state`用于报告当前`CPU`经过了一次静止状态, 并处理当前`CPU`的回调函数
+ *
+ * @note 调用时当前`CPU`不能处于读临界区内, 例如进程切换时
+ */
+void rcu_quiescent_state(void);
+
+
+/**
+ * @brief `rcu_check_tick`在时钟中断中调用, 被打断的上下文不在读临界区内时报告静止状态
+ */
+void rcu_check_tick(void);
+
+
+#endif
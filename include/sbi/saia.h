@@ -0,0 +1,30 @@
+/**
+ * @file saia.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `saia.h`是`SBI`的`AIA`中断控制器初始化模块
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @note `QEMU`使用`aia=aplic-imsic`启动时, 外部中断先到达M模式的根`APLIC`中断域. `SBI`将所有中断源委托给S模式的子中断域,
+ *      并设置`MSI`的目标地址, 之后的中断分配和路由都由内核完成. 没有使用`AIA`时(使用`PLIC`), 该模块什么都不做
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_SBI_SAIA_H
+#define __INCLUDE_SBI_SAIA_H
+
+#include "types.h"
+#include "constrains.h"
+
+
+/**
+ * @brief `saia_init`根据设备树初始化`AIA`的根中断域
+ * 
+ * @param dtb 设备树的地址
+ * @return Bool 找到并初始化了`AIA`返回True, 否则返回False
+ */
+Bool saia_init(addr_t dtb);
+
+
+#endif
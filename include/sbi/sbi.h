@@ -13,6 +13,7 @@
 
 #include "types.h"
 #include "constrains.h"
+#include "sbi/sbiext.h"
 
 /// @brief `sbicall_id_t`内定义了`SBI`调用号
 typedef enum __sbicall_id_t {
@@ -23,10 +24,144 @@ typedef enum __sbicall_id_t {
     // `SBICALL_CONSOLE_PUTSTR = 0x02`, `SBI`提供的字符串输出服务
     SBICALL_CONSOLE_PUTSTR,
     // `SBICALL_CONSOLE_GETCHAR = 0x03`, `SBI`提供的字符获取服务
-    SBICALL_CONSOLE_GETCHAR
+    SBICALL_CONSOLE_GETCHAR,
+    // `SBICALL_HART_START = 0x04`, `SBI`提供的启动`HART`服务
+    SBICALL_HART_START
 } sbicall_id_t;
 
 
+/// `X2W-OS`的`SBI`实现的`SBI`规范版本, 即`v2.0`
+#define SBI_SPEC_VERSION            ((2UL << 24) | 0)
+/// `OpenSBI`的实现号
+#define SBI_IMPL_ID_OPENSBI         1
+/// `X2W-OS`的`SBI`的实现号, 即`"X2W"`, `SBI`规范还没有为`X2W-OS`分配实现号
+#define SBI_IMPL_ID_X2W             0x583257
+/// `X2W-OS`的`SBI`的实现版本
+#define SBI_IMPL_VERSION            1
+
+/// @brief `sbi_base_fid_t`是`Base`扩展的功能号(`FID`)
+typedef enum __sbi_base_fid_t {
+    /// 获取`SBI`规范的版本, 第24~30位为主版本号, 第0~23位为次版本号
+    SBI_BASE_GET_SPEC_VERSION = 0,
+    /// 获取`SBI`实现号
+    SBI_BASE_GET_IMPL_ID,
+    /// 获取`SBI`实现的版本
+    SBI_BASE_GET_IMPL_VERSION,
+    /// 查询扩展是否可用, 可用时返回值非0
+    SBI_BASE_PROBE_EXT,
+    /// 获取`mvendorid`寄存器的值
+    SBI_BASE_GET_MVENDORID,
+    /// 获取`marchid`寄存器的值
+    SBI_BASE_GET_MARCHID,
+    /// 获取`mimpid`寄存器的值
+    SBI_BASE_GET_MIMPID
+} sbi_base_fid_t;
+
+/// @brief `sbi_x2w_fid_t`是`X2W-OS`厂商扩展的功能号(`FID`)
+typedef enum __sbi_x2w_fid_t {
+    /// 输出`SBI`的陷入统计
+    SBI_X2W_TRAPSTAT_DUMP = 0
+} sbi_x2w_fid_t;
+
+/// @brief `sbi_rfence_fid_t`是`RFENCE`扩展的功能号(`FID`)
+typedef enum __sbi_rfence_fid_t {
+    /// 在目标`HART`上执行`fence.i`
+    SBI_RFENCE_FENCE_I = 0,
+    /// 在目标`HART`上对指定地址范围执行`sfence.vma`
+    SBI_RFENCE_SFENCE_VMA,
+    /// 在目标`HART`上对指定地址范围和`ASID`执行`sfence.vma`
+    SBI_RFENCE_SFENCE_VMA_ASID
+} sbi_rfence_fid_t;
+
+/// @brief `sbi_hsm_fid_t`是`HSM`扩展的功能号(`FID`)
+typedef enum __sbi_hsm_fid_t {
+    /// 启动一个`HART`
+    SBI_HSM_HART_START = 0,
+    /// 停止当前`HART`
+    SBI_HSM_HART_STOP,
+    /// 获取`HART`的状态
+    SBI_HSM_HART_GET_STATUS,
+    /// 挂起当前`HART`
+    SBI_HSM_HART_SUSPEND
+} sbi_hsm_fid_t;
+
+/// @brief `sbi_hsm_state_t`是`HSM`扩展中`HART`的状态
+typedef enum __sbi_hsm_state_t {
+    /// `HART`正在运行
+    SBI_HSM_STATE_STARTED = 0,
+    /// `HART`已经停止
+    SBI_HSM_STATE_STOPPED,
+    /// 已经请求启动`HART`, `HART`还没有开始运行
+    SBI_HSM_STATE_START_PENDING,
+    /// 已经请求停止`HART`, `HART`还没有停止
+    SBI_HSM_STATE_STOP_PENDING
+} sbi_hsm_state_t;
+
+/// `HSM`扩展的默认挂起类型: 挂起时保留所有状态, 收到中断后从`hart_suspend`返回
+#define SBI_HSM_SUSPEND_RET_DEFAULT     0x00000000
+/// `HSM`扩展的默认挂起类型: 挂起时不保留状态, 收到中断后从`resume_addr`开始运行
+#define SBI_HSM_SUSPEND_NON_RET_DEFAULT 0x80000000
+
+/// @brief `sbi_srst_type_t`是`SRST`扩展的复位类型
+typedef enum __sbi_srst_type_t {
+    /// 关机
+    SBI_SRST_SHUTDOWN = 0,
+    /// 冷重启
+    SBI_SRST_COLD_REBOOT,
+    /// 热重启
+    SBI_SRST_WARM_REBOOT
+} sbi_srst_type_t;
+
+/// @brief `sbi_srst_reason_t`是`SRST`扩展的复位原因
+typedef enum __sbi_srst_reason_t {
+    /// 没有原因, 即正常关机/重启
+    SBI_SRST_REASON_NONE = 0,
+    /// 系统错误
+    SBI_SRST_REASON_SYSTEM_FAILURE
+} sbi_srst_reason_t;
+
+/// @brief `sbi_dbcn_fid_t`是`DBCN`扩展的功能号(`FID`)
+typedef enum __sbi_dbcn_fid_t {
+    /// 输出物理地址`base`开始的`num_bytes`个字节, 返回输出的字节数
+    SBI_DBCN_CONSOLE_WRITE = 0,
+    /// 以非阻塞的方式读取最多`num_bytes`个字节到物理地址`base`, 返回读取的字节数
+    SBI_DBCN_CONSOLE_READ,
+    /// 输出一个字节
+    SBI_DBCN_CONSOLE_WRITE_BYTE = SBI_DBCN_FID_WRITE_BYTE
+} sbi_dbcn_fid_t;
+
+
+/// `SBI`调用成功
+#define SBI_SUCCESS                 0
+/// `SBI`调用失败
+#define SBI_ERR_FAILED              -1
+/// `SBI`调用不支持
+#define SBI_ERR_NOT_SUPPORTED       -2
+/// `SBI`调用的参数错误
+#define SBI_ERR_INVALID_PARAM       -3
+/// `SBI`调用被拒绝
+#define SBI_ERR_DENIED              -4
+/// `SBI`调用的地址参数错误
+#define SBI_ERR_INVALID_ADDRESS     -5
+/// `SBI`调用请求的资源已经可用, 例如要启动的`HART`已经启动
+#define SBI_ERR_ALREADY_AVAILABLE   -6
+/// `SBI`调用请求的资源已经启动
+#define SBI_ERR_ALREADY_STARTED     -7
+/// `SBI`调用请求的资源已经停止
+#define SBI_ERR_ALREADY_STOPPED     -8
+
+
+/**
+ * @brief `sbiret_t`是`SBI`标准扩展的返回值, 错误码保存在`a0`寄存器中, 返回值保存在`a1`寄存器中
+ */
+typedef struct __sbiret_t {
+    /// @brief 错误码, `SBI_SUCCESS`或者`SBI_ERR_*`
+    int64_t error;
+    /// @brief 返回值
+    int64_t value;
+} sbiret_t;
+
+
 /**
  * @brief `_SBICALL`宏函数将会触发`ecall`异常, 而后跳转到`strap_enter`函数中运行, 该函数定义在`strap_entry.S`中
  * 
@@ -49,6 +184,32 @@ typedef enum __sbicall_id_t {
     a0;                                                     \
 })
 
+/**
+ * @brief `_SBI_ECALL`宏函数按照`SBI`标准扩展的调用约定触发`ecall`异常
+ * 
+ * @note 与`_SBICALL`的区别:
+ *  1. 扩展号(`EID`)保存在`a7`寄存器中, 功能号(`FID`)保存在`a6`寄存器中
+ *  2. 最多支持五个参数, 分别使用a0~a4寄存器传递
+ *  3. 错误码保存在`a0`寄存器中, 返回值保存在`a1`寄存器中, 一起作为`sbiret_t`返回
+ */
+#define _SBI_ECALL(ext, fid, arg0, arg1, arg2, arg3, arg4) ({   \
+    register ireg_t a0 asm ("a0") = (ireg_t)(arg0);             \
+    register ireg_t a1 asm ("a1") = (ireg_t)(arg1);             \
+    register ireg_t a2 asm ("a2") = (ireg_t)(arg2);             \
+    register ireg_t a3 asm ("a3") = (ireg_t)(arg3);             \
+    register ireg_t a4 asm ("a4") = (ireg_t)(arg4);             \
+    register ireg_t a6 asm ("a6") = (ireg_t)(fid);              \
+    register ireg_t a7 asm ("a7") = (ireg_t)(ext);              \
+    asm volatile (                                              \
+        "ecall"                                                 \
+        : "+r"  (a0),   "+r"  (a1)                              \
+        : "r"   (a2),   "r"   (a3),   "r"   (a4),               \
+          "r"   (a6),   "r"   (a7)                              \
+        : "memory"                                              \
+    );                                                          \
+    (sbiret_t){.error = (int64_t)a0, .value = (int64_t)a1};     \
+})
+
 /// @brief `_SBICALL0`为接受0个参数的`SBI`调用
 #define _SBICALL0(scall_id)                     _SBICALL(scall_id, 0, 0, 0)
 /// @brief `_SBICALL1`为接受1个参数的`SBI`调用
@@ -58,22 +219,76 @@ typedef enum __sbicall_id_t {
 /// @brief `_SBICALL3`为接受3个参数的`SBI`调用
 #define _SBICALL3(scall_id, arg0, arg1, arg2)   _SBICALL(scall_id, arg0, arg1, arg2)
 
+/**
+ * @brief `sbi_get_spec_version`用于获取`SBI`实现的`SBI`规范版本
+ * 
+ * @return int64_t 第24~30位为主版本号, 第0~23位为次版本号
+ */
+static inline int64_t sbi_get_spec_version(void){
+    return _SBI_ECALL(SBI_EXT_BASE, SBI_BASE_GET_SPEC_VERSION, 0, 0, 0, 0, 0).value;
+}
+
+/**
+ * @brief `sbi_get_impl_id`用于获取`SBI`的实现号, 例如`SBI_IMPL_ID_X2W`, `SBI_IMPL_ID_OPENSBI`
+ */
+static inline int64_t sbi_get_impl_id(void){
+    return _SBI_ECALL(SBI_EXT_BASE, SBI_BASE_GET_IMPL_ID, 0, 0, 0, 0, 0).value;
+}
+
+/**
+ * @brief `sbi_probe_extension`用于查询`SBI`是否支持扩展`eid`
+ * 
+ * @param eid 扩展号
+ * @return Bool 支持时返回True
+ */
+static inline Bool sbi_probe_extension(uint64_t eid){
+    return _SBI_ECALL(SBI_EXT_BASE, SBI_BASE_PROBE_EXT, eid, 0, 0, 0, 0).value != 0;
+}
+
 /**
  * @brief `sbi_settimer`用于设置时钟, 即设置`mtimecmp`寄存器的值为`next_ticks`
  * 
  * @param next_ticks 时钟的值
+ * 
+ * @note 使用`TIME`扩展, `X2W-OS`的`SBI`在快速路径中处理该调用, 见`strap_entry.S`
  */
 static inline void sbi_settimer(uint64_t next_ticks){
-    _SBICALL1(SBICALL_SETTIMER, next_ticks);
+    _SBI_ECALL(SBI_EXT_TIME, 0, next_ticks, 0, 0, 0, 0);
 }
 
 /**
  * @brief `sbi_putc`用于向终端输出一个字符
  * 
  * @param c 需要输出的字符
+ * 
+ * @note 使用`DBCN`扩展, `X2W-OS`的`SBI`在快速路径中处理该调用, 见`strap_entry.S`
  */
 static inline void sbi_putc(char c){
-    _SBICALL1(SBICALL_CONSOLE_PUTCHAR, c);
+    _SBI_ECALL(SBI_EXT_DBCN, SBI_DBCN_CONSOLE_WRITE_BYTE, (uint8_t)c, 0, 0, 0, 0);
+}
+
+/**
+ * @brief `sbi_console_write`用于一次向终端输出`buf`中的`len`个字节
+ * 
+ * @param buf 需要输出的数据, 内核是恒等映射的, 因此虚拟地址就是`DBCN`扩展要求的物理地址
+ * @param len 字节数
+ * @return int64_t 成功时为输出的字节数, 否则为`SBI`错误码
+ */
+static inline int64_t sbi_console_write(const char *buf, size_t len){
+    sbiret_t ret = _SBI_ECALL(SBI_EXT_DBCN, SBI_DBCN_CONSOLE_WRITE, len, buf, 0, 0, 0);
+    return ret.error == SBI_SUCCESS ? ret.value : ret.error;
+}
+
+/**
+ * @brief `sbi_console_read`用于以非阻塞的方式从终端读取最多`len`个字节到`buf`中
+ * 
+ * @param buf 读取的数据, 同`sbi_console_write`
+ * @param len 最多读取的字节数
+ * @return int64_t 成功时为读取的字节数, 没有数据时为0, 否则为`SBI`错误码
+ */
+static inline int64_t sbi_console_read(char *buf, size_t len){
+    sbiret_t ret = _SBI_ECALL(SBI_EXT_DBCN, SBI_DBCN_CONSOLE_READ, len, buf, 0, 0, 0);
+    return ret.error == SBI_SUCCESS ? ret.value : ret.error;
 }
 
 /**
@@ -84,7 +299,120 @@ static inline void sbi_putc(char c){
  * @warning `sbi_puts`不会对str是否是以'\0'结尾进行检查
  */
 static inline void sbi_puts(char *str){
-    _SBICALL1(SBICALL_CONSOLE_PUTSTR, str);
+    size_t len = 0;
+    while (str[len] != '\0')
+        len++;
+    sbi_console_write(str, len);
+}
+
+/**
+ * @brief `sbi_getc`用于以非阻塞的方式从终端读取一个字符
+ * 
+ * @return int64_t 读取到的字符, 没有数据时返回-1
+ */
+static inline int64_t sbi_getc(void){
+    char c;
+    return sbi_console_read(&c, 1) == 1 ? (uint8_t)c : -1;
+}
+
+/**
+ * @brief `sbi_hart_start`用于启动在`SBI`中等待的`HART`, 被启动的`HART`将以S模式从`start_addr`开始运行
+ * 
+ * @param hartid 需要启动的`HART`的编号
+ * @param start_addr 启动地址(物理地址), 跳转时`satp`为0
+ * @param opaque 传递给被启动的`HART`的参数
+ * @return int64_t `SBI_SUCCESS`表示成功, `SBI_ERR_INVALID_PARAM`表示`HART`不存在, `SBI_ERR_ALREADY_AVAILABLE`表示`HART`已经启动
+ * 
+ * @note 被启动的`HART`跳转时`a0`为`hartid`, `a1`为`opaque`
+ */
+static inline int64_t sbi_hart_start(uint64_t hartid, addr_t start_addr, uint64_t opaque){
+    return _SBI_ECALL(SBI_EXT_HSM, SBI_HSM_HART_START, hartid, start_addr, opaque, 0, 0).error;
+}
+
+/**
+ * @brief `sbi_hart_stop`用于停止当前`HART`, 停止后可以通过`sbi_hart_start`重新启动
+ * 
+ * @return int64_t 成功时不返回, 否则为`SBI`错误码
+ * 
+ * @note 调用之前需要关闭S模式的中断
+ */
+static inline int64_t sbi_hart_stop(void){
+    return _SBI_ECALL(SBI_EXT_HSM, SBI_HSM_HART_STOP, 0, 0, 0, 0, 0).error;
+}
+
+/**
+ * @brief `sbi_hart_get_status`用于获取`HART`的状态
+ * 
+ * @param hartid `HART`的编号
+ * @return int64_t 成功时为`sbi_hsm_state_t`, `HART`不存在时为`SBI_ERR_INVALID_PARAM`
+ */
+static inline int64_t sbi_hart_get_status(uint64_t hartid){
+    sbiret_t ret = _SBI_ECALL(SBI_EXT_HSM, SBI_HSM_HART_GET_STATUS, hartid, 0, 0, 0, 0);
+    return ret.error == SBI_SUCCESS ? ret.value : ret.error;
+}
+
+/**
+ * @brief `sbi_system_reset`用于关机或者重启整个系统
+ * 
+ * @param reset_type 复位类型, 取值为`sbi_srst_type_t`
+ * @param reset_reason 复位原因, 取值为`sbi_srst_reason_t`
+ * @return int64_t 成功时不返回, 否则为`SBI`错误码
+ */
+static inline int64_t sbi_system_reset(uint64_t reset_type, uint64_t reset_reason){
+    return _SBI_ECALL(SBI_EXT_SRST, 0, reset_type, reset_reason, 0, 0, 0).error;
+}
+
+
+/**
+ * @brief `sbi_send_ipi`用于向`hart_mask`中的`HART`发送核间中断, 目标`HART`将收到S模式软件中断
+ * 
+ * @param hart_mask `HART`的掩码, 第`i`位表示`hart_mask_base + i`号`HART`
+ * @param hart_mask_base `hart_mask`的起始`HART`编号, 为-1时表示所有`HART`
+ * @return int64_t `SBI_SUCCESS`表示成功, `SBI_ERR_INVALID_PARAM`表示`HART`不存在或者没有启动
+ */
+static inline int64_t sbi_send_ipi(uint64_t hart_mask, uint64_t hart_mask_base){
+    return _SBI_ECALL(SBI_EXT_IPI, 0, hart_mask, hart_mask_base, 0, 0, 0).error;
+}
+
+/**
+ * @brief `sbi_remote_fence_i`用于在`hart_mask`中的`HART`上执行`fence.i`
+ * 
+ * @param hart_mask `HART`的掩码, 同`sbi_send_ipi`
+ * @param hart_mask_base `hart_mask`的起始`HART`编号, 同`sbi_send_ipi`
+ * @return int64_t `SBI`错误码
+ */
+static inline int64_t sbi_remote_fence_i(uint64_t hart_mask, uint64_t hart_mask_base){
+    return _SBI_ECALL(SBI_EXT_RFENCE, SBI_RFENCE_FENCE_I, hart_mask, hart_mask_base, 0, 0, 0).error;
+}
+
+/**
+ * @brief `sbi_remote_sfence_vma`用于在`hart_mask`中的`HART`上刷新`[start, start + size)`的`TLB`, 所有目标`HART`完成后才返回
+ * 
+ * @param hart_mask `HART`的掩码, 同`sbi_send_ipi`
+ * @param hart_mask_base `hart_mask`的起始`HART`编号, 同`sbi_send_ipi`
+ * @param start 起始虚拟地址
+ * @param size 字节数, `start`和`size`都为0或者`size`为-1时刷新整个`TLB`
+ * @return int64_t `SBI`错误码
+ */
+static inline int64_t sbi_remote_sfence_vma(uint64_t hart_mask, uint64_t hart_mask_base, addr_t start, uint64_t size){
+    return _SBI_ECALL(SBI_EXT_RFENCE, SBI_RFENCE_SFENCE_VMA, hart_mask, hart_mask_base, start, size, 0).error;
+}
+
+/**
+ * @brief `sbi_remote_sfence_vma_asid`与`sbi_remote_sfence_vma`相同, 但只刷新`asid`的`TLB`
+ */
+static inline int64_t sbi_remote_sfence_vma_asid(uint64_t hart_mask, uint64_t hart_mask_base, addr_t start, uint64_t size, uint64_t asid){
+    return _SBI_ECALL(SBI_EXT_RFENCE, SBI_RFENCE_SFENCE_VMA_ASID, hart_mask, hart_mask_base, start, size, asid).error;
+}
+
+
+/**
+ * @brief `sbi_trapstat_dump`用于让`SBI`直接向串口输出`SBI`中每个中断/异常的次数和处理时间, 例如`ecall`的开销
+ * 
+ * @return int64_t `SBI_SUCCESS`表示成功
+ */
+static inline int64_t sbi_trapstat_dump(void){
+    return _SBI_ECALL(SBI_EXT_X2W, SBI_X2W_TRAPSTAT_DUMP, 0, 0, 0, 0, 0).error;
 }
 
 
@@ -0,0 +1,39 @@
+/**
+ * @file sbiext.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `sbiext.h`定义了`SBI`扩展的扩展号(`EID`), 只包含宏定义, 可以被汇编文件包含
+ * @version 0.1
+ * @date 2023-06-20
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_SBI_SBIEXT_H
+#define __INCLUDE_SBI_SBIEXT_H
+
+/**
+ * @brief `SBI`标准扩展的扩展号(`EID`), 调用时保存在`a7`寄存器中, 功能号(`FID`)保存在`a6`寄存器中
+ * 
+ * @note `a7`小于`0x10`的调用是`X2W-OS`的传统调用(`sbi.h`中的`sbicall_id_t`), 只有`X2W-OS`的`SBI`支持, 使用`OpenSBI`等其他`SBI`实现时需要使用标准扩展
+ */
+/// `SBI`标准扩展`Base Extension`的扩展号(`EID`)
+#define SBI_EXT_BASE                0x10
+/// `SBI`标准扩展`Timer Extension`的扩展号(`EID`), 即`"TIME"`
+#define SBI_EXT_TIME                0x54494D45
+/// `SBI`标准扩展`IPI Extension`的扩展号(`EID`), 即`"sPI"`
+#define SBI_EXT_IPI                 0x735049
+/// `SBI`标准扩展`RFENCE Extension`的扩展号(`EID`), 即`"RFNC"`
+#define SBI_EXT_RFENCE              0x52464E43
+/// `SBI`标准扩展`Hart State Management Extension`的扩展号(`EID`), 即`"HSM"`
+#define SBI_EXT_HSM                 0x48534D
+/// `SBI`标准扩展`System Reset Extension`的扩展号(`EID`), 即`"SRST"`
+#define SBI_EXT_SRST                0x53525354
+/// `SBI`标准扩展`Debug Console Extension`的扩展号(`EID`), 即`"DBCN"`
+#define SBI_EXT_DBCN                0x4442434E
+/// `X2W-OS`的`SBI`厂商扩展的扩展号(`EID`), 位于`SBI`规范保留给厂商的`0x09000000~0x09FFFFFF`中
+#define SBI_EXT_X2W                 0x09000000
+
+/// `DBCN`扩展`console_write_byte`的功能号(`FID`), 即`sbi.h`中的`SBI_DBCN_CONSOLE_WRITE_BYTE`, `strap_entry.S`的快速路径使用
+#define SBI_DBCN_FID_WRITE_BYTE     2
+
+#endif
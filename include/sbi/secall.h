@@ -17,6 +17,20 @@
 #include "device/uart.h"
 
 
+/**
+ * @brief `secall_fast_handler_t`是快速路径的`SBI`调用处理函数的函数类型, 参数为调用者的`a0~a2`寄存器, 返回值写回调用者的`a0`寄存器
+ * 
+ * @note 快速路径的处理函数在`strap_entry.S`的`strap_fast_ecall`中直接调用, 没有完整的陷入帧, 因此不能修改`a0`以外的寄存器, 也不能再陷入`M模式`
+ */
+typedef ireg_t (*secall_fast_handler_t)(ireg_t arg0, ireg_t arg1, ireg_t arg2);
+
+
+/**
+ * @brief `secall_fast_table`是快速路径的调用表, 以调用号(`a7`)为下标, 为NULL的项走完整路径
+ */
+extern secall_fast_handler_t secall_fast_table[SECALL_FAST_NUM];
+
+
 /**
  * @brief `secall_init`用于初始化`SBI`调用
  */
@@ -26,7 +40,9 @@ void secall_init(void);
  * @brief `sup_ecall_handler`是`Supervisor`模式下`ecall`指令的处理函数
  * 
  * @param stf_ptr 陷入帧, 调用ecall的程序主动触发`Supervisor Environment Call`异常时在`strap_enter`(定义在`strap_entry.S`中)中构建
- * @return int64_t 处理结果, 若为0则表示处理正常, -1表示处理失败
+ * @return int64_t 总是返回0, 调用的错误码通过`a0`寄存器返回给调用者
+ * 
+ * @note 支持`X2W-OS`的传统调用(`sbicall_id_t`, 只修改`a0`)和`SBI v2.0`的标准扩展(`a0`为错误码, `a1`为返回值), 不支持的调用返回`SBI_ERR_NOT_SUPPORTED`
  */
 int64_t sup_ecall_handler(strapframe_t *stf_ptr);
 
@@ -0,0 +1,156 @@
+/**
+ * @file shart.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `shart.h`是`SBI`的`HART`管理模块, 负责挂起和启动`HART0`之外的`HART`
+ * @version 0.1
+ * @date 2023-06-10
+ * 
+ * @note 上电后所有的`HART`都从`sbi_start`(定义在`sboot.S`中)进入`SBI`:
+ *  1. `HART0`初始化`SBI`后跳转到内核
+ *  2. 其余`HART`在`shart_park`中挂起, 直到内核通过`SBICALL_HART_START`调用启动该`HART`
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_SBI_SHART_H
+#define __INCLUDE_SBI_SHART_H
+
+#include "types.h"
+#include "constrains.h"
+#include "asm/csr.h"
+
+
+/**
+ * @brief `shart_state_t`是`HART`的状态
+ */
+typedef enum __shart_state_t {
+    /// `HART`不存在或者还没有进入`SBI`
+    SHART_ABSENT = 0,
+    /// `HART`在`shart_park`中挂起
+    SHART_STOPPED,
+    /// 内核已经请求启动`HART`, `HART`还没有跳转到内核
+    SHART_START_PENDING,
+    /// `HART`已经跳转到内核
+    SHART_STARTED
+} shart_state_t;
+
+
+/**
+ * @brief `shart_t`是每个`HART`的启动信息, 独占一个缓存行
+ */
+typedef struct __shart_t {
+    /// @brief `HART`的状态, 取值为`shart_state_t`
+    uint64_t volatile state;
+    /// @brief 启动地址
+    addr_t start_addr;
+    /// @brief 传递给被启动的`HART`的参数
+    uint64_t opaque;
+} ALIGN64 shart_t;
+
+
+/**
+ * @brief `shart_scratch_t`是每个`HART`在M模式下的私有数据, 位于该`HART`的`SBI`栈的顶部, `mscratch`寄存器保存其地址
+ */
+typedef struct __shart_scratch_t {
+    /// @brief `HART`的编号
+    uint64_t hartid;
+    /// @brief 该`HART`的`mtimecmp`寄存器的地址
+    addr_t mtimecmp_addr;
+    /// @brief 最近一次设置的`mtimecmp`的值
+    uint64_t next_event;
+    /// @brief M模式时钟中断的次数
+    uint64_t timer_events;
+    /// @brief 保留
+    uint64_t reserved[4];
+} ALIGN64 shart_scratch_t;
+
+_Static_assert(sizeof(shart_scratch_t) == SBI_SCRATCH_SIZE, "shart_scratch_t must fit SBI_SCRATCH_SIZE");
+
+
+/**
+ * @brief `shart_scratch`用于获取当前`HART`的私有数据
+ * 
+ * @return shart_scratch_t* 当前`HART`的私有数据
+ * 
+ * @note `strap_enter`在调用异常/中断处理函数之前已经将`mscratch`恢复为M模式的栈顶, 因此在处理函数中也可以调用
+ */
+static inline shart_scratch_t *shart_scratch(void){
+    return (shart_scratch_t *)read_csr(mscratch);
+}
+
+
+/**
+ * @brief `shart_scratch_init`用于初始化当前`HART`的私有数据, 每个`HART`进入`SBI`后调用一次
+ * 
+ * @param hartid 当前`HART`的编号
+ */
+void shart_scratch_init(uint64_t hartid);
+
+
+/**
+ * @brief `shart_init`将当前`HART`(即`HART0`)标记为已经启动, 在`sinit_all`中调用
+ */
+void shart_init(void);
+
+
+/**
+ * @brief `shart_is_started`用于判断`hartid`是否已经跳转到内核
+ * 
+ * @param hartid `HART`的编号
+ * @return Bool 已经跳转到内核时返回`True`
+ */
+Bool shart_is_started(uint64_t hartid);
+
+
+/**
+ * @brief `shart_park`挂起当前`HART`, 直到内核启动该`HART`, 而后初始化当前`HART`并跳转到内核
+ * 
+ * @param hartid 当前`HART`的编号
+ * 
+ * @note `shart_park`由`sbi_start`(定义在`sboot.S`中)在设置好栈后调用
+ * @note 挂起时只打开M模式的软件中断, 且`mstatus.MIE`为0, 因此`msip`只会唤醒`wfi`而不会陷入
+ */
+NO_RETURN void shart_park(uint64_t hartid);
+
+
+/**
+ * @brief `shart_start`用于启动在`shart_park`中挂起的`HART`
+ * 
+ * @param hartid 需要启动的`HART`的编号
+ * @param start_addr 启动地址
+ * @param opaque 传递给被启动的`HART`的参数
+ * @return int64_t `SBI_SUCCESS`表示成功, 否则为`SBI`错误码
+ */
+int64_t shart_start(uint64_t hartid, addr_t start_addr, uint64_t opaque);
+
+
+/**
+ * @brief `shart_stop`用于停止当前`HART`, 当前`HART`回到`shart_park`中挂起, 之后可以通过`shart_start`重新启动
+ * 
+ * @note 停止后不会再返回到调用者, 因此丢弃当前的`M模式`栈, 从栈顶重新开始挂起
+ */
+NO_RETURN void shart_stop(void);
+
+
+/**
+ * @brief `shart_get_status`用于获取`HART`在`HSM`扩展中的状态
+ * 
+ * @param hartid `HART`的编号
+ * @param status 成功时保存`sbi_hsm_state_t`
+ * @return int64_t `SBI_SUCCESS`表示成功, `SBI_ERR_INVALID_PARAM`表示`HART`不存在
+ */
+int64_t shart_get_status(uint64_t hartid, int64_t *status);
+
+
+/**
+ * @brief `shart_suspend`用于挂起当前`HART`
+ * 
+ * @param suspend_type 挂起类型
+ * @return int64_t `SBI_SUCCESS`表示收到中断后恢复运行, 否则为`SBI`错误码
+ * 
+ * @note 只支持默认的保留状态的挂起(`SBI_HSM_SUSPEND_RET_DEFAULT`), 即`wfi`
+ */
+int64_t shart_suspend(uint64_t suspend_type);
+
+
+#endif
@@ -20,7 +20,17 @@
  * @note `sinit_all`的初始化顺序:
  *  1. 初始化 SBI 异常/中断处理模块
  *  2. 初始化 SBI Ecall 异常处理模块
+ * 
+ * @param dtb 设备树的地址, 用于检测`AIA`中断控制器
+ */
+void sinit_all(addr_t dtb);
+
+
+/**
+ * @brief `sinit_hart`对`HART0`之外的`HART`进行初始化, 只设置每个`HART`独有的M模式寄存器
+ * 
+ * @note `sinit_hart`在`shart_park`中, `HART`被内核启动之后调用
  */
-void sinit_all(void);
+void sinit_hart(void);
 
 #endif
\ No newline at end of file
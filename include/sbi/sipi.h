@@ -0,0 +1,96 @@
+/**
+ * @file sipi.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `sipi.h`是`SBI`的核间中断模块, 实现了`SBI`标准扩展中的`IPI`扩展和`RFENCE`扩展
+ * @version 0.1
+ * @date 2023-06-12
+ * 
+ * @note 核间中断通过`CLINT`的`msip`寄存器实现: 发送方先在目标`HART`的`sipi_t`中记录请求, 而后写目标`HART`的`msip`,
+ *      目标`HART`在M模式软件中断中处理请求:
+ *  - `SIPI_SOFTWARE`: 设置`mip.SSIP`, 即向S模式注入软件中断
+ *  - `SIPI_RFENCE`: 在目标`HART`上执行`fence.i`或者`sfence.vma`
+ * 
+ * @note `RFENCE`请求是同步的, 发送方等待所有目标`HART`完成后才返回. 等待期间发送方会处理发给自己的请求, 因此两个`HART`互相发送请求时不会死锁
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_SBI_SIPI_H
+#define __INCLUDE_SBI_SIPI_H
+
+#include "types.h"
+#include "constrains.h"
+#include "sbi/strap.h"
+
+
+/// 向S模式注入软件中断的请求
+#define SIPI_SOFTWARE       (1UL << 0)
+/// 执行`fence.i`或者`sfence.vma`的请求
+#define SIPI_RFENCE         (1UL << 1)
+
+
+/**
+ * @brief `sipi_t`是每个`HART`收到的核间中断请求, 独占一个缓存行
+ */
+typedef struct __sipi_t {
+    /// @brief 未处理的请求, `SIPI_SOFTWARE`和`SIPI_RFENCE`的组合
+    uint64_t volatile pending;
+    /// @brief `RFENCE`请求的发送方`HART`编号加1, 为0时可以接收新的`RFENCE`请求, 目标`HART`完成后清零
+    uint64_t volatile rfence_owner;
+    /// @brief `RFENCE`请求的功能号, 取值为`sbi_rfence_fid_t`
+    uint64_t rfence_fid;
+    /// @brief `RFENCE`请求的起始虚拟地址
+    addr_t rfence_start;
+    /// @brief `RFENCE`请求的字节数
+    uint64_t rfence_size;
+    /// @brief `RFENCE`请求的`ASID`
+    uint64_t rfence_asid;
+} ALIGN64 sipi_t;
+
+
+/**
+ * @brief `sipi_init`注册M模式软件中断的处理函数, 并打开当前`HART`的M模式软件中断
+ */
+void sipi_init(void);
+
+
+/**
+ * @brief `sipi_init_hart`打开当前`HART`的M模式软件中断, `HART0`之外的`HART`启动时调用
+ */
+void sipi_init_hart(void);
+
+
+/**
+ * @brief `sipi_send_ipi`向目标`HART`注入S模式软件中断
+ * 
+ * @param hart_mask `HART`的掩码
+ * @param hart_mask_base `hart_mask`的起始`HART`编号, 为-1时表示所有已经启动的`HART`
+ * @return int64_t `SBI`错误码
+ */
+int64_t sipi_send_ipi(uint64_t hart_mask, uint64_t hart_mask_base);
+
+
+/**
+ * @brief `sipi_remote_fence`在目标`HART`上执行`fence.i`或者`sfence.vma`, 所有目标`HART`完成后才返回
+ * 
+ * @param fid `RFENCE`扩展的功能号, 取值为`sbi_rfence_fid_t`
+ * @param hart_mask `HART`的掩码
+ * @param hart_mask_base `hart_mask`的起始`HART`编号, 为-1时表示所有已经启动的`HART`
+ * @param start 起始虚拟地址
+ * @param size 字节数, `start`和`size`都为0或者`size`为-1时刷新整个`TLB`
+ * @param asid 只刷新该`ASID`的`TLB`, 只在`fid`为`SBI_RFENCE_SFENCE_VMA_ASID`时有效
+ * @return int64_t `SBI`错误码
+ */
+int64_t sipi_remote_fence(uint64_t fid, uint64_t hart_mask, uint64_t hart_mask_base, addr_t start, uint64_t size, uint64_t asid);
+
+
+/**
+ * @brief `sipi_interrupt_handler`是M模式软件中断的处理函数, 处理发给当前`HART`的请求
+ * 
+ * @param stf_ptr 陷入帧
+ * @return int64_t 处理结果, 总是0
+ */
+int64_t sipi_interrupt_handler(strapframe_t *stf_ptr);
+
+
+#endif
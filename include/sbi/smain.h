@@ -28,21 +28,28 @@
 /**
  * @brief `sbi_main`是`SBI`的主函数, 在进行一些准备后跳转到内核中运行
  * 
+ * @param hartid 当前`HART`的编号, 只有`HART0`会运行`sbi_main`
+ * @param dtb 设备树的地址, 由`QEMU`通过`a1`寄存器传入, 将原样传给内核
+ * 
  * @note `sbi_main`函数运行在M模式
  * 
  * @note `sbi_main`函数干的事情:
  *  1. 跳转到内核: 调用`jump_to_kernel`函数实现
  */
-NO_RETURN void sbi_main(void);
+NO_RETURN void sbi_main(uint64_t hartid, addr_t dtb);
 
 
 /**
  * @brief `jump_to_kernel`在伪装中断返回后调用`mret`指令以跳转到内核中去
  * 
+ * @param hartid 当前`HART`的编号, 跳转后保存在`a0`寄存器中
+ * @param start_addr 跳转地址
+ * @param opaque 传递给内核的参数, 跳转后保存在`a1`寄存器中
+ * 
  * @note  `jump_to_kernel`函数需要注意的点如下:
  * 1. 该函数通过伪装`S`模式中断返回的模式跳转到内核的主函数
- * 2. 该函数伪装中断返回的地址是由`KERNEL_JUMP_ADDR`宏决定, 该宏定义在`constrains.h`中
- * 3. `KERNEL_JUMP_ADDR`宏的地址需要指向`kernel_start`函数, 该函数定义在`kernel/boot.S`中
+ * 2. `HART0`跳转的地址是`KERNEL_JUMP_ADDR`宏, 该宏定义在`constrains.h`中, 需要指向`kernel_start`函数, 该函数定义在`kernel/kboot.S`中
+ * 3. 其余`HART`跳转的地址由内核通过`SBICALL_HART_START`调用指定, 见`shart.c`
  * 
  * @note `jump_to_kernel`函数在跳转到内核前会进行如下的准备工作以伪装成中断返回:
  * 1. 伪装从S模式中断进入M模式
@@ -51,6 +58,6 @@ NO_RETURN void sbi_main(void);
  * 4. 关闭S模式的中断
  * 5. 关闭S模式的页表转换
  */
-NO_RETURN void jump_to_kernel(void);
+NO_RETURN void jump_to_kernel(uint64_t hartid, addr_t start_addr, uint64_t opaque);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+/**
+ * @file sreset.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `sreset.h`是`SBI`的系统复位模块, 实现`SBI`标准扩展`SRST`
+ * @version 0.1
+ * @date 2023-06-18
+ * 
+ * @note `QEMU`的`virt`机器通过`sifive,test0`设备(`test finisher`)关机和重启: 写入`0x5555`关机, 写入`0x3333 | (code << 16)`以错误码`code`关机, 写入`0x7777`重启.
+ *      设备树中没有该设备时, 复位请求返回`SBI_ERR_NOT_SUPPORTED`
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_SBI_SRESET_H
+#define __INCLUDE_SBI_SRESET_H
+
+#include "types.h"
+#include "constrains.h"
+
+
+/**
+ * @brief `sreset_init`根据设备树查找复位设备
+ * 
+ * @param dtb 设备树的地址
+ * @return Bool 找到复位设备返回True, 否则返回False
+ */
+Bool sreset_init(addr_t dtb);
+
+
+/**
+ * @brief `sreset_system_reset`用于关机或者重启整个系统
+ * 
+ * @param reset_type 复位类型, 取值为`sbi_srst_type_t`
+ * @param reset_reason 复位原因, 取值为`sbi_srst_reason_t`
+ * @return int64_t 成功时不返回, 否则为`SBI`错误码: 保留的类型和原因返回`SBI_ERR_INVALID_PARAM`, 没有复位设备或者厂商定义的类型返回`SBI_ERR_NOT_SUPPORTED`
+ */
+int64_t sreset_system_reset(uint64_t reset_type, uint64_t reset_reason);
+
+
+#endif
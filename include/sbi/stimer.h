@@ -17,10 +17,18 @@
 #include "constrains.h"
 
 /**
- * @brief `stimer_init`是`stimer`的初始化函数
+ * @brief `stimer_init`是`stimer`的初始化函数, 根据设备树判断是否支持`Sstc`扩展, 并初始化当前`HART`
  * 
+ * @param dtb 设备树的地址
  */
-void stimer_init(void);
+void stimer_init(addr_t dtb);
+
+/**
+ * @brief `stimer_init_hart`设置当前`HART`的`mcounteren.CY`, 使S模式可以使用`rdcycle`; 在支持`Sstc`扩展时设置`menvcfg.STCE`和`mcounteren.TM`, 使S模式可以直接写`stimecmp`
+ * 
+ * @note 每个`HART`启动时都需要调用
+ */
+void stimer_init_hart(void);
 
 /**
  * @brief `stimer_interrupt_handler`是M模式下的时钟中断处理函数
@@ -28,7 +36,10 @@ void stimer_init(void);
 int64_t stimer_interrupt_handler(strapframe_t *stf_ptr);
 
 /**
- * @brief `clint_timer_event_start`函数用于设置`mtimecmp`寄存器
+ * @brief `clint_timer_event_start`函数用于设置当前`HART`的`mtimecmp`寄存器
+ * 
+ * @note 每个`HART`的`mtimecmp`寄存器的地址保存在`shart_scratch_t`中, 因此每个`HART`可以独立设置自己的下一次时钟中断
+ * @note 支持`Sstc`扩展时`STIP`只由`stimecmp`决定, 不能再通过M模式的时钟中断注入, 因此直接设置`stimecmp`
  * 
  * @param next_ticks 设置到`mtimecmp`寄存器的值
  */
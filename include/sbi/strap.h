@@ -36,6 +36,14 @@ typedef int64_t (*strap_handler_t)(strapframe_t* stf_ptr);
 void strap_init(void);
 
 
+/**
+ * @brief `strap_init_hart`用于设置当前`HART`的`mtvec`和`mie`寄存器
+ * 
+ * @note 异常/中断处理函数表是所有`HART`共享的, 只需要`HART0`在`strap_init`中初始化一次, 其余`HART`启动时只需要调用`strap_init_hart`
+ */
+void strap_init_hart(void);
+
+
 /**
  * @brief `delegate_traps`用于将`M模式`下的一些中断和异常委托至`S模式`
  * 
@@ -59,6 +67,24 @@ void delegate_traps(void);
 void strap_dispatcher(strapframe_t *stf_ptr);
 
 
+/**
+ * @brief `strap_fast_stat`用于记录一次走快速路径的`SBI`调用的处理时间, 由`strap_entry.S`中的`strap_fast_ecall`调用
+ * 
+ * @param start 进入快速路径时`mcycle`的值
+ * 
+ * @note 快速路径不经过`strap_dispatcher`, 记录为`Environment Call from S-Mode`异常, 和完整路径的统计合并在一起
+ */
+void strap_fast_stat(uint64_t start);
+
+
+/**
+ * @brief `strap_stat_dump`用于输出`SBI`中每个`HART`每个中断/异常的次数和处理时间, 时间以`mcycle`为单位
+ * 
+ * @note 由内核通过`SBI_EXT_X2W`扩展调用
+ */
+void strap_stat_dump(void);
+
+
 /**
  * @brief `regitser_strap_handler`是`SBI`异常/中断注册函数, 用于将编号为`trap_code`的异常/中断的处理函数`strap_func`注册到`SBI`的异常/中断处理函数表中
  * 
@@ -77,7 +77,7 @@
  * - `base = 8`: 将`integer`转换为二进制形式的字符串数字, 例如 `23 = "27"`
  * - `base = 16`: 将`integer`转换为二进制形式的字符串数字, 例如 `47 = "2F"`
  * 
- * @note 因为是使用递归完成的转换, 因此多次递归需要共享字符数组, 因此需要字符数组的二级指针
+ * @note 转换完成后`*buf_ptr_addr`指向输出的最后一个字符之后, 方便连续输出, 因此需要字符数组的二级指针. 转换不会在末尾添加`\0`
  */
 void itoa(uint64_t integer, char** buf_ptr_addr, uint8_t base);
 
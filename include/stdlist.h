@@ -136,4 +136,80 @@ Bool list_search(list_elem_t *elem_ptr, list_t *list_ptr);
  */
 list_elem_t* list_walking(list_t *list_ptr, list_walking_func_t func, int arg);
 
+
+// **********************************************************************************************************
+// * RCU链表操作
+// *    写者之间仍然需要使用锁互斥, 但是读者在RCU读临界区内遍历时不需要获取锁
+// *    被删除的节点需要等待宽限期结束后才能释放, 见`kernel/rcu.h`中的`call_rcu`
+// **********************************************************************************************************
+
+/**
+ * @brief `list_insert_rcu`用于在`before_ptr`指向的节点前插入`add_ptr`指向的节点, 插入期间读者可以并发地遍历链表
+ *
+ * @param before_ptr 指向链表中被插入的节点的指针
+ * @param add_ptr 指向要插入到链表中的节点的指针
+ *
+ * @note 先初始化`add_ptr`, 再以release语义发布到前一个节点的`next`中, 因此读者看到新节点时其`next`一定是有效的
+ */
+void list_insert_rcu(list_elem_t *before_ptr, list_elem_t *add_ptr);
+
+/**
+ * @brief `list_append_rcu`用于将`elem_ptr`指向的节点添加到`list_ptr`指向的链表后面, 添加期间读者可以并发地遍历链表
+ *
+ * @param elem_ptr 指向要添加的节点的指针
+ * @param list_ptr 指向被添加的链表的指针
+ */
+void list_append_rcu(list_elem_t *elem_ptr, list_t *list_ptr);
+
+/**
+ * @brief `list_push_rcu`用于向`list_ptr`指向的链表头前压入`elem_ptr`指向的节点, 压入期间读者可以并发地遍历链表
+ *
+ * @param elem_ptr 指向要被压入的节点的指针
+ * @param list_ptr 指向要被压入的链表的指针
+ */
+void list_push_rcu(list_elem_t *elem_ptr, list_t *list_ptr);
+
+/**
+ * @brief `list_remove_rcu`用于将`elem_ptr`指向的节点从在其所在的链表中删除, 删除期间读者可以并发地遍历链表
+ *
+ * @param elem_ptr 指向要删除的节点的指针
+ *
+ * @note 不修改`elem_ptr`的`next`, 正在访问该节点的读者仍然可以继续遍历. 宽限期结束之前不能释放或者重新插入该节点
+ */
+void list_remove_rcu(list_elem_t *elem_ptr);
+
+/**
+ * @brief `list_first_rcu`用于在RCU读临界区内获得链表的第一个节点
+ *
+ * @param list_ptr 指向链表的指针
+ * @return list_elem_t* 第一个节点, 链表为空时返回`&list_ptr->tail`
+ */
+static inline list_elem_t *list_first_rcu(list_t *list_ptr){
+    return __atomic_load_n(&list_ptr->head.next, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief `list_next_rcu`用于在RCU读临界区内获得`elem_ptr`的下一个节点
+ *
+ * @param elem_ptr 当前节点
+ * @return list_elem_t* 下一个节点
+ *
+ * @note RVWMO保证存在地址依赖的读取是有序的, 因此只需要保证编译器只读取一次指针
+ */
+static inline list_elem_t *list_next_rcu(list_elem_t *elem_ptr){
+    return __atomic_load_n(&elem_ptr->next, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief `list_walking_rcu`用于在RCU读临界区内遍历`list_ptr`指向的链表, 并对每一个节点调用`func`判断是否继续遍历
+ *
+ * @param list_ptr 指向要遍历的链表的指针
+ * @param func 将应用在每一个节点上的函数
+ * @param arg 传给`func`的参数
+ * @return list_elem_t* 第一个使`func`返回True的节点, 没有时返回NULL
+ *
+ * @note 调用者需要处于RCU读临界区内, 且在退出读临界区之后不能再访问返回的节点
+ */
+list_elem_t* list_walking_rcu(list_t *list_ptr, list_walking_func_t func, int arg);
+
 #endif
\ No newline at end of file
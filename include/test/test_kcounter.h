@@ -0,0 +1,22 @@
+/**
+ * @file test_kcounter.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `test_kcounter.h`是`kcounter`的测试文件
+ * @version 0.1
+ * @date 2023-06-21
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_TEST_TEST_KCOUNTER_H
+#define __INCLUDE_TEST_TEST_KCOUNTER_H
+
+#include "kernel/kcounter.h"
+
+/**
+ * @brief `test_kcounter`是每个`CPU`一份的统计计数器的测试函数
+ * @return int 测试正常则返回0
+ */
+int test_kcounter(void);
+
+#endif
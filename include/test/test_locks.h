@@ -0,0 +1,22 @@
+/**
+ * @file test_locks.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `test_locks.h`是`locks`的测试文件
+ * @version 0.1
+ * @date 2023-06-07
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_TEST_TEST_LOCKS_H
+#define __INCLUDE_TEST_TEST_LOCKS_H
+
+#include "kernel/locks.h"
+
+/**
+ * @brief `test_locks`是自旋锁和MCS锁的测试函数
+ * @return int 测试正常则返回0
+ */
+int test_locks(void);
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * @file test_rcu.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `test_rcu.h`是`rcu`的测试文件
+ * @version 0.1
+ * @date 2023-06-21
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_TEST_TEST_RCU_H
+#define __INCLUDE_TEST_TEST_RCU_H
+
+#include "stdlist.h"
+#include "kernel/rcu.h"
+
+/**
+ * @brief `test_rcu`是RCU链表和宽限期的测试函数
+ * @return int 测试正常则返回0
+ */
+int test_rcu(void);
+
+#endif
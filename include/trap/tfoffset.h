@@ -101,6 +101,49 @@
 
 
 
+/* ------------------------------  SBI调用快速路径的陷入帧 ------------------------------ */
+
+/// `SFF_SIZE`宏是`strap_entry.S`中`SBI`调用快速路径的陷入帧的总字节长度, 只保存调用者保存的寄存器, 需要是16的倍数以保持栈对齐
+#define SFF_SIZE    144
+/// `SFF_RA`宏是`ra`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_RA      0
+/// `SFF_SP`宏是`sp`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_SP      8
+/// `SFF_T0`宏是`t0`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_T0      16
+/// `SFF_T1`宏是`t1`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_T1      24
+/// `SFF_T2`宏是`t2`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_T2      32
+/// `SFF_T3`宏是`t3`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_T3      40
+/// `SFF_T4`宏是`t4`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_T4      48
+/// `SFF_T5`宏是`t5`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_T5      56
+/// `SFF_T6`宏是`t6`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_T6      64
+/// `SFF_A0`宏是`a0`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_A0      72
+/// `SFF_A1`宏是`a1`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_A1      80
+/// `SFF_A2`宏是`a2`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_A2      88
+/// `SFF_A3`宏是`a3`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_A3      96
+/// `SFF_A4`宏是`a4`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_A4      104
+/// `SFF_A5`宏是`a5`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_A5      112
+/// `SFF_A6`宏是`a6`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_A6      120
+/// `SFF_A7`宏是`a7`寄存器在快速路径陷入帧中的字节偏移量
+#define SFF_A7      128
+/// `SFF_START`宏是进入快速路径时的`mcycle`在快速路径陷入帧中的字节偏移量, 用于陷入统计
+#define SFF_START   136
+
+
+
 
 /* ------------------------------  ktrapframe_t 相关寄存器 ------------------------------ */
 
@@ -108,8 +151,8 @@
     /// `KTF_SIZE`宏是`ktrapframe_t`结构体的总字节长度
     #define KTF_SIZE 
 #else                            // 不含浮点寄存器的trapframe
-    /// `KTF_SIZE`宏是`ktrapframe_t`结构体的总字节长度
-    #define KTF_SIZE    288
+    /// `KTF_SIZE`宏是`ktrapframe_t`结构体的总字节长度, 需要是16的倍数以保持栈对齐
+    #define KTF_SIZE    304
 #endif
 
 /// `KTF_SEPC`宏是`sepc`寄存器在`ktrapframe_t`结构体中的字节偏移量
@@ -191,7 +234,19 @@
     #define KTF_SCAUSE      272
     /// `KTF_ORIGIN_A0`宏是`origin_a0`在`ktrapframe_t`结构体中的字节偏移量
     #define KTF_ORIGIN_A0   280
+    /// `KTF_FRAME_TYPE`宏是`frame_type`在`ktrapframe_t`结构体中的字节偏移量
+    #define KTF_FRAME_TYPE  288
 #endif
 
+/// 完整的陷入帧, 由`ktrap_enter`构建, 保存了所有通用寄存器和`CSR`寄存器
+#define KTF_FRAME_FULL      0
+/// 部分陷入帧, 由中断的快速入口构建, 只保存了`ra`, `t0~t6`, `a0~a7`, `sepc`和`sstatus`
+#define KTF_FRAME_PARTIAL   1
+
+/// `KIRQ_STACK_NESTING`宏是`nesting`在`kirq_stack_t`结构体中的字节偏移量
+#define KIRQ_STACK_NESTING  0
+/// `KIRQ_STACK_TOP`宏是`top`在`kirq_stack_t`结构体中的字节偏移量
+#define KIRQ_STACK_TOP      8
+
 
 #endif
\ No newline at end of file
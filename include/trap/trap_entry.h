@@ -43,6 +43,14 @@ extern void strap_exit(void);
 extern void ktrap_enter(void);
 
 
+/**
+ * @brief `ktrap_vector`是内核的中断向量表, 由汇编实现, 定义在 `ktrap_entry.S`中
+ * 
+ * @note `stvec`处于向量模式, 时钟中断和外部中断跳转到只保存调用者保存的寄存器的快速入口, 其余中断和异常跳转到`ktrap_enter`
+ */
+extern void ktrap_vector(void);
+
+
 /**
  * @brief `ktrap_exit`是内核的陷入出口函数, 由汇编实现, 定义在 `ktrap_entry.S`中
  * 
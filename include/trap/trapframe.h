@@ -13,6 +13,7 @@
 
 #include "types.h"
 #include "constrains.h"
+#include "trap/tfoffset.h"
 
 
 /**
@@ -152,8 +153,15 @@ typedef struct __ktrapframe_t {
     ireg_t scause;
     /// @brief `origin_a0`保存了系统调用前的`a0`寄存器的值
     ireg_t origin_a0;
+    /// @brief `frame_type`是陷入帧的类型, `KTF_FRAME_FULL`或`KTF_FRAME_PARTIAL`, 部分陷入帧中只有调用者保存的寄存器, `sepc`和`sstatus`是有效的
+    ireg_t frame_type;
+    /// @brief 保留, 使陷入帧的大小为16的倍数
+    ireg_t reserved;
 } ktrapframe_t;
 
+_Static_assert(sizeof(ktrapframe_t) == KTF_SIZE, "ktrapframe_t does not match KTF_SIZE");
+_Static_assert(__builtin_offsetof(ktrapframe_t, frame_type) == KTF_FRAME_TYPE, "ktrapframe_t does not match KTF_FRAME_TYPE");
+
 
 /// @brief `printf_t`是输出函数类型
 typedef size_t (*printf_t)(const char* format, ...);
@@ -182,6 +190,8 @@ void print_strapframe(strapframe_t *stf_ptr, printf_t print_func);
  * 
  * @param ktf_ptr 指向要输出的内核陷入帧的指针
  * @param print_func printf函数, 可以是: `bprintf`, `kprintf`, `uprintf`
+ * 
+ * @note 根据`frame_type`输出完整的陷入帧或者部分陷入帧
  */
 void print_ktrapframe(ktrapframe_t *ktf_ptr, printf_t print_func);
 
@@ -0,0 +1,74 @@
+/**
+ * @file trapstat.h
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `trapstat.h`提供了`SBI`和内核共用的陷入统计: 每个`HART`每个中断/异常号的次数, 总处理时间, 最长处理时间和处理时间的直方图
+ * @version 0.1
+ * @date 2023-06-17
+ *
+ * @note 处理时间的单位由调用者决定: `SBI`使用`mcycle`, 内核使用`get_cycle`, 输出时通过`unit`参数说明
+ * @note 每个`HART`只修改自己的统计信息, 修改时需要关闭中断. 输出时直接读取所有`HART`的统计信息, 结果不是一个精确的快照
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#ifndef __INCLUDE_TRAP_TRAPSTAT_H
+#define __INCLUDE_TRAP_TRAPSTAT_H
+
+#include "types.h"
+#include "constrains.h"
+#include "trap/trapframe.h"
+
+
+/**
+ * @brief `trapstat_t`是一个`HART`上一个中断/异常号的统计信息
+ */
+typedef struct __trapstat_t {
+    /// @brief 发生的次数
+    uint64_t count;
+    /// @brief 总处理时间
+    uint64_t total;
+    /// @brief 最长处理时间
+    uint64_t max;
+    /// @brief 处理时间的直方图, 见`TRAPSTAT_BUCKET_NUM`
+    uint64_t buckets[TRAPSTAT_BUCKET_NUM];
+} trapstat_t;
+
+
+/**
+ * @brief `trapstat_table_t`是所有`HART`的陷入统计
+ */
+typedef struct __trapstat_table_t {
+    /// @brief 中断的统计信息
+    trapstat_t intr[MAX_CPU_NUM][TRAPSTAT_CAUSE_NUM];
+    /// @brief 异常的统计信息
+    trapstat_t excp[MAX_CPU_NUM][TRAPSTAT_CAUSE_NUM];
+} trapstat_table_t;
+
+
+/**
+ * @brief `trapstat_record`用于记录一次陷入的处理时间
+ *
+ * @param table 陷入统计
+ * @param hartid 当前`HART`的编号
+ * @param interrupt 是否是中断
+ * @param trap_code 中断/异常号, 不小于`TRAPSTAT_CAUSE_NUM`时不记录
+ * @param cycles 处理时间
+ *
+ * @note 调用时需要关闭中断
+ */
+void trapstat_record(trapstat_table_t *table, uint64_t hartid, Bool interrupt, uint64_t trap_code, uint64_t cycles);
+
+
+/**
+ * @brief `trapstat_dump`用于输出所有发生过的中断/异常的统计信息
+ *
+ * @param table 陷入统计
+ * @param intr_msg 中断的名字, 为NULL的项输出中断号
+ * @param excp_msg 异常的名字, 为NULL的项输出异常号
+ * @param unit 处理时间的单位
+ * @param print_func printf函数, 可以是: `bprintf`, `kprintf`
+ */
+void trapstat_dump(trapstat_table_t *table, const char **intr_msg, const char **excp_msg, const char *unit, printf_t print_func);
+
+
+#endif
@@ -0,0 +1,205 @@
+/**
+ * @file kaia.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `kaia.c`是`AIA`中断控制器内核部分的代码
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "io.h"
+#include "fdt.h"
+#include "asm/csr.h"
+#include "asm/plic.h"
+#include "kernel/kaia.h"
+#include "kernel/ksmp.h"
+#include "kernel/ktrace.h"
+#include "kernel/kstdio.h"
+
+// S模式APLIC中断域的基地址
+static addr_t kaia_aplic_base = 0;
+// 中断源的数量
+static uint32_t kaia_nr_sources = 0;
+// 中断文件支持的最大中断号
+static uint32_t kaia_nr_ids = 0;
+
+// 每个中断源分配到的中断号, 0表示没有分配
+static uint32_t kaia_source_eiid[PLIC_MAX_INTERRUPTS_NUM + 1];
+// 每个中断号对应的中断源, 0表示没有分配
+static uint32_t kaia_eiid_source[KAIA_MAX_EIID + 1];
+// 每个中断源的优先级, 决定分配的中断号
+static uint32_t kaia_source_priority[PLIC_MAX_INTERRUPTS_NUM + 1];
+
+
+Bool kaia_probe(addr_t dtb){
+    if (!fdt_check_header(dtb))
+        return False;
+
+    // 子中断域没有riscv,children属性
+    int64_t aplic = fdt_find_compatible(dtb, -1, "riscv,aplic");
+    while (aplic >= 0 && fdt_get_property(dtb, aplic, "riscv,children", NULL) != NULL)
+        aplic = fdt_find_compatible(dtb, aplic, "riscv,aplic");
+    // interrupts-extended由<phandle 中断号>组成, 中断号为S模式外部中断的是S模式的中断文件
+    int64_t imsic = fdt_find_compatible(dtb, -1, "riscv,imsics");
+    uint32_t irq;
+    while (imsic >= 0 && !(fdt_get_u32(dtb, imsic, "interrupts-extended", 1, &irq) && irq == CAUSE_INTERRUPT_S_EXTERNAL_INTERRUPT))
+        imsic = fdt_find_compatible(dtb, imsic, "riscv,imsics");
+    if (aplic < 0 || imsic < 0)
+        return False;
+
+    size_t size;
+    if (
+        !fdt_get_reg(dtb, aplic, 0, &kaia_aplic_base, &size) ||
+        !fdt_get_u32(dtb, aplic, "riscv,num-sources", 0, &kaia_nr_sources) ||
+        !fdt_get_u32(dtb, imsic, "riscv,num-ids", 0, &kaia_nr_ids)
+    )
+        return False;
+
+    // 内核页表只恒等映射了PLIC所在的MMIO区域, QEMU Virt的APLIC位于该区域中
+    if (kaia_aplic_base < PLIC_BASE_ADDR || kaia_aplic_base + size > PLIC_END_ADDR)
+        return False;
+    if (kaia_nr_sources > PLIC_MAX_INTERRUPTS_NUM)
+        kaia_nr_sources = PLIC_MAX_INTERRUPTS_NUM;
+    if (kaia_nr_ids > KAIA_MAX_EIID)
+        kaia_nr_ids = KAIA_MAX_EIID;
+    return True;
+}
+
+
+void kaia_init(void){
+    kprintf("KAIA Info:\n");
+    kprintf("\tAPLIC S-mode domain at %#lx, %u sources, %u interrupt identities\n", kaia_aplic_base, kaia_nr_sources, kaia_nr_ids);
+    // 配置期间关闭中断域
+    write_32_bits(kaia_aplic_base + APLIC_DOMAINCFG, 0);
+    // 关闭所有中断源, 后面由kirq_register开启
+    for (uint32_t src = 1; src <= kaia_nr_sources; src++){
+        write_32_bits(aplic_sourcecfg_addr(kaia_aplic_base, src), APLIC_SOURCECFG_SM_INACTIVE);
+        kaia_source_eiid[src] = 0;
+        kaia_source_priority[src] = KIRQ_DEFAULT_PRIORITY;
+    }
+    for (uint32_t eiid = 0; eiid <= KAIA_MAX_EIID; eiid++)
+        kaia_eiid_source[eiid] = 0;
+    // MSI模式
+    kprintf("\tSet APLIC delivery mode to MSI\n");
+    write_32_bits(kaia_aplic_base + APLIC_DOMAINCFG, APLIC_DOMAINCFG_IE | APLIC_DOMAINCFG_DM);
+}
+
+
+/**
+ * @brief `_kaia_alloc_eiid`为中断源`hwiid`分配一个空闲的中断号, 调用时持有`kirq`的锁
+ * 
+ * @return uint32_t 分配的中断号, 0表示没有空闲的中断号
+ * 
+ * @note 中断文件中中断号越小优先级越高, 因此将中断号按照优先级分为`KIRQ_MAX_PRIORITY`段, 优先使用中断源的优先级对应的段, 该段用完后使用任意空闲的中断号
+ */
+static uint32_t _kaia_alloc_eiid(uint32_t hwiid){
+    uint32_t band = kaia_nr_ids / KIRQ_MAX_PRIORITY;
+    uint32_t first = (KIRQ_MAX_PRIORITY - kaia_source_priority[hwiid]) * band + 1;
+    for (uint32_t pass = 0; pass < 2; pass++){
+        uint32_t lo = (pass == 0) ? first : 1;
+        uint32_t hi = (pass == 0) ? first + band - 1 : kaia_nr_ids;
+        for (uint32_t eiid = lo; eiid <= hi; eiid++){
+            if (kaia_eiid_source[eiid] == 0){
+                kaia_eiid_source[eiid] = hwiid;
+                kaia_source_eiid[hwiid] = eiid;
+                return eiid;
+            }
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief `_kaia_retrigger`在中断源`hwiid`的输入仍为高电平时重新发送`MSI`
+ * 
+ * @note `MSI`模式下电平触发的中断源只在输入变为高电平时发送一次`MSI`
+ */
+static void _kaia_retrigger(uint32_t hwiid){
+    if (read_32_bits(aplic_in_clrip_addr(kaia_aplic_base, hwiid)) & (1U << (hwiid % 32)))
+        write_32_bits(kaia_aplic_base + APLIC_SETIPNUM, hwiid);
+}
+
+
+/**
+ * @brief `_kaia_route`将中断源`hwiid`的`MSI`发送到`new_cpu`的中断文件, 第一次路由时分配中断号并启用中断源
+ */
+static void _kaia_route(uint32_t hwiid, uint64_t old_cpu, uint64_t new_cpu){
+    if (hwiid > kaia_nr_sources)
+        return;
+    uint32_t eiid = kaia_source_eiid[hwiid];
+    if (eiid == 0 && (eiid = _kaia_alloc_eiid(hwiid)) == 0){
+        kprintf("\tNo free interrupt identity for INTR_NO %u\n", hwiid);
+        return;
+    }
+    // 目前CPU编号就是HART编号, 也就是中断文件的下标
+    write_32_bits(aplic_target_addr(kaia_aplic_base, hwiid), (uint32_t) (new_cpu << APLIC_TARGET_HART_SHIFT) | eiid);
+    if (old_cpu >= MAX_CPU_NUM){
+        write_32_bits(aplic_sourcecfg_addr(kaia_aplic_base, hwiid), APLIC_SOURCECFG_SM_LEVEL_HIGH);
+        write_32_bits(kaia_aplic_base + APLIC_SETIENUM, hwiid);
+    }
+}
+
+
+/**
+ * @brief `_kaia_set_priority`设置中断源`hwiid`的优先级, 已经路由的中断源重新分配中断号
+ * 
+ * @note 以旧的中断号发送的`MSI`在认领时找不到中断源而被丢弃, 因此重新分配后输入仍为高电平时需要重新触发
+ */
+static void _kaia_set_priority(uint32_t hwiid, uint32_t priority){
+    if (hwiid > kaia_nr_sources)
+        return;
+    kaia_source_priority[hwiid] = priority;
+    uint32_t old = kaia_source_eiid[hwiid];
+    if (old == 0)
+        return;
+    kaia_eiid_source[old] = 0;
+    uint32_t eiid = _kaia_alloc_eiid(hwiid);
+    addr_t target = aplic_target_addr(kaia_aplic_base, hwiid);
+    write_32_bits(target, (read_32_bits(target) & ~APLIC_TARGET_EIID_MASK) | eiid);
+    _kaia_retrigger(hwiid);
+}
+
+
+/**
+ * @brief `_kaia_cpu_online`打开当前`HART`的S模式中断文件
+ * 
+ * @note 使能所有内核使用的中断号, 没有分配的中断号不会收到`MSI`
+ */
+static void _kaia_cpu_online(uint64_t cpu){
+    imsic_csr_write(IMSIC_EITHRESHOLD, 0);
+    // 0号中断号保留
+    imsic_csr_set(IMSIC_EIE0, ~1UL);
+    imsic_csr_write(IMSIC_EIDELIVERY, 1);
+}
+
+
+int64_t kaia_interrupt_handler(ktrapframe_t *ktf_ptr){
+    // 被打断的外部中断处理函数设置的阈值, 没有嵌套时为0
+    uint64_t threshold = imsic_csr_read(IMSIC_EITHRESHOLD);
+
+    uint32_t eiid;
+    while ((eiid = imsic_claim()) != 0){
+        uint32_t hwiid = (eiid <= KAIA_MAX_EIID) ? kaia_eiid_source[eiid] : 0;
+        KTRACE("imsic claim eiid=%u hwiid=%u", eiid, hwiid);
+        if (hwiid == 0)
+            continue;
+        // 处理期间只允许中断号更小, 即优先级更高的外部中断打断
+        imsic_csr_write(IMSIC_EITHRESHOLD, (threshold == 0 || eiid < threshold) ? eiid : threshold);
+        kirq_dispatch(hwiid);
+        imsic_csr_write(IMSIC_EITHRESHOLD, threshold);
+        // 处理之后仍为高电平时需要重新触发
+        _kaia_retrigger(hwiid);
+    }
+    return 0;
+}
+
+
+kirq_chip_t kaia_chip = {
+    .name = "AIA (APLIC + IMSIC)",
+    .route = _kaia_route,
+    .cpu_online = _kaia_cpu_online,
+    .set_priority = _kaia_set_priority,
+    .interrupt_handler = kaia_interrupt_handler
+};
@@ -0,0 +1,453 @@
+/**
+ * @file kconsole.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `kconsole.c`是内核控制台的实现
+ * @version 0.1
+ * @date 2023-06-04
+ *
+ * @note `UART`中断的处理函数只读出接收缓冲区(FIFO)和填充发送缓冲区, 行规程, 回显和输出内核日志推迟到`kconsole_tasklet`中完成
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "sbi/sbi.h"
+#include "asm/csr.h"
+#include "device/uart.h"
+#include "kernel/klog.h"
+#include "kernel/ktrap.h"
+#include "kernel/locks.h"
+#include "kernel/ktrace.h"
+#include "kernel/kconsole.h"
+#include "kernel/kcounter.h"
+#include "kernel/ksoftirq.h"
+#include "kernel/kirq.h"
+
+// 发送环形缓冲区, head是下一个写入的位置, tail是下一个发送的位置
+static char tx_ring[KCONSOLE_TX_RING_SIZE];
+static uint64_t volatile tx_head = 0;
+static uint64_t volatile tx_tail = 0;
+
+// 是否打开了THRE中断, 即发送环形缓冲区中是否有字符正在等待发送
+static Bool volatile tx_active = False;
+
+// 控制台是否已经初始化
+static Bool volatile kconsole_ready = False;
+
+// 原始接收环形缓冲区, 保存中断中读出但还没有经过行规程处理的字符
+static char rx_raw[KCONSOLE_RX_RAW_SIZE];
+static uint64_t volatile raw_head = 0;
+static uint64_t volatile raw_tail = 0;
+
+// 接收环形缓冲区, 保存经过行规程处理后可以被读取的字符
+static char rx_ring[KCONSOLE_RX_RING_SIZE];
+static uint64_t volatile rx_head = 0;
+static uint64_t volatile rx_tail = 0;
+
+// 规范模式下正在编辑的行
+static char line_buf[KCONSOLE_LINE_SIZE];
+static size_t line_len = 0;
+
+// 行规程, 默认为回显的规范模式
+static kconsole_discipline_t discipline = {
+    .canonical = True,
+    .echo = True,
+    .threshold = KCONSOLE_LINE_SIZE
+};
+
+// 行规程处理的控制字符
+#define CHAR_BACKSPACE      0x08        // Ctrl+H, Backspace
+#define CHAR_DELETE         0x7F        // Delete, 大多数终端的Backspace键发送该字符
+#define CHAR_KILL           0x15        // Ctrl+U, 删除整行
+#define CHAR_TRACE_DUMP     0x14        // Ctrl+T, 输出跟踪缓冲区
+#define CHAR_LOCKSTAT_DUMP  0x0C        // Ctrl+L, 输出锁的竞争统计信息, 内核计数器和陷入统计
+
+
+// 控制台的锁, 保护发送/接收环形缓冲区, 行规程和`UART`的寄存器. 获取时关闭中断
+static spinlock_t kconsole_lock = {.next = 0, .owner = 0, .name = "kconsole lock"};
+
+// 是否需要在释放控制台的锁之后输出跟踪缓冲区/锁的竞争统计信息
+static Bool volatile trace_dump_pending = False;
+static Bool volatile lockstat_dump_pending = False;
+
+// 发送环形缓冲区已空, 需要继续输出内核日志
+static Bool volatile drain_pending = False;
+
+// 原始接收环形缓冲区满时丢弃的字符数
+static kcounter_t rx_dropped_counter = KCOUNTER_INIT("kconsole: rx dropped");
+
+static void _kconsole_work(ktasklet_t *tasklet);
+
+// 控制台的推迟工作
+static ktasklet_t kconsole_tasklet = KTASKLET_INIT("kconsole", _kconsole_work);
+
+
+/**
+ * @brief `_kconsole_tx_fill`在`UART`的FIFO为空时, 从发送环形缓冲区向FIFO写入至多`UART_FIFO_SIZE`个字符
+ *
+ * @note 调用时需要关闭中断. 发送环形缓冲区为空时关闭THRE中断
+ */
+static void _kconsole_tx_fill(void){
+    if ((read_8_bits(UART_LSR) & UART_LSR_THE) == 0)
+        return;
+    size_t count = 0;
+    while (tx_tail != tx_head && count < UART_FIFO_SIZE){
+        write_8_bits(UART_THR, tx_ring[tx_tail & (KCONSOLE_TX_RING_SIZE - 1)]);
+        tx_tail++, count++;
+    }
+    if (tx_tail == tx_head && tx_active){
+        uart_set_interrupt(UART_IER_THRI, False);
+        tx_active = False;
+    }
+}
+
+
+/**
+ * @brief `_kconsole_enqueue`向发送环形缓冲区写入至多`len`个字符, 并打开THRE中断
+ *
+ * @note 调用时需要关闭中断
+ */
+static size_t _kconsole_enqueue(const char *buf, size_t len){
+    size_t count = 0;
+    while (count < len && tx_head - tx_tail < KCONSOLE_TX_RING_SIZE){
+        tx_ring[tx_head & (KCONSOLE_TX_RING_SIZE - 1)] = buf[count++];
+        tx_head++;
+    }
+    if (count != 0 && !tx_active){
+        // FIFO为空时直接写入, 此后由THRE中断继续发送
+        tx_active = True;
+        uart_set_interrupt(UART_IER_THRI, True);
+        _kconsole_tx_fill();
+    }
+    return count;
+}
+
+
+/**
+ * @brief `_kconsole_echo`在回显打开时向发送环形缓冲区写入字符串
+ *
+ * @note 调用时需要关闭中断. 发送环形缓冲区满时回显的字符将被丢弃
+ */
+static void _kconsole_echo(const char *str, size_t len){
+    if (discipline.echo)
+        _kconsole_enqueue(str, len);
+}
+
+
+/**
+ * @brief `_kconsole_commit`将`len`个字符放入接收环形缓冲区
+ *
+ * @param reserve 接收环形缓冲区需要额外保留的空间
+ * @return Bool 接收环形缓冲区空间不足时返回False, 此时不会放入任何字符
+ *
+ * @note 调用时需要关闭中断
+ */
+static Bool _kconsole_commit(const char *buf, size_t len, size_t reserve){
+    if (KCONSOLE_RX_RING_SIZE - (rx_head - rx_tail) < len + reserve)
+        return False;
+    for (size_t i = 0; i < len; i++){
+        rx_ring[rx_head & (KCONSOLE_RX_RING_SIZE - 1)] = buf[i];
+        rx_head++;
+    }
+    return True;
+}
+
+
+/**
+ * @brief `_kconsole_receive_char`使用行规程处理接收到的一个字符
+ *
+ * @note 调用时需要关闭中断
+ */
+static void _kconsole_receive_char(char c){
+    // 终端的回车键发送的是\r
+    if (c == '\r')
+        c = '\n';
+
+    if (!discipline.canonical){
+        if (_kconsole_commit(&c, 1, 0))
+            _kconsole_echo(&c, 1);
+        return;
+    }
+
+    switch (c){
+        case CHAR_BACKSPACE:
+        case CHAR_DELETE:
+            if (line_len > 0){
+                line_len--;
+                _kconsole_echo("\b \b", 3);
+            }
+            break;
+        case CHAR_TRACE_DUMP:
+            // 输出跟踪缓冲区需要获取控制台的锁, 因此在释放锁之后进行
+            trace_dump_pending = True;
+            break;
+        case CHAR_LOCKSTAT_DUMP:
+            lockstat_dump_pending = True;
+            break;
+        case CHAR_KILL:
+            while (line_len > 0){
+                line_len--;
+                _kconsole_echo("\b \b", 3);
+            }
+            break;
+        default:
+            line_buf[line_len++] = c;
+            _kconsole_echo(&c, 1);
+            if (c == '\n'){
+                // 接收环形缓冲区总是为'\n'保留一个位置, 放不下整行时丢弃行尾的字符, 保证读者一定能读到行尾
+                size_t space = KCONSOLE_RX_RING_SIZE - (rx_head - rx_tail);
+                if (space > 0 && line_len > space){
+                    kcounter_add(&rx_dropped_counter, line_len - space);
+                    line_buf[space - 1] = '\n';
+                    line_len = space;
+                }
+                // 只有从原始模式切换过来时接收环形缓冲区才可能被占满
+                if (!_kconsole_commit(line_buf, line_len, 0))
+                    kcounter_add(&rx_dropped_counter, line_len);
+                line_len = 0;
+            }
+            // 行长度达到阈值时提交该行, 接收环形缓冲区满时保留该行, 等待读者腾出空间
+            else if ((line_len >= discipline.threshold || line_len == KCONSOLE_LINE_SIZE)
+                && _kconsole_commit(line_buf, line_len, 1))
+                line_len = 0;
+            // 行缓冲区已满且无法提交, 丢弃最后一个字符
+            else if (line_len == KCONSOLE_LINE_SIZE){
+                kcounter_inc(&rx_dropped_counter);
+                line_len--;
+            }
+            break;
+    }
+}
+
+
+/**
+ * @brief `_kconsole_receive`读空`UART`的接收缓冲区(FIFO), 将字符放入原始接收环形缓冲区, 由`kconsole_tasklet`交给行规程处理
+ *
+ * @note 调用时需要关闭中断. 原始接收环形缓冲区满时仍然读空FIFO并丢弃字符, 否则接收中断会一直触发
+ */
+static void _kconsole_receive(void){
+    char buf[UART_FIFO_SIZE];
+    size_t count;
+    while ((count = uart_rx_drain(buf, UART_FIFO_SIZE)) != 0){
+        for (size_t i = 0; i < count; i++){
+            if (raw_head - raw_tail == KCONSOLE_RX_RAW_SIZE){
+                kcounter_inc(&rx_dropped_counter);
+                continue;
+            }
+            rx_raw[raw_head & (KCONSOLE_RX_RAW_SIZE - 1)] = buf[i];
+            raw_head++;
+        }
+    }
+}
+
+
+/**
+ * @brief `_kconsole_run_pending`运行行规程推迟的操作
+ *
+ * @note 调用时不能持有控制台的锁
+ */
+static void _kconsole_run_pending(void){
+    if (trace_dump_pending){
+        trace_dump_pending = False;
+        // 调试用, 以轮询方式输出, 输出期间当前CPU不会运行其他tasklet
+        ktrace_dump();
+    }
+    if (lockstat_dump_pending){
+        lockstat_dump_pending = False;
+        lockstat_dump();
+        kcounter_dump();
+        ktrap_stat_dump();
+        // SBI的陷入统计直接输出到串口, 先输出控制台中已有的字符
+        kconsole_flush();
+        sbi_trapstat_dump();
+    }
+}
+
+
+void kconsole_init(void){
+    tx_head = tx_tail = 0;
+    tx_active = False;
+    rx_head = rx_tail = 0;
+    line_len = 0;
+    raw_head = raw_tail = 0;
+    kconsole_ready = True;
+    kcounter_register(&rx_dropped_counter);
+    lockstat_register(&kconsole_lock);
+    // 注册UART0中断, 由内核分配处理的CPU
+    kirq_register(UART0_INTERRUPT, "UART0", kconsole_interrupt_handler, KIRQ_AFFINITY_AUTO);
+    // 打开接收中断
+    uart_set_interrupt(UART_IER_RDI, True);
+}
+
+
+size_t kconsole_try_write(const char *buf, size_t len){
+    if (!kconsole_ready)
+        return uart_fifo_write(buf, len);
+    Bool enabled = spinlock_acquire_irqsave(&kconsole_lock);
+    size_t count = _kconsole_enqueue(buf, len);
+    spinlock_release_irqrestore(&kconsole_lock, enabled);
+    return count;
+}
+
+
+size_t kconsole_write(const char *buf, size_t len){
+    if (!kconsole_ready){
+        for (size_t i = 0; i < len; i++)
+            uart_put(buf[i]);
+        return len;
+    }
+    size_t written = 0;
+    while (True){
+        Bool enabled = spinlock_acquire_irqsave(&kconsole_lock);
+        written += _kconsole_enqueue(buf + written, len - written);
+        if (written == len){
+            spinlock_release_irqrestore(&kconsole_lock, enabled);
+            break;
+        }
+        // 发送环形缓冲区已满, 中断关闭时只能轮询等待FIFO为空
+        if (!enabled){
+            while ((read_8_bits(UART_LSR) & UART_LSR_THE) == 0);
+            _kconsole_tx_fill();
+        }
+        spinlock_release_irqrestore(&kconsole_lock, enabled);
+        // 等待THRE中断腾出空间
+        if (enabled)
+            asm volatile("wfi");
+    }
+    return len;
+}
+
+
+void kconsole_flush(void){
+    Bool enabled = spinlock_acquire_irqsave(&kconsole_lock);
+    while (tx_tail != tx_head){
+        while ((read_8_bits(UART_LSR) & UART_LSR_THE) == 0);
+        _kconsole_tx_fill();
+    }
+    spinlock_release_irqrestore(&kconsole_lock, enabled);
+}
+
+
+void kconsole_panic_flush(void){
+    // 不获取锁, 持有锁的CPU已经不会再运行, 其他CPU最多和这里交错输出一部分字符
+    while (tx_tail != tx_head){
+        uart_put(tx_ring[tx_tail & (KCONSOLE_TX_RING_SIZE - 1)]);
+        tx_tail++;
+    }
+}
+
+
+/**
+ * @brief `_kconsole_process_raw`使用行规程处理原始接收环形缓冲区中的字符
+ *
+ * @param budget 最多处理的字符数
+ * @return Bool 原始接收环形缓冲区中还有字符时返回True
+ *
+ * @note 调用时需要持有控制台的锁
+ */
+static Bool _kconsole_process_raw(size_t budget){
+    while (raw_tail != raw_head && budget > 0){
+        _kconsole_receive_char(rx_raw[raw_tail & (KCONSOLE_RX_RAW_SIZE - 1)]);
+        raw_tail++, budget--;
+    }
+    return raw_tail != raw_head;
+}
+
+
+/**
+ * @brief `_kconsole_work`是控制台的推迟工作, 使用行规程处理原始接收环形缓冲区中的字符, 并继续输出内核日志
+ *
+ * @note 每次最多处理`KCONSOLE_RX_BUDGET`个字符, 还有剩余时重新调度自己, 以限制持有控制台的锁的时间
+ */
+static void _kconsole_work(ktasklet_t *tasklet){
+    Bool enabled = spinlock_acquire_irqsave(&kconsole_lock);
+    Bool more = _kconsole_process_raw(KCONSOLE_RX_BUDGET);
+    Bool drain = drain_pending;
+    drain_pending = False;
+    spinlock_release_irqrestore(&kconsole_lock, enabled);
+
+    if (more)
+        ktasklet_schedule(tasklet);
+    // 输出日志和跟踪缓冲区时会重新获取控制台的锁
+    if (drain)
+        klog_drain();
+    _kconsole_run_pending();
+}
+
+
+void kconsole_interrupt_handler(void){
+    Bool defer = False;
+    Bool enabled = spinlock_acquire_irqsave(&kconsole_lock);
+    uint8_t status;
+    while ((status = uart_interrupt_status()) != UART_ISR_NO_INTERRUPT){
+        switch (status){
+            case UART_ISR_THRE:
+                _kconsole_tx_fill();
+                // 发送环形缓冲区已空, 继续输出内核日志
+                if (tx_tail == tx_head)
+                    drain_pending = defer = True;
+                break;
+            case UART_ISR_RDA:
+            case UART_ISR_TIMEOUT:
+                _kconsole_receive();
+                defer = True;
+                break;
+            case UART_ISR_RLS:
+                read_8_bits(UART_LSR);
+                break;
+            default:
+                read_8_bits(UART_MSR);
+                break;
+        }
+    }
+    spinlock_release_irqrestore(&kconsole_lock, enabled);
+
+    // 连续到来的中断只调度一次, 由tasklet一并处理
+    if (defer)
+        ktasklet_schedule(&kconsole_tasklet);
+}
+
+
+void kconsole_set_discipline(const kconsole_discipline_t *new_discipline){
+    Bool enabled = spinlock_acquire_irqsave(&kconsole_lock);
+    // 切换到原始模式时提交正在编辑的行
+    if (discipline.canonical && !new_discipline->canonical && line_len > 0 && _kconsole_commit(line_buf, line_len, 0))
+        line_len = 0;
+    discipline = *new_discipline;
+    if (discipline.threshold == 0)
+        discipline.threshold = 1;
+    spinlock_release_irqrestore(&kconsole_lock, enabled);
+}
+
+
+size_t kconsole_read(char *buf, size_t len){
+    if (len == 0)
+        return 0;
+    while (True){
+        Bool enabled = spinlock_acquire_irqsave(&kconsole_lock);
+        size_t available = rx_head - rx_tail;
+        // 规范模式下接收环形缓冲区中只有已提交的行, 有字符即可读取
+        size_t need = discipline.canonical ? 1 : (discipline.threshold < len ? discipline.threshold : len);
+        if (available >= need){
+            size_t count = 0;
+            while (count < len && rx_tail != rx_head){
+                char c = rx_ring[rx_tail & (KCONSOLE_RX_RING_SIZE - 1)];
+                rx_tail++;
+                buf[count++] = c;
+                if (discipline.canonical && c == '\n')
+                    break;
+            }
+            spinlock_release_irqrestore(&kconsole_lock, enabled);
+            return count;
+        }
+        // 中断关闭时kconsole_tasklet不会运行, 轮询接收字符后直接使用行规程处理
+        if (!enabled){
+            _kconsole_receive();
+            _kconsole_process_raw(KCONSOLE_RX_RAW_SIZE);
+        }
+        spinlock_release_irqrestore(&kconsole_lock, enabled);
+        _kconsole_run_pending();
+        // 等待接收中断
+        if (enabled)
+            asm volatile("wfi");
+    }
+}
@@ -11,27 +11,66 @@
 #include "device/ddr.h"
 #include "device/uart.h"
 #include "kernel/mm.h"
+#include "kernel/rcu.h"
+#include "kernel/klog.h"
 #include "kernel/ktrap.h"
 #include "kernel/kinit.h"
-#include "kernel/kplic.h"
+#include "kernel/ksmp.h"
+#include "kernel/kconsole.h"
+#include "kernel/kirq.h"
 #include "kernel/ktimer.h"
 #include "kernel/kstdio.h"
+#include "kernel/ksoftirq.h"
 #include "kernel/paging.h"
+#include "sbi/sbi.h"
 
 // _e_kernel是内存中的内核映像结束地址
 extern char _e_kernel[];
 
 #define INIT_DONE   kprintf("\tDone!\n");
 
-void kinit_all(void){
+
+/**
+ * @brief `_kinit_sbi_info`输出`SBI`的版本和实现, 以及内核需要的标准扩展是否可用, 便于和`OpenSBI`对比
+ */
+static void _kinit_sbi_info(void){
+    int64_t version = sbi_get_spec_version();
+    int64_t impl = sbi_get_impl_id();
+    kprintf("\tSBI v%ld.%ld, implementation: %s (%ld)\n", (version >> 24) & 0x7F, version & 0xFFFFFF,
+            impl == SBI_IMPL_ID_X2W ? "X2W-OS" : (impl == SBI_IMPL_ID_OPENSBI ? "OpenSBI" : "Unknown"), impl);
+    if (!sbi_probe_extension(SBI_EXT_TIME) || !sbi_probe_extension(SBI_EXT_IPI) || !sbi_probe_extension(SBI_EXT_HSM))
+        kprintf("\tWarning: SBI lacks TIME/IPI/HSM extension\n");
+    if (!sbi_probe_extension(SBI_EXT_DBCN))
+        kprintf("\tWarning: SBI lacks DBCN extension, sbi_putc/sbi_puts will not work\n");
+}
+
+void kinit_all(addr_t dtb){
+    kprintf("=> sbi_info\n");
+    _kinit_sbi_info();
+    INIT_DONE;
+    kprintf("=> klog_init\n");
+    klog_init();
+    INIT_DONE;
     kprintf("=> ktrap_init\n");
     ktrap_init();
     INIT_DONE;
-    kprintf("=> kplic_init\n");
-    kplic_init();
+    kprintf("=> ksoftirq_init\n");
+    ksoftirq_init();
+    INIT_DONE;
+    kprintf("=> kirq_init\n");
+    kirq_init(dtb);
+    INIT_DONE;
+    kprintf("=> kconsole_init\n");
+    kconsole_init();
+    INIT_DONE;
+    kprintf("=> rcu_init\n");
+    rcu_init();
     INIT_DONE;
     kprintf("=> ktimer_init\n");
-    ktimer_init();
+    ktimer_init(dtb);
+    INIT_DONE;
+    kprintf("=> smp_init\n");
+    smp_init(dtb);
     INIT_DONE;
     kprintf("=> memory_init\n");
     memory_init((addr_t) _e_kernel, DDR_END_ADDR);
@@ -39,4 +78,7 @@ void kinit_all(void){
     kprintf("=> paging_init\n");
     paging_init();
     INIT_DONE;
+    kprintf("=> smp_boot_secondary\n");
+    smp_boot_secondary();
+    INIT_DONE;
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+/**
+ * @file kirq.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `kirq.c`是内核外部中断管理模块的实现
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @note `kirq`只维护中断注册表和每个中断的目标`CPU`, 具体的路由由中断控制器(`kplic.c`/`kaia.c`)完成.
+ *      亲和性为`KIRQ_AFFINITY_AUTO`的中断在`CPU`上线时重新轮流分配到所有在线的`CPU`上
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "asm/csr.h"
+#include "kernel/kirq.h"
+#include "kernel/kaia.h"
+#include "kernel/ksmp.h"
+#include "kernel/kplic.h"
+#include "kernel/ktrap.h"
+#include "kernel/locks.h"
+#include "kernel/kstdio.h"
+#include "kernel/kdebug.h"
+
+// 当前使用的中断控制器
+static kirq_chip_t *kirq_chip = NULL;
+
+// 外部中断注册表, 下标为硬件中断号, 0号中断不存在
+static kirq_desc_t kirq_descs[PLIC_MAX_INTERRUPTS_NUM + 1];
+
+// 保护注册表和中断的路由, 修改中断的亲和性时需要先获取
+static spinlock_t kirq_lock = {.next = 0, .owner = 0, .name = "kirq lock"};
+
+// 下一个自动分配的中断分配到的CPU
+static uint64_t kirq_next_cpu = 0;
+
+
+void kirq_init(addr_t dtb){
+    lockstat_register(&kirq_lock);
+    for (int hwiid = 0; hwiid <= PLIC_MAX_INTERRUPTS_NUM; hwiid++){
+        kirq_descs[hwiid].name = NULL;
+        kirq_descs[hwiid].handler = NULL;
+        kirq_descs[hwiid].cpu = MAX_CPU_NUM;
+        kirq_descs[hwiid].auto_affinity = False;
+        kirq_descs[hwiid].priority = KIRQ_DEFAULT_PRIORITY;
+    }
+
+    // 优先使用AIA, 否则回退到PLIC
+    if (kaia_probe(dtb)){
+        kaia_init();
+        kirq_chip = &kaia_chip;
+    } else {
+        kplic_init();
+        kirq_chip = &kplic_chip;
+    }
+    kirq_chip->cpu_online(cpu_id());
+    kprintf("KIRQ Info:\n");
+    kprintf("\tUsing %s interrupt controller\n", kirq_chip->name);
+
+    // 为S模式下的外部中断注册中断处理函数
+    register_ktrap_handler(CAUSE_INTERRUPT_S_EXTERNAL_INTERRUPT, True, "Supervisor External Interrupt", kirq_interrupt_handler);
+    // 打开外部中断总开关
+    kprintf("\tSet Software External Interrupt (SEIE) of sie\n");
+    set_csr(sie, SIE_S_EXTERNAL_INTERRUPT);
+}
+
+
+/**
+ * @brief `_kirq_pick_cpu`从在线的`CPU`中轮流选择一个`CPU`, 调用时需要持有`kirq_lock`
+ *
+ * @return uint64_t 选中的`CPU`
+ */
+static uint64_t _kirq_pick_cpu(void){
+    uint64_t online = __atomic_load_n(&cpu_online_mask, __ATOMIC_ACQUIRE);
+    // 初始化时当前CPU可能还没有标记为在线
+    if (online == 0)
+        return cpu_id();
+    for (uint64_t i = 0; i < MAX_CPU_NUM; i++){
+        uint64_t cpu = kirq_next_cpu;
+        kirq_next_cpu = (kirq_next_cpu + 1) % MAX_CPU_NUM;
+        if (online & (1UL << cpu))
+            return cpu;
+    }
+    return cpu_id();
+}
+
+
+/**
+ * @brief `_kirq_route`将中断`hwiid`路由到`cpu`, 调用时需要持有`kirq_lock`
+ *
+ * @param desc 中断的注册信息
+ * @param hwiid 硬件中断号
+ * @param cpu 目标`CPU`
+ */
+static void _kirq_route(kirq_desc_t *desc, uint32_t hwiid, uint64_t cpu){
+    if (desc->cpu == cpu)
+        return;
+    kirq_chip->route(hwiid, desc->cpu, cpu);
+    desc->cpu = cpu;
+}
+
+
+int64_t kirq_register(uint32_t hwiid, const char *name, kirq_handler_t handler, int64_t cpu){
+    if (hwiid == 0 || hwiid > PLIC_MAX_INTERRUPTS_NUM || handler == NULL)
+        return -1;
+    if (cpu != KIRQ_AFFINITY_AUTO && (cpu < 0 || cpu >= MAX_CPU_NUM))
+        return -1;
+
+    spinlock_acquire(&kirq_lock);
+    kirq_desc_t *desc = &kirq_descs[hwiid];
+    if (desc->handler != NULL){
+        spinlock_release(&kirq_lock);
+        return -1;
+    }
+    desc->name = name;
+    desc->auto_affinity = (cpu == KIRQ_AFFINITY_AUTO);
+    // 先设置处理函数再路由, 收到中断时处理函数一定已经可见
+    __atomic_store_n(&desc->handler, handler, __ATOMIC_RELEASE);
+    _kirq_route(desc, hwiid, desc->auto_affinity ? _kirq_pick_cpu() : (uint64_t) cpu);
+    uint64_t target = desc->cpu;
+    spinlock_release(&kirq_lock);
+    kprintf("\tRoute %s (INTR_NO %u) to CPU %lu\n", name, hwiid, target);
+    return 0;
+}
+
+
+int64_t kirq_set_affinity(uint32_t hwiid, int64_t cpu){
+    if (hwiid == 0 || hwiid > PLIC_MAX_INTERRUPTS_NUM)
+        return -1;
+    if (cpu != KIRQ_AFFINITY_AUTO && (cpu < 0 || cpu >= MAX_CPU_NUM))
+        return -1;
+
+    spinlock_acquire(&kirq_lock);
+    kirq_desc_t *desc = &kirq_descs[hwiid];
+    if (desc->handler == NULL){
+        spinlock_release(&kirq_lock);
+        return -1;
+    }
+    desc->auto_affinity = (cpu == KIRQ_AFFINITY_AUTO);
+    _kirq_route(desc, hwiid, desc->auto_affinity ? _kirq_pick_cpu() : (uint64_t) cpu);
+    spinlock_release(&kirq_lock);
+    return 0;
+}
+
+
+int64_t kirq_set_priority(uint32_t hwiid, uint32_t priority){
+    if (hwiid == 0 || hwiid > PLIC_MAX_INTERRUPTS_NUM)
+        return -1;
+    if (priority == 0 || priority > KIRQ_MAX_PRIORITY)
+        return -1;
+
+    spinlock_acquire(&kirq_lock);
+    kirq_descs[hwiid].priority = priority;
+    kirq_chip->set_priority(hwiid, priority);
+    spinlock_release(&kirq_lock);
+    return 0;
+}
+
+
+void kirq_cpu_online(uint64_t cpu){
+    kirq_chip->cpu_online(cpu);
+    // 重新轮流分配所有自动分配的中断
+    spinlock_acquire(&kirq_lock);
+    kirq_next_cpu = 0;
+    for (uint32_t hwiid = 1; hwiid <= PLIC_MAX_INTERRUPTS_NUM; hwiid++){
+        kirq_desc_t *desc = &kirq_descs[hwiid];
+        if (desc->handler != NULL && desc->auto_affinity)
+            _kirq_route(desc, hwiid, _kirq_pick_cpu());
+    }
+    spinlock_release(&kirq_lock);
+}
+
+
+int64_t kirq_interrupt_handler(ktrapframe_t *ktf_ptr){
+    return kirq_chip->interrupt_handler(ktf_ptr);
+}
+
+
+// 外部中断信息表, 取决于硬件制造商, 这里用的是QEMU Virt模拟的开发板
+const char *plic_intr_msg[PLIC_MAX_INTERRUPTS_NUM] = {
+    [0] = "Error",
+    [1 ... 8] = "VIRTIO_IRQ Interrupt",
+    [9] = "Error",
+    [10] = "UART0 Interrupt",
+    [11] = "RTC Interrupt",
+    [32 ... 35] = "PCIe Interrupt"
+};
+
+
+void kirq_dispatch(uint32_t hwiid){
+    // 外部中断在中断栈上嵌套, 打开中断前检查中断栈是否即将溢出
+    kirq_stack_t *stack = this_cpu_ptr(ktrap_irq_stack);
+    addr_t sp;
+    asm volatile("mv %0, sp" : "=r"(sp));
+    ASSERT(*(uint64_t *) stack->bottom == KIRQ_STACK_CANARY, "IRQ stack canary corrupted");
+    ASSERT(sp < stack->bottom || sp > stack->top || sp >= stack->bottom + KIRQ_STACK_RESERVE, "IRQ stack overflow");
+
+    kirq_handler_t handler = NULL;
+    if (hwiid <= PLIC_MAX_INTERRUPTS_NUM)
+        handler = __atomic_load_n(&kirq_descs[hwiid].handler, __ATOMIC_ACQUIRE);
+    if (handler != NULL){
+        // 中断控制器已经屏蔽了优先级不高于hwiid的外部中断, 打开中断后只有更紧急的中断可以打断处理函数
+        supervisor_interrupt_enable();
+        handler();
+        supervisor_interrupt_disable();
+    } else
+        kprintf("Unhandled INTR_NO %u (%s) on CPU %lu\n", hwiid, (hwiid < PLIC_MAX_INTERRUPTS_NUM && plic_intr_msg[hwiid] != NULL) ? plic_intr_msg[hwiid] : "Unknown", cpu_id());
+}
@@ -14,11 +14,13 @@
 #include "device/uart.h"
 #include "kernel/ktrap.h"
 #include "kernel/kmain.h"
+#include "kernel/klog.h"
 #include "kernel/kinit.h"
 #include "kernel/kdebug.h"
 #include "kernel/kstdio.h"
+#include "kernel/ksoftirq.h"
 
-void kernel_main(void){
+void kernel_main(uint64_t hartid, addr_t dtb){
     kprintf(DELIMITER);
     kprintf("In kernel!\n");
     kprintf("Kernel init!\n");
@@ -27,7 +29,7 @@ void kernel_main(void){
 	print_kmem();
 
 	// 初始化内核
-    kinit_all();
+    kinit_all(dtb);
 
     kprintf("Start testing!\n");
 	// 测试库文件
@@ -38,11 +40,16 @@ void kernel_main(void){
     kprintf("local_interrupt_enable\n");
 	// 打开S模式下所有中断
     supervisor_interrupt_enable();
+	// 时钟中断已经打开, 日志改为由时钟中断异步输出
+	klog_set_mode(KLOG_MODE_ASYNC);
 
 	addr_t unmapped_addr = DDR_END_ADDR + 4096;
 	*(uint64_t *) unmapped_addr = 0x55;
 	kprintf("Done");
-    while (1);
+    while (1){
+        ksoftirq_run();
+        asm volatile("wfi");
+    }
 }
 
 void print_kmem(void){
@@ -5,21 +5,27 @@
  * @version 0.1
  * @date 2023-05-13
  * 
+ * @note 每个外部中断只在一个`CPU`的S模式上下文中使能, 因此只有该`CPU`会收到并处理这个中断. 中断的注册和分配见`kirq.c`
+ * @note 处理中断期间将上下文的优先级阈值提高到该中断的优先级, 只有优先级更高的中断可以嵌套
+ * 
  * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
  */
 
 #include "io.h"
+#include "kernel/kirq.h"
+#include "kernel/ksmp.h"
 #include "kernel/kplic.h"
 #include "kernel/ktrap.h"
+#include "kernel/locks.h"
+#include "kernel/ktrace.h"
 #include "kernel/kstdio.h"
 
-// 外部中断号
-typedef enum __plic_interrupt_id_t {
-    UART0_INTERRUPT = 10
-} plic_interrupt_id_t;
+// 每个中断源使能在哪个CPU的S模式上下文中, 为MAX_CPU_NUM表示没有使能
+static uint64_t kplic_irq_cpu[PLIC_MAX_INTERRUPTS_NUM + 1];
+
+// 保护中断使能寄存器和kplic_irq_cpu
+static spinlock_t kplic_lock = {.next = 0, .owner = 0, .name = "kplic lock"};
 
-// SiFive FU740第0个核监控用, 不处理外部中断, 所以这里+1自动跳过
-#define CPU_TO_HART(cid) ((cid) + 1)
 
 void kplic_set_priority(uint32_t hwiid, uint32_t priority){
     // 获得中断编号为hwiid的中断优先级寄存器的地址
@@ -30,12 +36,15 @@ void kplic_set_priority(uint32_t hwiid, uint32_t priority){
     write_32_bits(reg_addr, priority);
 }
 
+void kplic_set_threshold(uint64_t cid, uint32_t threshold){
+    write_32_bits(plic_threshold_addr(plic_context_id(cid, False)), threshold);
+}
+
 void kplic_enable_interrupt(uint64_t cid, uint32_t hwiid, Bool enable, Bool m_mode){
     // PLIC每个寄存器32位, 先计算中断编号为hwiid在中断使能寄存器的的mask, 后面位操作用
     uint32_t hwiid_mask = 1 << (hwiid % 32);
-    int hart_id = CPU_TO_HART(cid);
     // 计算hwiid的中断使能寄存器的MMIO地址
-    addr_t reg_addr = plic_enable_addr(hart_id, m_mode) + 4 * (hwiid / 32);
+    addr_t reg_addr = plic_enable_addr(plic_context_id(cid, m_mode)) + 4 * (hwiid / 32);
     // Debug, 输出到屏幕上
     // kprintf(
     //     "%s Hardware Interrrupt ID: %3d at %#16X\n", 
@@ -47,7 +56,32 @@ void kplic_enable_interrupt(uint64_t cid, uint32_t hwiid, Bool enable, Bool m_mo
         write_32_bits(reg_addr, read_32_bits(reg_addr) & ~hwiid_mask);
 }
 
+
+/**
+ * @brief `_kplic_route`将中断`hwiid`从`old_cpu`的S模式上下文迁移到`new_cpu`的S模式上下文
+ *
+ * @note 先使能新的`CPU`再关闭旧的`CPU`, 中断在切换期间不会丢失
+ */
+static void _kplic_route(uint32_t hwiid, uint64_t old_cpu, uint64_t new_cpu){
+    spinlock_acquire(&kplic_lock);
+    kplic_enable_interrupt(new_cpu, hwiid, True, False);
+    if (old_cpu < MAX_CPU_NUM && old_cpu != new_cpu)
+        kplic_enable_interrupt(old_cpu, hwiid, False, False);
+    __atomic_store_n(&kplic_irq_cpu[hwiid], new_cpu, __ATOMIC_RELEASE);
+    spinlock_release(&kplic_lock);
+}
+
+
+/**
+ * @brief `_kplic_cpu_online`设置上线的`CPU`的中断优先级阈值为0, 即不屏蔽任何外部设备
+ */
+static void _kplic_cpu_online(uint64_t cpu){
+    kplic_set_threshold(cpu, 0);
+}
+
+
 void kplic_init(void){
+    lockstat_register(&kplic_lock);
     kprintf("KPLIC Info:");
     kprintf("\tSet priority off INTR_NO %d~%d to 1\n", 1, PLIC_MAX_INTERRUPTS_NUM);
     // 设置所有中断的优先级为1
@@ -58,59 +92,88 @@ void kplic_init(void){
     kprintf("\tSet Interrupt Priority Threshold Register of all CPU to 0\n");
     for (int cpu_id = 0; cpu_id < MAX_CPU_NUM; cpu_id++){
         // 设置该核心的中断优先级阈值寄存器为0, 即不屏蔽任何外部设备
-        write_32_bits(plic_threshold_addr(CPU_TO_HART(cpu_id), True), 0);
-        // 设置改核心不使能任何外部设备中断, 即不响应任何外部设备的中断, 后面手动开启
+        kplic_set_threshold(cpu_id, 0);
+        // 设置改核心不使能任何外部设备中断, 即不响应任何外部设备的中断, 后面由kirq_register开启
         for (int hwiid = 1; hwiid <= PLIC_MAX_INTERRUPTS_NUM; hwiid++)
-            kplic_enable_interrupt(cpu_id, hwiid, False, True);
+            kplic_enable_interrupt(cpu_id, hwiid, False, False);
     }
+    for (int hwiid = 0; hwiid <= PLIC_MAX_INTERRUPTS_NUM; hwiid++)
+        kplic_irq_cpu[hwiid] = MAX_CPU_NUM;
+}
 
-    // 打开外部中断总开关
-    kprintf("\tSet Software External Interrupt (SEIE) of sie\n");
-    set_csr(sie, SIE_S_EXTERNAL_INTERRUPT);
 
-    // 打开CPU0的UART0中断
-    kprintf("\tEnable UART0 Interrupt (SEIE) of CPU 0\n");
-    kplic_enable_interrupt(0, UART0_INTERRUPT, True, True);
+/**
+ * @brief `_kplic_complete`向当前`CPU`的上下文写中断完成寄存器
+ *
+ * @param ctx 当前`CPU`的S模式上下文
+ * @param hwiid 硬件中断号
+ *
+ * @note 中断在当前上下文中没有使能时写入会被`PLIC`忽略, 该中断将再也不会触发. 因此处理期间中断被迁移到其他`CPU`时,
+ *      需要暂时在当前上下文中使能该中断
+ */
+static void _kplic_complete(uint64_t ctx, uint32_t hwiid){
+    if (__atomic_load_n(&kplic_irq_cpu[hwiid], __ATOMIC_ACQUIRE) == cpu_id()){
+        write_32_bits(plic_complete_addr(ctx), hwiid);
+        return;
+    }
+    spinlock_acquire(&kplic_lock);
+    kplic_enable_interrupt(cpu_id(), hwiid, True, False);
+    write_32_bits(plic_complete_addr(ctx), hwiid);
+    if (kplic_irq_cpu[hwiid] != cpu_id())
+        kplic_enable_interrupt(cpu_id(), hwiid, False, False);
+    spinlock_release(&kplic_lock);
 }
 
 
-// 外部中断信息表, 取决于硬件制造商, 这里用的是QEMU Virt模拟的开发板
-const char *plic_intr_msg[PLIC_MAX_INTERRUPTS_NUM] = {
-    [0] = "Error",
-    [1 ... 8] = "VIRTIO_IRQ Interrupt",
-    [9] = "Error",
-    [10] = "UART0 Interrupt",
-    [11] = "RTC Interrupt",
-    [32 ... 35] = "PCIe Interrupt"
-};
+/**
+ * @brief `_kplic_set_context_threshold`设置当前`CPU`的S模式上下文的优先级阈值, 并回读以确保打开中断之前阈值已经生效
+ *
+ * @param ctx 当前`CPU`的S模式上下文
+ * @param threshold 优先级阈值, 只有优先级大于阈值的中断会被发送
+ */
+static void _kplic_set_context_threshold(uint64_t ctx, uint32_t threshold){
+    write_32_bits(plic_threshold_addr(ctx), threshold);
+    read_32_bits(plic_threshold_addr(ctx));
+}
 
-// 外部中断处理函数结构体
-extern void uart_interrupt_handler(void);
 
 int64_t kplic_interrupt_handler(ktrapframe_t *ktf_ptr){
-    // 开始处理中断前, 关闭中断总开关, 避免中断嵌套
-    clear_csr(sie, SIE_S_EXTERNAL_INTERRUPT);
-
-    // TODO: 目前所有中断都让CPU0处理的, 未来多核设计需要修改
-    int hart_id = CPU_TO_HART(0);
+    // 当前CPU的S模式上下文, 只会收到路由到当前CPU的中断
+    uint64_t ctx = plic_context_id(cpu_id(), False);
     // 计算中断请求寄存器MMIO地址,
-    addr_t claim_reg_addr = plic_claim_addr(hart_id, True);
+    addr_t claim_reg_addr = plic_claim_addr(ctx);
     uint32_t hwiid = -1;
+    // 被打断的外部中断处理函数设置的阈值, 没有嵌套时为0
+    uint32_t threshold = read_32_bits(plic_threshold_addr(ctx));
 
     // 可能同时有多个中断, 因此需要循环处理
     while (
         // 读取中断请求寄存器, 0留空
         (hwiid = read_32_bits(claim_reg_addr)) != 0
     ){
-        // 目前仅支持UART输入中断
-        if (hwiid == UART0_INTERRUPT)
-            uart_interrupt_handler();
+        KTRACE("plic claim hwiid=%u", hwiid);
+        if (hwiid > PLIC_MAX_INTERRUPTS_NUM){
+            write_32_bits(plic_complete_addr(ctx), hwiid);
+            continue;
+        }
+        // 处理期间只允许优先级更高的外部中断打断
+        uint32_t priority = read_32_bits(plic_priority_addr(hwiid));
+        _kplic_set_context_threshold(ctx, priority > threshold ? priority : threshold);
+        // 查表分发
+        kirq_dispatch(hwiid);
+        _kplic_set_context_threshold(ctx, threshold);
 
         // 处理完当前中断, 写中断完成寄存器
-        write_32_bits(claim_reg_addr, hwiid);
+        _kplic_complete(ctx, hwiid);
     }
-
-    // 中断处理完成后, 打开当前核心的中断总开关
-    set_csr(sie, SIE_S_EXTERNAL_INTERRUPT);
     return 0;
-}
\ No newline at end of file
+}
+
+
+kirq_chip_t kplic_chip = {
+    .name = "PLIC",
+    .route = _kplic_route,
+    .cpu_online = _kplic_cpu_online,
+    .set_priority = kplic_set_priority,
+    .interrupt_handler = kplic_interrupt_handler
+};
@@ -0,0 +1,155 @@
+/**
+ * @file ksmp.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `ksmp.c`是内核的多核(SMP)启动模块的实现
+ * @version 0.1
+ * @date 2023-06-10
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "fdt.h"
+#include "sbi/sbi.h"
+#include "asm/csr.h"
+#include "kernel/ksmp.h"
+#include "kernel/rcu.h"
+#include "kernel/kirq.h"
+#include "kernel/ktlb.h"
+#include "kernel/ktrap.h"
+#include "kernel/ktimer.h"
+#include "kernel/kstdio.h"
+#include "kernel/ksoftirq.h"
+#include "kernel/paging.h"
+
+DEFINE_PER_CPU(uint64_t, cpu_number);
+
+uint64_t volatile cpu_online_mask = 0;
+
+// 当前CPU未处理的核间中断, 每种类型一位
+static DEFINE_PER_CPU(uint64_t, ipi_pending);
+
+
+// 设备树中存在的HART, 第i位表示hartid为i的HART存在
+static uint64_t cpu_present_mask = 0;
+
+
+void smp_init(addr_t dtb){
+    cpu_present_mask = fdt_cpu_mask(dtb);
+    // 设备树不可用时认为所有的HART都存在, 由SBI决定能否启动
+    if (cpu_present_mask == 0)
+        cpu_present_mask = (1UL << MAX_CPU_NUM) - 1;
+    kprintf("\tPresent HART mask: 0x%lx\n", cpu_present_mask);
+}
+
+
+/**
+ * @brief `_smp_boot_deadline`返回启动一个`HART`的每个等待阶段的截止时间, 即`KSMP_BOOT_TIMEOUT_MS`毫秒之后的`get_cycle`
+ */
+static inline uint64_t _smp_boot_deadline(void){
+    return get_cycle() + CLINT_TIMER_BASE_FRQENCY / 1000 * KSMP_BOOT_TIMEOUT_MS;
+}
+
+
+/**
+ * @brief `_smp_wait_online`等待`HART`进入内核, 即在`cpu_online_mask`中置位
+ * 
+ * @param hartid 等待的`HART`
+ * @return Bool 在`KSMP_BOOT_TIMEOUT_MS`内进入内核时返回True
+ */
+static Bool _smp_wait_online(uint64_t hartid){
+    uint64_t deadline = _smp_boot_deadline();
+    // 被启动的HART可能在进入kernel_secondary_main之前出错, 不能一直等待
+    do {
+        if (__atomic_load_n(&cpu_online_mask, __ATOMIC_ACQUIRE) & (1UL << hartid))
+            return True;
+    } while (get_cycle() < deadline);
+    return False;
+}
+
+
+/**
+ * @brief `_smp_wait_stopped`等待`HART`在`SBI`中进入`STOPPED`状态
+ * 
+ * @param hartid 等待的`HART`
+ * @return int64_t `HART`的最后一个状态或错误码, 返回`SBI_HSM_STATE_STOPPED`时表示可以启动
+ */
+static int64_t _smp_wait_stopped(uint64_t hartid){
+    uint64_t deadline = _smp_boot_deadline();
+    int64_t status;
+    // 启动较慢的HART可能还没有进入SBI, 此时SBI返回错误或者非STOPPED的状态
+    do {
+        status = sbi_hart_get_status(hartid);
+        if (status == SBI_HSM_STATE_STOPPED)
+            break;
+    } while (get_cycle() < deadline);
+    return status;
+}
+
+
+void smp_boot_secondary(void){
+    register_ktrap_handler(CAUSE_INTERRUPT_S_SOFTWARE_INTERRUPT, True, "Supervisor Software Interrupt", smp_ipi_handler);
+    __atomic_fetch_or(&cpu_online_mask, 1UL << cpu_id(), __ATOMIC_RELEASE);
+    for (uint64_t hartid = 0; hartid < MAX_CPU_NUM; hartid++){
+        if (hartid == cpu_id())
+            continue;
+        if ((cpu_present_mask & (1UL << hartid)) == 0){
+            kprintf("\tHART %lu not present\n", hartid);
+            continue;
+        }
+        int64_t status = _smp_wait_stopped(hartid);
+        if (status != SBI_HSM_STATE_STOPPED){
+            kprintf("\tHART %lu not stopped in %d ms, status: %ld\n", hartid, KSMP_BOOT_TIMEOUT_MS, status);
+            continue;
+        }
+        int64_t ret = sbi_hart_start(hartid, (addr_t) kernel_secondary_start, 0);
+        if (ret != SBI_SUCCESS){
+            kprintf("\tHART %lu not available, error: %ld\n", hartid, ret);
+            continue;
+        }
+        // 逐个启动, 避免多个HART同时输出启动信息
+        if (!_smp_wait_online(hartid))
+            kprintf("\tHART %lu failed to come online in %d ms\n", hartid, KSMP_BOOT_TIMEOUT_MS);
+    }
+}
+
+
+void smp_send_ipi(uint64_t cpu_mask, ipi_type_t type){
+    for (uint64_t cpu = 0; cpu < MAX_CPU_NUM; cpu++)
+        if (cpu_mask & (1UL << cpu))
+            __atomic_fetch_or(per_cpu_ptr(ipi_pending, cpu), 1UL << type, __ATOMIC_RELEASE);
+    // 目前CPU编号就是HART编号
+    sbi_send_ipi(cpu_mask, 0);
+}
+
+
+int64_t smp_ipi_handler(ktrapframe_t *ktf_ptr){
+    // 先清除中断再读取请求, 清除之后发送的请求会再次触发中断
+    clear_csr(sip, SIP_S_SOFTWARE_INTERRUPT);
+    uint64_t pending = __atomic_exchange_n(this_cpu_ptr(ipi_pending), 0, __ATOMIC_ACQUIRE);
+    if (pending & (1UL << IPI_TLB_SHOOTDOWN))
+        ktlb_handle_ipi();
+    return 0;
+}
+
+
+NO_RETURN void kernel_secondary_main(uint64_t hartid){
+    // 设置异常/中断入口
+    ktrap_init_hart();
+    // 使用HART0建立的内核页表
+    enable_vm_translation();
+    kprintf("\tHART %lu online\n", hartid);
+    // 加入RCU宽限期的检测, 之后由当前HART的时钟中断报告静止状态
+    rcu_cpu_online(hartid);
+    __atomic_fetch_or(&cpu_online_mask, 1UL << hartid, __ATOMIC_RELEASE);
+    // 将自动分配的外部中断分散到包括当前HART在内的所有在线HART上
+    kirq_cpu_online(hartid);
+    // 启动当前HART的时钟中断
+    ktimer_init_hart();
+    supervisor_interrupt_enable();
+    // 空闲时运行推迟的工作, 中断返回时也会运行, 因此不会错过在wfi之前加入的工作
+    while (1){
+        ksoftirq_run();
+        asm volatile("wfi");
+    }
+    UNREACHABLE;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file ksoftirq.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `ksoftirq.c`是推迟工作(tasklet)机制的实现
+ * @version 0.1
+ * @date 2023-06-16
+ *
+ * @note 每个`CPU`的队列只被该`CPU`访问, 关闭中断即可互斥, 不需要获取锁
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "kernel/ktrap.h"
+#include "kernel/ktrace.h"
+#include "kernel/percpu.h"
+#include "kernel/kcounter.h"
+#include "kernel/ksoftirq.h"
+
+
+/**
+ * @brief `ksoftirq_cpu_t`是每个`CPU`的tasklet队列
+ */
+typedef struct __ksoftirq_cpu_t {
+    /// @brief 队列的头和尾, 队列为空时都为NULL
+    ktasklet_t *head;
+    ktasklet_t *tail;
+    /// @brief 是否正在运行tasklet
+    Bool running;
+} ksoftirq_cpu_t;
+
+static DEFINE_PER_CPU(ksoftirq_cpu_t, ksoftirq_cpu);
+
+// 推迟工作的统计计数器
+static kcounter_t tasklet_counter = KCOUNTER_INIT("softirq: tasklets run");
+static kcounter_t budget_counter = KCOUNTER_INIT("softirq: budget exhausted");
+
+
+void ksoftirq_init(void){
+    kcounter_register(&tasklet_counter);
+    kcounter_register(&budget_counter);
+}
+
+
+void ktasklet_schedule(ktasklet_t *tasklet){
+    // 已经在某个CPU的队列中, 等待运行时一并处理
+    if (__atomic_exchange_n(&tasklet->pending, 1, __ATOMIC_ACQUIRE))
+        return;
+    Bool enabled = supervisor_interrupt_save();
+    ksoftirq_cpu_t *sc = this_cpu_ptr(ksoftirq_cpu);
+    tasklet->next = NULL;
+    if (sc->head == NULL)
+        sc->head = tasklet;
+    else
+        sc->tail->next = tasklet;
+    sc->tail = tasklet;
+    supervisor_interrupt_restore(enabled);
+}
+
+
+void ksoftirq_run(void){
+    Bool enabled = supervisor_interrupt_save();
+    ksoftirq_cpu_t *sc = this_cpu_ptr(ksoftirq_cpu);
+    if (sc->running || sc->head == NULL){
+        supervisor_interrupt_restore(enabled);
+        return;
+    }
+    sc->running = True;
+
+    uint64_t budget = KSOFTIRQ_BUDGET;
+    while (sc->head != NULL && budget > 0){
+        ktasklet_t *tasklet = sc->head;
+        sc->head = tasklet->next;
+        if (sc->head == NULL)
+            sc->tail = NULL;
+        // 先清除pending, 运行期间到来的中断可以重新调度该tasklet
+        __atomic_store_n(&tasklet->pending, 0, __ATOMIC_RELEASE);
+        KTRACE("softirq run tasklet=%#lx", (uint64_t) tasklet);
+        supervisor_interrupt_enable();
+        tasklet->func(tasklet);
+        supervisor_interrupt_disable();
+        kcounter_inc(&tasklet_counter);
+        budget--;
+    }
+    // 剩下的tasklet留在队列中, 等到下一次中断返回或者空闲时运行
+    if (sc->head != NULL)
+        kcounter_inc(&budget_counter);
+
+    sc->running = False;
+    supervisor_interrupt_restore(enabled);
+}
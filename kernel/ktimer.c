@@ -8,29 +8,118 @@
  * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
  */
 
+#include "fdt.h"
 #include "sbi/sbi.h"
 #include "asm/csr.h"
+#include "kernel/rcu.h"
+#include "kernel/klog.h"
+#include "kernel/ksmp.h"
+#include "kernel/locks.h"
 #include "kernel/ktimer.h"
+#include "kernel/ktrace.h"
 #include "kernel/kstdio.h"
+#include "kernel/kcounter.h"
 
-uint64_t volatile ALIGN64 ticks;
+// 时钟中断次数和墙上时间的快照, 由顺序锁保护. 读者只读取该缓存行, 因此多个CPU同时读取不会导致缓存行来回传递
+static struct {
+    seqlock_t lock;
+    ktime_t snapshot;
+} ALIGN64 timekeeper;
+
+
+// 每个CPU上时钟中断的次数
+static kcounter_t timer_interrupt_counter = KCOUNTER_INIT("timer: interrupts");
+
+
+// 所有HART是否都支持Sstc扩展, 支持时直接设置stimecmp
+static Bool ktimer_sstc = False;
+
+
+// 将时钟周期数转换为纳秒, 分两步计算避免溢出
+static inline uint64_t _cycle_to_ns(uint64_t cycles){
+    return cycles / CLINT_TIMER_BASE_FRQENCY * 1000000000UL
+        + cycles % CLINT_TIMER_BASE_FRQENCY * 1000000000UL / CLINT_TIMER_BASE_FRQENCY;
+}
 
 void reset_timer(void){
-    sbi_settimer(get_cycle() + CLINT_TIMER_BASE_FRQENCY / CLINT_TIMER_FREQUENCY_HZ);
+    uint64_t next = get_cycle() + CLINT_TIMER_BASE_FRQENCY / CLINT_TIMER_FREQUENCY_HZ;
+    // 写stimecmp同时清除STIP
+    if (ktimer_sstc)
+        write_csr_num(CSR_STIMECMP, next);
+    else
+        sbi_settimer(next);
     // 打开Supervisor模式下的时钟中断
     set_csr(sie, SIE_S_TIMER_INTERRUPT);
 }
 
-void ktimer_init(void){
+void ktimer_init(addr_t dtb){
+    // SBI根据同一个设备树设置menvcfg.STCE
+    ktimer_sstc = fdt_isa_has_extension(dtb, "sstc");
+    kprintf("\tTimer programmed via %s\n", ktimer_sstc ? "stimecmp (Sstc)" : "SBI set_timer");
+    seqlock_init(&timekeeper.lock, "timekeeper lock");
+    lockstat_register(&timekeeper.lock.lock);
+    timekeeper.snapshot.ticks = 0;
+    timekeeper.snapshot.cycle = get_cycle();
+    timekeeper.snapshot.wall_ns = _cycle_to_ns(timekeeper.snapshot.cycle);
+    kcounter_register(&timer_interrupt_counter);
+    ktimer_init_hart();
+}
+
+
+void ktimer_init_hart(void){
     reset_timer();
 }
 
+
+uint64_t ktimer_get_ticks(void){
+    uint64_t seq, ticks;
+    do {
+        seq = seqlock_read_begin(&timekeeper.lock);
+        ticks = timekeeper.snapshot.ticks;
+    } while (seqlock_read_retry(&timekeeper.lock, seq));
+    return ticks;
+}
+
+
+void ktimer_get_time(ktime_t *time){
+    uint64_t seq;
+    do {
+        seq = seqlock_read_begin(&timekeeper.lock);
+        *time = timekeeper.snapshot;
+    } while (seqlock_read_retry(&timekeeper.lock, seq));
+    // 根据快照之后经过的时钟周期数计算当前的墙上时间
+    uint64_t now = get_cycle();
+    time->wall_ns += _cycle_to_ns(now - time->cycle);
+    time->cycle = now;
+}
+
+
+void ktimer_set_wallclock(uint64_t wall_ns){
+    seqlock_write_begin(&timekeeper.lock);
+    timekeeper.snapshot.cycle = get_cycle();
+    timekeeper.snapshot.wall_ns = wall_ns;
+    seqlock_write_end(&timekeeper.lock);
+}
+
 int64_t ktimer_interrupt_handler(ktrapframe_t *kft_ptr){
     // 关闭Supervisor模式下的时钟中断, 避免S模式下的时钟中断嵌套
     clear_csr(sie, SIE_S_TIMER_INTERRUPT);
     // 重新设置mtimecmp寄存器
     reset_timer();
-    ticks++;
-    // kprintf("Core0 Timer Interrupt, ticks=%lu\r\n", ticks);
+    kcounter_inc(&timer_interrupt_counter);
+    // 只有一个CPU更新时间快照, 其余CPU只读取
+    if (cpu_id() == KTIMER_TIMEKEEPER_CPU){
+        seqlock_write_begin(&timekeeper.lock);
+        uint64_t now = get_cycle();
+        timekeeper.snapshot.ticks++;
+        timekeeper.snapshot.wall_ns += _cycle_to_ns(now - timekeeper.snapshot.cycle);
+        timekeeper.snapshot.cycle = now;
+        seqlock_write_end(&timekeeper.lock);
+    }
+    // 被打断的上下文不在RCU读临界区内时报告静止状态, 并调用宽限期已经结束的回调函数
+    rcu_check_tick();
+    // 输出内核日志缓冲区中的日志
+    klog_drain();
+    KTRACE("timer interrupt, ticks=%lu", timekeeper.snapshot.ticks);
     return 0;
 }
\ No newline at end of file
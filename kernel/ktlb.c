@@ -0,0 +1,137 @@
+/**
+ * @file ktlb.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `ktlb.c`是多核`TLB`击落的实现
+ * @version 0.1
+ * @date 2023-06-12
+ *
+ * @note 每个`CPU`同一时刻最多发起一个击落请求, 请求保存在发起者的per-CPU变量`ktlb_request`中:
+ *  - `batch`: 需要刷新的批次, 位于发起者的栈上
+ *  - `pending_mask`: 还没有完成刷新的目标`CPU`, 目标`CPU`刷新后清除自己的位
+ *  目标`CPU`收到核间中断后检查所有`CPU`的请求, 处理`pending_mask`中包含自己的请求
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "kernel/ksmp.h"
+#include "kernel/ktlb.h"
+#include "kernel/ktrap.h"
+#include "kernel/ktrace.h"
+#include "kernel/percpu.h"
+
+
+/**
+ * @brief `ktlb_request_t`是一个`CPU`发起的击落请求
+ */
+typedef struct __ktlb_request_t {
+    /// @brief 需要刷新的批次
+    ktlb_batch_t *batch;
+    /// @brief 还没有完成刷新的目标`CPU`
+    uint64_t volatile pending_mask;
+} ktlb_request_t;
+
+static DEFINE_PER_CPU(ktlb_request_t, ktlb_request);
+
+
+void ktlb_batch_init(ktlb_batch_t *batch){
+    batch->nr = 0;
+    batch->pages = 0;
+    batch->full = False;
+}
+
+
+void ktlb_batch_add(ktlb_batch_t *batch, addr_t start, uint64_t size){
+    if (batch->full)
+        return;
+    addr_t end = (start + size + PAGE_SIZE - 1) & ~((addr_t)PAGE_SIZE - 1);
+    start &= ~((addr_t)PAGE_SIZE - 1);
+    batch->pages += (end - start) / PAGE_SIZE;
+    if (batch->pages > TLB_FLUSH_ALL_THRESHOLD){
+        batch->full = True;
+        return;
+    }
+    // 和上一个地址范围相邻时合并
+    if (batch->nr > 0){
+        ktlb_range_t *last = &batch->ranges[batch->nr - 1];
+        if (last->start + last->size == start){
+            last->size += end - start;
+            return;
+        }
+    }
+    if (batch->nr == KTLB_BATCH_RANGES){
+        batch->full = True;
+        return;
+    }
+    batch->ranges[batch->nr].start = start;
+    batch->ranges[batch->nr].size = end - start;
+    batch->nr++;
+}
+
+
+/**
+ * @brief `_ktlb_local_flush`在当前`CPU`上刷新批次中的地址范围
+ */
+static void _ktlb_local_flush(ktlb_batch_t *batch){
+    if (batch->full){
+        asm volatile("sfence.vma" ::: "memory");
+        return;
+    }
+    for (uint64_t i = 0; i < batch->nr; i++){
+        addr_t end = batch->ranges[i].start + batch->ranges[i].size;
+        for (addr_t addr = batch->ranges[i].start; addr < end; addr += PAGE_SIZE)
+            asm volatile("sfence.vma %0" : : "r" (addr) : "memory");
+    }
+}
+
+
+void ktlb_handle_ipi(void){
+    uint64_t self_mask = 1UL << cpu_id();
+    for (uint64_t cpu = 0; cpu < MAX_CPU_NUM; cpu++){
+        ktlb_request_t *req = per_cpu_ptr(ktlb_request, cpu);
+        if ((__atomic_load_n(&req->pending_mask, __ATOMIC_ACQUIRE) & self_mask) == 0)
+            continue;
+        _ktlb_local_flush(req->batch);
+        __atomic_fetch_and(&req->pending_mask, ~self_mask, __ATOMIC_RELEASE);
+    }
+}
+
+
+void ktlb_batch_flush(ktlb_batch_t *batch){
+    if (batch->nr == 0 && !batch->full)
+        return;
+
+    Bool enabled = supervisor_interrupt_save();
+    ktlb_request_t *req = this_cpu_ptr(ktlb_request);
+    uint64_t targets = __atomic_load_n(&cpu_online_mask, __ATOMIC_ACQUIRE) & ~(1UL << cpu_id());
+    KTRACE("tlb shootdown targets=%#lx ranges=%lu full=%lu", targets, batch->nr, (uint64_t)batch->full);
+    // 所有目标CPU只需要一次核间中断
+    if (targets != 0){
+        req->batch = batch;
+        __atomic_store_n(&req->pending_mask, targets, __ATOMIC_RELEASE);
+        smp_send_ipi(targets, IPI_TLB_SHOOTDOWN);
+    }
+    // 其他CPU刷新的同时刷新本地的TLB
+    _ktlb_local_flush(batch);
+    // 中断已经关闭, 等待时需要主动处理其他CPU发给当前CPU的请求, 否则同时击落的两个CPU会互相等待
+    while (__atomic_load_n(&req->pending_mask, __ATOMIC_ACQUIRE) != 0)
+        ktlb_handle_ipi();
+    supervisor_interrupt_restore(enabled);
+
+    ktlb_batch_init(batch);
+}
+
+
+void ktlb_flush_range(addr_t start, uint64_t size){
+    ktlb_batch_t batch;
+    ktlb_batch_init(&batch);
+    ktlb_batch_add(&batch, start, size);
+    ktlb_batch_flush(&batch);
+}
+
+
+void ktlb_flush_all(void){
+    ktlb_batch_t batch;
+    ktlb_batch_init(&batch);
+    batch.full = True;
+    ktlb_batch_flush(&batch);
+}
@@ -9,10 +9,17 @@
  */
 
 #include "asm/csr.h"
+#include "kernel/klog.h"
+#include "kernel/rcu.h"
 #include "kernel/ktrap.h"
-#include "kernel/kplic.h"
+#include "kernel/ktrace.h"
+#include "kernel/kirq.h"
+#include "kernel/ksmp.h"
 #include "kernel/ktimer.h"
 #include "kernel/kstdio.h"
+#include "kernel/kcounter.h"
+#include "kernel/ksoftirq.h"
+#include "trap/trapstat.h"
 
 
 // 中断的提示信息
@@ -57,17 +64,23 @@ ktrap_handler_t intr_handlers[MAX_INTR_EXCP_INFO_NUM];
 // 异常处理函数表
 ktrap_handler_t excp_handlers[MAX_INTR_EXCP_INFO_NUM];
 
+// 中断和异常的统计计数器
+static kcounter_t interrupt_counter = KCOUNTER_INIT("trap: interrupts");
+static kcounter_t exception_counter = KCOUNTER_INIT("trap: exceptions");
+
+// 陷入统计, 时间为get_cycle的时钟周期
+static trapstat_table_t ktrap_stat;
+
+// 每个HART的中断栈, 以及快速入口使用的栈顶和嵌套深度
+static uint8_t kirq_stacks[MAX_CPU_NUM][KIRQ_STACK_SIZE] ALIGN64;
+DEFINE_PER_CPU(kirq_stack_t, ktrap_irq_stack);
+
 
 void ktrap_init(void){
     kprintf("KTrap Info:\n");
-    // 设置当前运行线程为内核线程
-    write_csr(sscratch, 0);
-    // 设置中断向量地址, 设置为直接模式
-    kprintf("\tSet stvec to %#X, mode=%s\n", (addr_t) ktrap_enter, "DIRECT");
-    write_csr(stvec, ((addr_t)ktrap_enter & (~((addr_t)TVEC_TRAP_DIRECT))));
-    // 开启所有的中断
+    kprintf("\tSet stvec to %#X, mode=%s\n", (addr_t) ktrap_vector, "VECTORED");
     kprintf("\tEnable All Supervisor Interrupts");
-    write_csr(sie, -1);
+    ktrap_init_hart();
     // 为所有的异常和中断注册通用异常处理函数
     for (size_t i = 0; i < MAX_INTR_EXCP_INFO_NUM; i++)
         register_ktrap_handler(i, False, NULL, general_ktrap_handler);
@@ -76,18 +89,93 @@ void ktrap_init(void){
     // 为S模式下的时钟中断注册中断处理函数
     kprintf("\tRegister Supervisor Timer Interrupt Handler");
     register_ktrap_handler(CAUSE_INTERRUPT_S_TIMER_INTERRUPT, True, "Supervisor Timer Interrupt", ktimer_interrupt_handler);
-    // 为S模式下的外部中断注册中断处理函数
-    kprintf("\tRegister Supervisor External Interrupt Handler");
-    register_ktrap_handler(CAUSE_INTERRUPT_S_EXTERNAL_INTERRUPT, True, "Supervisor External Interrupt", kplic_interrupt_handler);
+    // S模式下的外部中断处理函数取决于中断控制器, 由kirq_init注册
+    kcounter_register(&interrupt_counter);
+    kcounter_register(&exception_counter);
+}
+
+
+void ktrap_init_hart(void){
+    // 设置当前运行线程为内核线程
+    write_csr(sscratch, 0);
+    // 设置中断栈, 此时还没有打开中断
+    this_cpu_ptr(ktrap_irq_stack)->nesting = 0;
+    this_cpu_ptr(ktrap_irq_stack)->top = (addr_t) kirq_stacks[cpu_id()] + KIRQ_STACK_SIZE;
+    this_cpu_ptr(ktrap_irq_stack)->bottom = (addr_t) kirq_stacks[cpu_id()];
+    *(uint64_t *) kirq_stacks[cpu_id()] = KIRQ_STACK_CANARY;
+    // 设置中断向量地址, 设置为向量模式
+    write_csr(stvec, ((addr_t)ktrap_vector | TVEC_TRAP_INDIRECT));
+    // 开启所有的中断
+    write_csr(sie, -1);
+}
+
+
+/**
+ * @brief `_ktrap_stat_record`记录一次从`start`开始处理的陷入
+ */
+static void _ktrap_stat_record(Bool interrupt, uint64_t trap_code, uint64_t start){
+    Bool enabled = supervisor_interrupt_save();
+    trapstat_record(&ktrap_stat, cpu_id(), interrupt, trap_code, get_cycle() - start);
+    supervisor_interrupt_restore(enabled);
+}
+
+
+void ktrap_stat_dump(void){
+    trapstat_dump(&ktrap_stat, kintr_msg, kexcp_msg, "mtime ticks", kprintf);
 }
 
 
 void ktrap_dispatcher(ktrapframe_t *ktf_ptr){
+    uint64_t start = get_cycle();
     ireg_t scause = read_csr(scause);
 
     Bool is_interrupt = ((scause & CAUSE_INTERRUPT_FLAG) != 0) ? 1 : 0;
     uint64_t trap_code = scause & ~(CAUSE_INTERRUPT_FLAG);
-    int64_t rtval UNUSED = (is_interrupt ? intr_handlers : excp_handlers)[trap_code](ktf_ptr);
+    KTRACE("trap scause=%#lx sepc=%#lx stval=%#lx", scause, ktf_ptr->sepc, read_csr(stval));
+    kcounter_inc(is_interrupt ? &interrupt_counter : &exception_counter);
+    // 处理函数表可能在运行时被修改, 读取一次指针后调用
+    ktrap_handler_t handler = rcu_dereference((is_interrupt ? intr_handlers : excp_handlers)[trap_code]);
+    int64_t rtval UNUSED = handler(ktf_ptr);
+    _ktrap_stat_record(is_interrupt, trap_code, start);
+    // 从用户态陷入的中断不经过快速入口, 同样在返回前运行推迟的工作
+    if (is_interrupt && !in_interrupt())
+        ksoftirq_run();
+}
+
+
+/**
+ * @brief `_ktrap_irq_exit`在快速入口的中断处理函数返回前调用, 最外层的中断返回前运行推迟的工作
+ */
+static void _ktrap_irq_exit(void){
+    if (this_cpu_read(ktrap_irq_stack).nesting == 1)
+        ksoftirq_run();
+}
+
+
+void ktrap_fast_software(ktrapframe_t *ktf_ptr){
+    uint64_t start = get_cycle();
+    kcounter_inc(&interrupt_counter);
+    smp_ipi_handler(ktf_ptr);
+    _ktrap_stat_record(True, CAUSE_INTERRUPT_S_SOFTWARE_INTERRUPT, start);
+    _ktrap_irq_exit();
+}
+
+
+void ktrap_fast_timer(ktrapframe_t *ktf_ptr){
+    uint64_t start = get_cycle();
+    kcounter_inc(&interrupt_counter);
+    ktimer_interrupt_handler(ktf_ptr);
+    _ktrap_stat_record(True, CAUSE_INTERRUPT_S_TIMER_INTERRUPT, start);
+    _ktrap_irq_exit();
+}
+
+
+void ktrap_fast_external(ktrapframe_t *ktf_ptr){
+    uint64_t start = get_cycle();
+    kcounter_inc(&interrupt_counter);
+    kirq_interrupt_handler(ktf_ptr);
+    _ktrap_stat_record(True, CAUSE_INTERRUPT_S_EXTERNAL_INTERRUPT, start);
+    _ktrap_irq_exit();
 }
 
 
@@ -98,6 +186,8 @@ NO_RETURN int64_t general_ktrap_handler(ktrapframe_t *ktf_ptr){
     const char **msg_source = (is_interrupt ? kintr_msg : kexcp_msg);
     const char *msg = msg_source[trap_code];
     const char *s = is_interrupt ? "Interrupt" : "Exception";
+    // 内核即将挂起, 切换到同步模式输出
+    klog_panic();
     kprintf("==================================================================\n");
     kprintf("Message from Kernel General Trap Handler:\n");
     kprintf("%s Happened, %s ID: %#X, scause register: %#X\n", s, s, trap_code, scause);
@@ -116,5 +206,6 @@ NO_RETURN int64_t general_ktrap_handler(ktrapframe_t *ktf_ptr){
 void register_ktrap_handler(uint64_t trap_code, Bool interrupt, const char* msg, ktrap_handler_t trap_func){
     if (msg != NULL)
         (interrupt ? kintr_msg : kexcp_msg)[trap_code] = msg;
-    (interrupt ? intr_handlers : excp_handlers)[trap_code] = trap_func;
+    // 处理函数是内核代码, 不会被释放, 因此只需要保证发布顺序, 不需要等待宽限期
+    rcu_assign_pointer((interrupt ? intr_handlers : excp_handlers)[trap_code], trap_func);
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 
 #include "kernel/mm.h"
 #include "kernel/paging.h"
+#include "kernel/kcounter.h"
 
 /// `KPAGES`定义了内核可用物理页数
 #define KPAGES ((int) (PAGE_NUMS / MEMORY_US_RATIO))
@@ -54,6 +55,12 @@ vpool_t kernel_vpool;
 /// `_e_kernel`是内核映像的地址, 定义在`kernel.ld`中
 extern char _e_kernel[];
 
+// 内存分配的统计计数器
+static kcounter_t ppage_alloc_counter = KCOUNTER_INIT("mm: physical pages alloc");
+static kcounter_t ppage_free_counter = KCOUNTER_INIT("mm: physical pages free");
+static kcounter_t vpage_alloc_counter = KCOUNTER_INIT("mm: virtual pages alloc");
+static kcounter_t vpage_free_counter = KCOUNTER_INIT("mm: virtual pages free");
+
 void init_pools(addr_t start_paddr, size_t total_pages){
     // 计算用户/内核可用物理页面数
     size_t \
@@ -66,7 +73,8 @@ void init_pools(addr_t start_paddr, size_t total_pages){
     kernel_ppool.btmp = (bitmap_t *) &pool_btmps.kernel_ppool_btmp;
     kernel_ppool.btmp->bits = pool_btmps.kernel_ppool_btmp + sizeof(bitmap_t);
     bitmap_init(kernel_ppool.btmp, KPAGES / 8 + 1);
-    spinlock_init(&kernel_ppool.lock, "kernel_ppool lock");
+    mcslock_init(&kernel_ppool.lock, "kernel_ppool lock");
+    lockstat_register(&kernel_ppool.lock);
 
     // 初始化用户物理内存池
     user_ppool.size = upages;
@@ -74,7 +82,8 @@ void init_pools(addr_t start_paddr, size_t total_pages){
     user_ppool.btmp = (bitmap_t *) &pool_btmps.user_ppool_btmp;
     user_ppool.btmp->bits = pool_btmps.user_ppool_btmp + sizeof(bitmap_t);
     bitmap_init(user_ppool.btmp, UPAGES / 8 + 1);
-    spinlock_init(&user_ppool.lock, "user_ppool lock");
+    mcslock_init(&user_ppool.lock, "user_ppool lock");
+    lockstat_register(&user_ppool.lock);
 
     // 初始化内核虚拟内存池
     /* 
@@ -87,6 +96,12 @@ void init_pools(addr_t start_paddr, size_t total_pages){
     kernel_vpool.btmp->bits = pool_btmps.kernel_vpool_btmp + sizeof(bitmap_t);
     bitmap_init(kernel_vpool.btmp, KPAGES / 8 + 1);
     spinlock_init(&kernel_vpool.lock, "kernel_vpool lock");
+    lockstat_register(&kernel_vpool.lock);
+
+    kcounter_register(&ppage_alloc_counter);
+    kcounter_register(&ppage_free_counter);
+    kcounter_register(&vpage_alloc_counter);
+    kcounter_register(&vpage_free_counter);
 }
 
 
@@ -111,13 +126,16 @@ void memory_init(addr_t start_paddr, addr_t end_paddr){
 addr_t alloc_ppage(Bool kpage){
     ppool_t *pool = (kpage == True) ? &kernel_ppool : &user_ppool;
 
+    // 查找和占用空闲页需要在同一个临界区内, 否则两个CPU可能分配到同一个物理页
+    mcs_node_t node;
+    mcslock_acquire(&pool->lock, &node);
     offset_t bit_idx = bitmap_scan(pool->btmp, 1);
+    if (bit_idx != -1)
+        bitmap_set(pool->btmp, bit_idx, BITMAP_TAKEN);
+    mcslock_release(&pool->lock, &node);
     // TODO: 未来实现换页机制后, 这里需要修改为换出物理页
     ASSERT(bit_idx != -1, "bit_idx=%d, cannot find a physical page!", bit_idx);
-
-    spinlock_acquire(&pool->lock);
-    bitmap_set(pool->btmp, bit_idx, BITMAP_TAKEN);
-    spinlock_release(&pool->lock);
+    kcounter_inc(&ppage_alloc_counter);
 
 
     addr_t ppage = pool->paddr_start + bit_idx * PAGE_SIZE;
@@ -133,21 +151,25 @@ void free_ppage(addr_t ppage, Bool kpage){
     offset_t bit_idx = (ppage - pool->paddr_start) / PAGE_SIZE;
     ASSERT(bit_idx >= 0, "bit_idx shouldn't be negative, bit_idx = %d!", bit_idx);
 
-    spinlock_acquire(&pool->lock);
+    mcs_node_t node;
+    mcslock_acquire(&pool->lock, &node);
     bitmap_set(pool->btmp, bit_idx, BITMAP_FREE);
-    spinlock_release(&pool->lock);
+    mcslock_release(&pool->lock, &node);
+    kcounter_inc(&ppage_free_counter);
 }
 
 
 addr_t alloc_vpage(vpool_t *vpool, size_t cnt){
     ASSERT(vpool != NULL, "vpool shouldn't be NULL!");
 
+    spinlock_acquire(&vpool->lock);
     offset_t bit_idx = bitmap_scan(vpool->btmp, cnt);
+    if (bit_idx != -1)
+        bitmap_set(vpool->btmp, bit_idx, BITMAP_TAKEN);
+    spinlock_release(&vpool->lock);
     // TODO: 未来实现换页机制后, 这里需要修改为换出虚拟页
     ASSERT(bit_idx != -1, "bit_idx=%d, cannot find a virtual page!", bit_idx);
-    spinlock_acquire(&vpool->lock);
-    bitmap_set(vpool->btmp, bit_idx, BITMAP_TAKEN);
-    spinlock_release(&vpool->lock);
+    kcounter_add(&vpage_alloc_counter, cnt);
 
     return vpool->vaddr_start + bit_idx * PAGE_SIZE;
 }
@@ -161,6 +183,7 @@ void free_vpage(vpool_t *vpool, addr_t vpage){
     spinlock_acquire(&vpool->lock);
     bitmap_set(vpool->btmp, bit_idx, BITMAP_FREE);
     spinlock_release(&vpool->lock);
+    kcounter_inc(&vpage_free_counter);
 }
 
 
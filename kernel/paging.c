@@ -15,11 +15,19 @@
 #include "asm/plic.h"
 #include "asm/uart.h"
 #include "asm/clint.h"
+#include "kernel/klog.h"
+#include "kernel/kdebug.h"
+#include "kernel/ktlb.h"
+#include "kernel/ktrace.h"
 #include "kernel/paging.h"
 
 pgd_t *kernel_pgd = (pgd_t *)_s_kernel_pgd;
 
+// 内核地址空间的读写锁
+static rwlock_t kernel_pgd_lock;
+
 void paging_init(void){
+    rwlock_init(&kernel_pgd_lock, "kernel_pgd lock");
     // 初始化内核页目录表
     memset(kernel_pgd, 0, PAGE_SIZE);
     kprintf("kernel PGD is at: %#X\n", (addr_t) kernel_pgd);
@@ -31,6 +39,8 @@ void paging_init(void){
     register_ktrap_handler(CAUSE_EXCEPTION_LOAD_PAGE_FAULT, False, "Load Page Fault Exception", paging_load_page_fault_exception_handler);
     // 注册Store/AMO Page Fault函数
     register_ktrap_handler(CAUSE_EXCEPTION_STORE_PAGE_FAULT, False, "Store Page Fault Exception", paging_load_page_fault_exception_handler);
+    // 开启分页后CPU继续执行当前的代码, 因此当前的代码必须是恒等映射的
+    ASSERT(lookup_mapping(kernel_pgd, (addr_t) paging_init, NULL) == (addr_t) paging_init, "kernel code is not identity mapped!");
     // 开启虚拟地址翻译机制, 即开启内存分页机制
     enable_vm_translation();
 }
@@ -93,10 +103,50 @@ void create_mmio_mapping(void){
 }
 
 
+/**
+ * @brief `_lookup_mapping`遍历`pgd`指向的页目录表, 查询虚拟地址`vaddr`映射到的物理地址
+ *
+ * @param pgd 全局页目录表
+ * @param vaddr 要查询的虚拟地址
+ * @param entry 若不为NULL, 则保存映射`vaddr`的最后一级表项的值, 没有映射时为0
+ * @return addr_t `vaddr`映射到的物理地址, 没有映射时返回0
+ *
+ * @note 调用时需要持有`pgd`的读锁
+ */
+static addr_t _lookup_mapping(pgd_t *pgd, addr_t vaddr, uint64_t *entry){
+    addr_t paddr = 0;
+    uint64_t val = 0;
+    pgd_entry_t *pgd_ent = ((pgd_entry_t *) pgd) + get_vpn(vaddr, 2);
+    if (is_leaf_page(pgd_ent->val)){
+        // 1GB的巨页
+        val = pgd_ent->val;
+        paddr = ((val >> PAGE_PFN_SHIFT) << PAGE_SHIFT) | (vaddr & ~PGD_MASK);
+    } else if (is_valid_page(pgd_ent->val)){
+        pmd_entry_t *pmd_ent = ((pmd_entry_t *) get_pmd(pgd_ent)) + get_vpn(vaddr, 1);
+        if (is_leaf_page(pmd_ent->val)){
+            // 2MB的巨页
+            val = pmd_ent->val;
+            paddr = ((val >> PAGE_PFN_SHIFT) << PAGE_SHIFT) | (vaddr & ~PMD_MASK);
+        } else if (is_valid_page(pmd_ent->val)){
+            pt_entry_t *pt_ent = ((pt_entry_t *) get_pt(pmd_ent)) + get_vpn(vaddr, 0);
+            if (is_valid_page(pt_ent->val)){
+                val = pt_ent->val;
+                paddr = ((val >> PAGE_PFN_SHIFT) << PAGE_SHIFT) | (vaddr & ~PTE_MASK);
+            }
+        }
+    }
+    if (entry != NULL)
+        *entry = val;
+    return paddr;
+}
+
+
 // TODO: 未来实现换页机制需要修改该函数
 NO_RETURN int64_t paging_load_page_fault_exception_handler(ktrapframe_t *ktf_ptr){
     // 关中断, 避免循环
     supervisor_interrupt_disable();
+    // 内核即将挂起, 切换到同步模式输出
+    klog_panic();
     // 读取S模式下Load Page Fault异常发生的地址 
     addr_t bad_addr = read_csr(stval);
     offset_t \
@@ -123,6 +173,15 @@ NO_RETURN int64_t paging_load_page_fault_exception_handler(ktrapframe_t *ktf_ptr
     kprintf("Detailed infomation of PGD:\n");
     kprintf("\tkernel PGD is at %#X\n", (addr_t) kernel_pgd);
     kprintf("\tcurrent running thread PGD is at %#X\n", (addr_t) get_pgd());
+    // 异常可能发生在修改页表的过程中, 此时当前CPU持有写锁, 不能等待读锁
+    Bool locked = rwlock_try_read_acquire(get_pgd_lock(get_pgd()));
+    if (locked){
+        uint64_t entry;
+        addr_t paddr = _lookup_mapping(get_pgd(), bad_addr, &entry);
+        kprintf("Detailed infomation of mapping:\n");
+        kprintf("\tpaddr = %#X, entry = %#X\n", paddr, entry);
+    } else
+        kprintf("WARNING: page table is being modified, dumping without holding %s\n", get_pgd_lock(get_pgd())->name);
     kprintf("Kernel PGD/PMT/PT Info:\n");
     kprintf("WARNING: printing PGD/PMT/PT may cause huge outputs on screen, please use tee to save outputs. Start printing in a few seconds...\n");
     // for (int32_t max = (__INT32_MAX__ >> 1) + __INT16_MAX__ * 0xFFF ; max-- > 0;);
@@ -130,6 +189,8 @@ NO_RETURN int64_t paging_load_page_fault_exception_handler(ktrapframe_t *ktf_ptr
     // 关闭虚拟地址翻译
     disable_vm_translation();
     dump_pgd(get_pgd(), (addr_t) _s_text_boot, (addr_t) _e_bss);
+    if (locked)
+        rwlock_read_release(get_pgd_lock(get_pgd()));
     while (1);
     UNREACHABLE;
 }
@@ -295,8 +356,7 @@ void make_pmd_entry(pmd_entry_t *pmd_ent, addr_t s_vaddr, addr_t e_vaddr, addr_t
         // 填充pmd_ent
         set_pmd_entry(pmd_ent, pt_ppage, pt_prot);
 
-        // Debug
-        // kprintf("Alloc A PT at %#X, coressponding PMD_Ent.val = %#X\n", pt_ppage);
+        KTRACE("alloc PT at %#lx, PMD_Ent.val = %#lx", pt_ppage, pmd_ent->val);
     }
 
     // 逐页映射
@@ -304,8 +364,7 @@ void make_pmd_entry(pmd_entry_t *pmd_ent, addr_t s_vaddr, addr_t e_vaddr, addr_t
     pt_entry_t *pt_ent = ((pt_entry_t *) pt) + get_vpn(curr_ppage, 0);
     do {
         set_pt_entry(pt_ent, curr_ppage, property);
-        // Debug
-        // kprintf("Map vpage at %#X to paddr at %#X\n", curr_vpage, curr_ppage);
+        KTRACE("map vpage %#lx to ppage %#lx", curr_vpage, curr_ppage);
         curr_ppage += PAGE_SIZE;
     } while (pt_ent++, curr_vpage += PAGE_SIZE, curr_vpage < end_vpage);
 }
@@ -325,8 +384,7 @@ void make_pgd_entry(pgd_entry_t *pgd_ent, addr_t s_vaddr, addr_t e_vaddr, addr_t
         // 填充pgd_ent
         set_pgd_entry(pgd_ent, pmd_ppage, pmd_prot);
 
-        // Debug
-        // kprintf("Alloc A PMD at %#X, corresponding PGD_Ent.val = %#X\n", pmd_ppage, pgd_ent->val);
+        KTRACE("alloc PMD at %#lx, PGD_Ent.val = %#lx", pmd_ppage, pgd_ent->val);
     }
 
     // 获得起始PMD表项
@@ -358,6 +416,10 @@ void create_mapping(pgd_t *pgd, addr_t vaddr, addr_t paddr, uint64_t size, page_
     // 要映射的最后一个虚拟页地址
     addr_t end_vpage = page_align(vaddr + size, True);
 
+    // 修改页表期间持有写锁, 其他CPU不能同时遍历或者修改页表
+    rwlock_t *lock = get_pgd_lock(pgd);
+    rwlock_write_acquire(lock);
+
     // 获取起始PGD表项
     pgd_entry_t *pgd_ent = ((pgd_entry_t *) pgd) + get_vpn(curr_vpage, 2);
     // 若要映射的范围大于1GB, 则需要使用多个PGD表项完成映射, 所以此时使用循环
@@ -373,4 +435,70 @@ void create_mapping(pgd_t *pgd, addr_t vaddr, addr_t paddr, uint64_t size, page_
         // 更新下一个开始映射的虚拟页地址
         curr_ppage += (next_vpage - curr_vpage);
     } while (pgd_ent++, curr_vpage = next_vpage, curr_vpage < end_vpage);
+
+    rwlock_write_release(lock);
+}
+
+
+void remove_mapping(pgd_t *pgd, addr_t vaddr, uint64_t size){
+    ASSERT(0 < size, "unmapping memory size must greater than 0, but size=%d!", size);
+
+    addr_t curr_vpage = page_align(vaddr, False);
+    addr_t end_vpage = page_align(vaddr + size, True);
+    // 所有被清除的表项一起刷新, 每个CPU只需要一次核间中断
+    ktlb_batch_t batch;
+    ktlb_batch_init(&batch);
+
+    rwlock_t *lock = get_pgd_lock(pgd);
+    rwlock_write_acquire(lock);
+    while (curr_vpage < end_vpage){
+        // 查找映射curr_vpage的最后一级表项, 以及该表项映射的内存大小
+        uint64_t *leaf = NULL;
+        uint64_t leaf_size = PGD_SIZE;
+        pgd_entry_t *pgd_ent = ((pgd_entry_t *) pgd) + get_vpn(curr_vpage, 2);
+        if (is_leaf_page(pgd_ent->val)){
+            leaf = &pgd_ent->val;
+        } else if (is_valid_page(pgd_ent->val)){
+            leaf_size = PMD_SIZE;
+            pmd_entry_t *pmd_ent = ((pmd_entry_t *) get_pmd(pgd_ent)) + get_vpn(curr_vpage, 1);
+            if (is_leaf_page(pmd_ent->val)){
+                leaf = &pmd_ent->val;
+            } else if (is_valid_page(pmd_ent->val)){
+                leaf_size = PAGE_SIZE;
+                pt_entry_t *pt_ent = ((pt_entry_t *) get_pt(pmd_ent)) + get_vpn(curr_vpage, 0);
+                if (is_valid_page(pt_ent->val))
+                    leaf = &pt_ent->val;
+            }
+        }
+        // 下一个表项映射的虚拟地址
+        addr_t next_vpage = (curr_vpage + leaf_size) & ~(leaf_size - 1);
+        if (leaf != NULL){
+            // 目前不支持拆分巨页
+            ASSERT(curr_vpage % leaf_size == 0 && next_vpage <= end_vpage, "can not unmap part of huge page at %#X!", curr_vpage);
+            *leaf = 0;
+            ktlb_batch_add(&batch, curr_vpage, leaf_size);
+        }
+        curr_vpage = next_vpage;
+    }
+    rwlock_write_release(lock);
+
+    // 其他CPU可能关中断等待页表的读写锁, 因此释放锁之后再击落
+    ktlb_batch_flush(&batch);
+    KTRACE("unmap vaddr=%#lx size=%#lx", vaddr, size);
+}
+
+
+rwlock_t *get_pgd_lock(pgd_t *pgd){
+    // 只有内核一个地址空间, 所有的页目录表都由内核的读写锁保护
+    return &kernel_pgd_lock;
+}
+
+
+addr_t lookup_mapping(pgd_t *pgd, addr_t vaddr, uint64_t *entry){
+    rwlock_t *lock = get_pgd_lock(pgd);
+    // 查询只获取读锁, 多个CPU可以同时查询
+    rwlock_read_acquire(lock);
+    addr_t paddr = _lookup_mapping(pgd, vaddr, entry);
+    rwlock_read_release(lock);
+    return paddr;
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+/**
+ * @file percpu.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `percpu.c`是per-CPU变量的实现
+ * @version 0.1
+ * @date 2023-06-11
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "string.h"
+#include "kernel/ksmp.h"
+#include "kernel/percpu.h"
+
+addr_t percpu_offset[MAX_CPU_NUM];
+
+// 每个CPU的数据区, kernel.ld中检查.data.percpu段不超过PERCPU_AREA_SIZE
+static uint8_t percpu_areas[MAX_CPU_NUM][PERCPU_AREA_SIZE] ALIGN64;
+
+
+addr_t percpu_init_hart(uint64_t hartid){
+    uint8_t *area = percpu_areas[hartid];
+    memcpy(area, _s_percpu, (size_t)(_e_percpu - _s_percpu));
+    percpu_offset[hartid] = (addr_t)area - (addr_t)_s_percpu;
+    *per_cpu_ptr(cpu_number, hartid) = hartid;
+    return (addr_t)area;
+}
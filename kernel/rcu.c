@@ -0,0 +1,151 @@
+/**
+ * @file rcu.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `rcu.c`是RCU机制的实现
+ * @version 0.1
+ * @date 2023-06-08
+ *
+ * @note 宽限期使用两个全局序号表示:
+ *  - `gp_started`: 已经开始的宽限期
+ *  - `gp_completed`: 已经结束的宽限期
+ *  `gp_started > gp_completed`时宽限期正在进行, 所有在线的`CPU`都经过静止状态(`qs_gp == gp_started`)后宽限期结束
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "kernel/rcu.h"
+#include "kernel/ktrap.h"
+#include "kernel/ktrace.h"
+
+rcu_cpu_t rcu_cpus[MAX_CPU_NUM];
+
+// 宽限期的序号
+static uint64_t volatile ALIGN64 gp_started = 0;
+static uint64_t volatile gp_completed = 0;
+
+// 在线的CPU, 每个CPU一位
+static uint64_t volatile online_mask = 0;
+
+
+void rcu_init(void){
+    for (int cpu = 0; cpu < MAX_CPU_NUM; cpu++){
+        rcu_cpus[cpu].nesting = 0;
+        rcu_cpus[cpu].qs_gp = 0;
+        rcu_cpus[cpu].next_list = NULL;
+        rcu_cpus[cpu].next_tail = &rcu_cpus[cpu].next_list;
+        rcu_cpus[cpu].wait_list = NULL;
+        rcu_cpus[cpu].wait_gp = 0;
+    }
+    rcu_cpu_online(cpu_id());
+}
+
+
+void rcu_cpu_online(uint64_t cpu){
+    // 新上线的CPU不可能持有之前的读者, 视为已经经过静止状态
+    rcu_cpus[cpu].qs_gp = gp_started;
+    __atomic_fetch_or(&online_mask, 1UL << cpu, __ATOMIC_RELEASE);
+}
+
+
+/**
+ * @brief `_rcu_try_complete`检查所有在线的`CPU`是否都经过了当前宽限期的静止状态, 是则结束当前宽限期
+ */
+static void _rcu_try_complete(void){
+    uint64_t gp = __atomic_load_n(&gp_started, __ATOMIC_ACQUIRE);
+    if (gp == gp_completed)
+        return;
+    uint64_t mask = __atomic_load_n(&online_mask, __ATOMIC_ACQUIRE);
+    for (int cpu = 0; cpu < MAX_CPU_NUM; cpu++)
+        if ((mask & (1UL << cpu)) && __atomic_load_n(&rcu_cpus[cpu].qs_gp, __ATOMIC_ACQUIRE) < gp)
+            return;
+    // 多个CPU可能同时发现宽限期结束, 只有一个可以修改
+    uint64_t expected = gp - 1;
+    if (__atomic_compare_exchange_n(&gp_completed, &expected, gp, False, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        KTRACE("rcu grace period %lu completed", gp);
+}
+
+
+/**
+ * @brief `_rcu_advance`推进当前`CPU`的回调函数: 调用宽限期已经结束的回调函数, 为新的回调函数申请宽限期
+ *
+ * @note 调用时需要关闭中断
+ */
+static void _rcu_advance(rcu_cpu_t *rcp){
+    // 等待的宽限期已经结束, 调用这一批回调函数
+    if (rcp->wait_list != NULL && __atomic_load_n(&gp_completed, __ATOMIC_ACQUIRE) >= rcp->wait_gp){
+        rcu_head_t *head = rcp->wait_list;
+        rcp->wait_list = NULL;
+        while (head != NULL){
+            rcu_head_t *next = head->next;
+            head->func(head);
+            head = next;
+        }
+    }
+
+    // 新的回调函数需要等待下一个宽限期. 当前宽限期可能在回调函数注册之前就开始了, 因此不能等待当前宽限期
+    if (rcp->wait_list == NULL && rcp->next_list != NULL){
+        rcp->wait_list = rcp->next_list;
+        rcp->next_list = NULL;
+        rcp->next_tail = &rcp->next_list;
+        rcp->wait_gp = __atomic_load_n(&gp_started, __ATOMIC_ACQUIRE) + 1;
+    }
+
+    // 没有正在进行的宽限期时开始一个新的宽限期
+    if (rcp->wait_list != NULL){
+        uint64_t gp = __atomic_load_n(&gp_started, __ATOMIC_ACQUIRE);
+        if (gp < rcp->wait_gp && gp == __atomic_load_n(&gp_completed, __ATOMIC_ACQUIRE))
+            __atomic_compare_exchange_n(&gp_started, &gp, gp + 1, False, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+    }
+}
+
+
+void rcu_quiescent_state(void){
+    Bool enabled = supervisor_interrupt_save();
+    rcu_cpu_t *rcp = &rcu_cpus[cpu_id()];
+    // 先推进回调函数, 以便新开始的宽限期可以立即记录当前CPU的静止状态
+    _rcu_advance(rcp);
+    __atomic_store_n(&rcp->qs_gp, __atomic_load_n(&gp_started, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    _rcu_try_complete();
+    _rcu_advance(rcp);
+    supervisor_interrupt_restore(enabled);
+}
+
+
+void rcu_check_tick(void){
+    if (rcu_cpus[cpu_id()].nesting == 0)
+        rcu_quiescent_state();
+}
+
+
+void call_rcu(rcu_head_t *head, void (*func)(rcu_head_t *head)){
+    head->func = func;
+    head->next = NULL;
+    // 时钟中断会修改回调函数链表, 因此需要关中断
+    Bool enabled = supervisor_interrupt_save();
+    rcu_cpu_t *rcp = &rcu_cpus[cpu_id()];
+    *rcp->next_tail = head;
+    rcp->next_tail = &head->next;
+    supervisor_interrupt_restore(enabled);
+}
+
+
+void synchronize_rcu(void){
+    Bool enabled = supervisor_interrupt_save();
+    // 需要等待一个在调用之后开始的宽限期
+    uint64_t target = __atomic_load_n(&gp_started, __ATOMIC_ACQUIRE) + 1;
+    while (__atomic_load_n(&gp_completed, __ATOMIC_ACQUIRE) < target){
+        uint64_t gp = __atomic_load_n(&gp_started, __ATOMIC_ACQUIRE);
+        if (gp < target && gp == __atomic_load_n(&gp_completed, __ATOMIC_ACQUIRE))
+            __atomic_compare_exchange_n(&gp_started, &gp, gp + 1, False, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+        // 调用者不在读临界区内, 当前CPU处于静止状态
+        rcu_quiescent_state();
+        if (__atomic_load_n(&gp_completed, __ATOMIC_ACQUIRE) >= target)
+            break;
+        // 等待其他CPU的时钟中断报告静止状态
+        supervisor_interrupt_restore(enabled);
+        if (enabled)
+            asm volatile("wfi");
+        enabled = supervisor_interrupt_save();
+    }
+    supervisor_interrupt_restore(enabled);
+}
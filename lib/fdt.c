@@ -0,0 +1,200 @@
+/**
+ * @file fdt.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `fdt.c`是扁平设备树解析函数的实现
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "fdt.h"
+#include "string.h"
+
+/// 令牌和属性值都按照4字节对齐
+#define FDT_ALIGN(x)        (((x) + 3) & ~3UL)
+
+
+/**
+ * @brief `_fdt_struct`返回设备树结构块中偏移为`offset`的地址
+ */
+static inline const uint8_t *_fdt_struct(addr_t dtb, int64_t offset){
+    const fdt_header_t *header = (const fdt_header_t *) dtb;
+    return (const uint8_t *) (dtb + fdt32_to_cpu(header->off_dt_struct) + offset);
+}
+
+
+/**
+ * @brief `_fdt_token`读取结构块中偏移为`offset`的令牌
+ */
+static inline uint32_t _fdt_token(addr_t dtb, int64_t offset){
+    return fdt32_to_cpu(*(const uint32_t *) _fdt_struct(dtb, offset));
+}
+
+
+/**
+ * @brief `_fdt_string`返回字符串块中偏移为`offset`的字符串
+ */
+static inline const char *_fdt_string(addr_t dtb, uint32_t offset){
+    const fdt_header_t *header = (const fdt_header_t *) dtb;
+    return (const char *) (dtb + fdt32_to_cpu(header->off_dt_strings) + offset);
+}
+
+
+/**
+ * @brief `_fdt_next_token`返回偏移为`offset`的令牌之后的下一个令牌的偏移
+ * 
+ * @return int64_t 下一个令牌的偏移, 遇到`FDT_END`或者未知令牌时返回-1
+ */
+static int64_t _fdt_next_token(addr_t dtb, int64_t offset){
+    uint32_t token = _fdt_token(dtb, offset);
+    offset += 4;
+    switch (token){
+        case FDT_BEGIN_NODE:
+            // 节点名以'\0'结尾
+            return FDT_ALIGN(offset + strlen((const char *) _fdt_struct(dtb, offset)) + 1);
+        case FDT_PROP:{
+            // 属性值的长度和属性名在字符串块中的偏移
+            uint32_t len = fdt32_to_cpu(*(const uint32_t *) _fdt_struct(dtb, offset));
+            return FDT_ALIGN(offset + 8 + len);
+        }
+        case FDT_END_NODE:
+        case FDT_NOP:
+            return offset;
+        default:
+            return -1;
+    }
+}
+
+
+Bool fdt_check_header(addr_t dtb){
+    if (dtb == 0 || (dtb & 3) != 0)
+        return False;
+    const fdt_header_t *header = (const fdt_header_t *) dtb;
+    // 版本16之前的设备树格式不同
+    return fdt32_to_cpu(header->magic) == FDT_MAGIC && fdt32_to_cpu(header->last_comp_version) <= 17;
+}
+
+
+const void *fdt_get_property(addr_t dtb, int64_t node, const char *name, uint32_t *len){
+    if (node < 0 || _fdt_token(dtb, node) != FDT_BEGIN_NODE)
+        return NULL;
+    // 节点的属性紧跟在节点名之后, 遇到子节点或者节点结束时停止
+    for (int64_t offset = _fdt_next_token(dtb, node); offset >= 0; offset = _fdt_next_token(dtb, offset)){
+        uint32_t token = _fdt_token(dtb, offset);
+        if (token == FDT_NOP)
+            continue;
+        if (token != FDT_PROP)
+            break;
+        const uint32_t *prop = (const uint32_t *) _fdt_struct(dtb, offset + 4);
+        if (strcmp(_fdt_string(dtb, fdt32_to_cpu(prop[1])), name) == 0){
+            if (len != NULL)
+                *len = fdt32_to_cpu(prop[0]);
+            return &prop[2];
+        }
+    }
+    return NULL;
+}
+
+
+int64_t fdt_find_compatible(addr_t dtb, int64_t start, const char *compatible){
+    int64_t offset = (start < 0) ? 0 : _fdt_next_token(dtb, start);
+    for (; offset >= 0; offset = _fdt_next_token(dtb, offset)){
+        if (_fdt_token(dtb, offset) != FDT_BEGIN_NODE)
+            continue;
+        // compatible属性是多个以'\0'结尾的字符串
+        uint32_t len;
+        const char *str = fdt_get_property(dtb, offset, "compatible", &len);
+        if (str == NULL)
+            continue;
+        const char *end = str + len;
+        while (str < end){
+            if (strcmp(str, compatible) == 0)
+                return offset;
+            str += strlen(str) + 1;
+        }
+    }
+    return -1;
+}
+
+
+Bool fdt_get_u32(addr_t dtb, int64_t node, const char *name, uint32_t index, uint32_t *value){
+    uint32_t len;
+    const uint32_t *prop = fdt_get_property(dtb, node, name, &len);
+    if (prop == NULL || len < (index + 1) * 4)
+        return False;
+    *value = fdt32_to_cpu(prop[index]);
+    return True;
+}
+
+
+/**
+ * @brief `_fdt_isa_match`判断`CPU`节点`cpu`的扩展列表中是否有`ext`
+ */
+static Bool _fdt_isa_match(addr_t dtb, int64_t cpu, const char *ext){
+    uint32_t len;
+    // riscv,isa-extensions是多个以'\0'结尾的扩展名
+    const char *str = fdt_get_property(dtb, cpu, "riscv,isa-extensions", &len);
+    if (str != NULL){
+        for (const char *end = str + len; str < end; str += strlen(str) + 1)
+            if (strcmp(str, ext) == 0)
+                return True;
+        return False;
+    }
+    // riscv,isa形如rv64imafdc_zicsr_sstc, 第一个'_'之前是单字母扩展
+    const char *isa = fdt_get_property(dtb, cpu, "riscv,isa", &len);
+    if (isa == NULL)
+        return False;
+    size_t ext_len = strlen(ext);
+    for (const char *p = strchr(isa, '_'); p != NULL; p = strchr(p, '_')){
+        p++;
+        if (memcmp(p, ext, ext_len) == 0 && (p[ext_len] == '_' || p[ext_len] == '\0'))
+            return True;
+    }
+    return False;
+}
+
+
+Bool fdt_isa_has_extension(addr_t dtb, const char *ext){
+    if (!fdt_check_header(dtb))
+        return False;
+    Bool found = False;
+    // CPU节点的compatible属性为"riscv"
+    for (int64_t cpu = fdt_find_compatible(dtb, -1, "riscv"); cpu >= 0; cpu = fdt_find_compatible(dtb, cpu, "riscv")){
+        if (!_fdt_isa_match(dtb, cpu, ext))
+            return False;
+        found = True;
+    }
+    return found;
+}
+
+
+uint64_t fdt_cpu_mask(addr_t dtb){
+    if (!fdt_check_header(dtb))
+        return 0;
+    uint64_t mask = 0;
+    for (int64_t cpu = fdt_find_compatible(dtb, -1, "riscv"); cpu >= 0; cpu = fdt_find_compatible(dtb, cpu, "riscv")){
+        // 被禁用的CPU不会进入SBI
+        const char *status = fdt_get_property(dtb, cpu, "status", NULL);
+        if (status != NULL && strcmp(status, "okay") != 0)
+            continue;
+        // cpus节点的#address-cells为1, reg即为hartid
+        uint32_t hartid;
+        if (fdt_get_u32(dtb, cpu, "reg", 0, &hartid) && hartid < 64)
+            mask |= 1UL << hartid;
+    }
+    return mask;
+}
+
+
+Bool fdt_get_reg(addr_t dtb, int64_t node, uint64_t index, addr_t *addr, size_t *size){
+    uint32_t len;
+    const uint32_t *prop = fdt_get_property(dtb, node, "reg", &len);
+    // 每个地址区间由2个地址cell和2个大小cell组成
+    if (prop == NULL || len < (index + 1) * 16)
+        return False;
+    prop += index * 4;
+    *addr = ((addr_t) fdt32_to_cpu(prop[0]) << 32) | fdt32_to_cpu(prop[1]);
+    *size = ((size_t) fdt32_to_cpu(prop[2]) << 32) | fdt32_to_cpu(prop[3]);
+    return True;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file kcounter.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `kcounter.c`是内核统计计数器的实现
+ * @version 0.1
+ * @date 2023-06-09
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "kernel/locks.h"
+#include "kernel/kstdio.h"
+#include "kernel/kcounter.h"
+
+// 已注册的计数器链表, 只在注册时修改
+static kcounter_t *kcounter_list = NULL;
+static spinlock_t kcounter_lock = {.next = 0, .owner = 0, .name = "kcounter lock"};
+
+
+int64_t kcounter_read(kcounter_t *counter){
+    int64_t sum = 0;
+    for (uint64_t cpu = 0; cpu < MAX_CPU_NUM; cpu++)
+        sum += atomic64_read(&counter->slots[cpu].value);
+    return sum;
+}
+
+
+int64_t kcounter_read_cpu(kcounter_t *counter, uint64_t cpu){
+    return atomic64_read(&counter->slots[cpu].value);
+}
+
+
+void kcounter_register(kcounter_t *counter){
+    // 第一次注册计数器时注册计数器的锁
+    lockstat_register(&kcounter_lock);
+    spinlock_acquire(&kcounter_lock);
+    // 按照注册的顺序输出. 重复注册时直接返回, 否则计数器会指向自己, kcounter_dump将无限循环
+    kcounter_t **tail = &kcounter_list;
+    while (*tail != NULL){
+        if (*tail == counter){
+            spinlock_release(&kcounter_lock);
+            return;
+        }
+        tail = &(*tail)->next;
+    }
+    counter->next = NULL;
+    __atomic_store_n(tail, counter, __ATOMIC_RELEASE);
+    spinlock_release(&kcounter_lock);
+}
+
+
+void kcounter_dump(void){
+    kprintf("Kernel Counters:\n");
+    kprintf("%-28s %16s", "name", "total");
+    for (uint64_t cpu = 0; cpu < MAX_CPU_NUM; cpu++)
+        kprintf("       cpu%-3lu", cpu);
+    kprintf("\n");
+    for (kcounter_t *counter = __atomic_load_n(&kcounter_list, __ATOMIC_ACQUIRE); counter != NULL; counter = __atomic_load_n(&counter->next, __ATOMIC_ACQUIRE)){
+        kprintf("%-28s %16ld", counter->name, kcounter_read(counter));
+        for (uint64_t cpu = 0; cpu < MAX_CPU_NUM; cpu++)
+            kprintf(" %13ld", kcounter_read_cpu(counter, cpu));
+        kprintf("\n");
+    }
+}
@@ -0,0 +1,230 @@
+/**
+ * @file klog.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `klog.c`是内核日志缓冲区的实现
+ * @version 0.1
+ * @date 2023-06-02
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "stdfmt.h"
+#include "device/uart.h"
+#include "kernel/klog.h"
+#include "kernel/ksmp.h"
+#include "kernel/kconsole.h"
+#include "kernel/ktimer.h"
+
+// 每个CPU的日志环形缓冲区
+klog_ring_t klog_rings[MAX_CPU_NUM];
+
+// 日志的输出模式, 启动阶段为同步模式
+static klog_mode_t volatile klog_mode = KLOG_MODE_SYNC;
+
+// 是否有CPU正在输出日志, 保证同一时刻只有一个消费者. 使用64位变量, 避免字节粒度的原子操作
+static uint64_t volatile klog_draining = 0;
+
+// 待输出的字符, 由日志槽位渲染(加上时间戳)得到
+static char staging[KLOG_SLOT_TEXT_SIZE + 64];
+static size_t staging_len = 0;
+static size_t staging_off = 0;
+
+// 日志等级在输出时的前缀
+static const char *klog_level_prefix[] = {
+    "DEBUG: ", "", "WARN: ", "ERROR: "
+};
+
+
+
+/**
+ * @brief `_klog_push`将一段文本写入日志环形缓冲区`ring`的一个槽位中
+ *
+ * @return Bool 写入成功返回True, 缓冲区满返回False
+ *
+ * @note 中断处理函数可能打断正在写入的生产者, 因此使用`CAS`抢占槽位, 而不是关中断
+ */
+static Bool _klog_push(klog_ring_t *ring, uint8_t level, uint64_t timestamp, const char *text, size_t len){
+    uint64_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    while (True){
+        klog_slot_t *slot = &ring->slots[pos & (KLOG_RING_SLOTS - 1)];
+        uint64_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t) (seq - pos);
+        if (diff == 0){
+            // 槽位空闲, 尝试抢占, 失败时pos将被更新为最新的head
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, True, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+                slot->timestamp = timestamp;
+                slot->level = level;
+                slot->length = (uint8_t) len;
+                memcpy(slot->text, text, len);
+                // 发布槽位, 消费者看到新的sequence时槽位中的数据一定已经写入
+                __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_RELEASE);
+                return True;
+            }
+        } else if (diff < 0)
+            // 槽位尚未被消费者读取, 即缓冲区已满
+            return False;
+        else
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    }
+}
+
+
+/**
+ * @brief `_klog_peek`返回日志环形缓冲区`ring`中下一个可读的槽位, 没有可读的槽位时返回NULL
+ */
+static klog_slot_t *_klog_peek(klog_ring_t *ring){
+    klog_slot_t *slot = &ring->slots[ring->tail & (KLOG_RING_SLOTS - 1)];
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != ring->tail + 1)
+        return NULL;
+    return slot;
+}
+
+
+/**
+ * @brief `_klog_render`从所有CPU的日志环形缓冲区中取出最早的一条日志, 渲染到`staging`中
+ *
+ * @return Bool 取到日志返回True, 所有缓冲区均为空时返回False
+ */
+static Bool _klog_render(void){
+    klog_ring_t *oldest_ring = NULL;
+    klog_slot_t *oldest_slot = NULL;
+    for (int i = 0; i < MAX_CPU_NUM; i++){
+        klog_ring_t *ring = &klog_rings[i];
+        // 先报告丢弃的日志
+        uint64_t dropped = __atomic_exchange_n(&ring->dropped, 0, __ATOMIC_RELAXED);
+        if (dropped != 0){
+            staging_len = sprintf(staging, "\n[klog: cpu %d dropped %lu messages]\n", i, dropped);
+            staging_off = 0;
+            ring->line_start = True;
+            return True;
+        }
+        klog_slot_t *slot = _klog_peek(ring);
+        if (slot != NULL && (oldest_slot == NULL || slot->timestamp < oldest_slot->timestamp))
+            oldest_ring = ring, oldest_slot = slot;
+    }
+    if (oldest_slot == NULL)
+        return False;
+
+    // 行首输出时间戳和日志等级
+    size_t len = 0;
+    if (oldest_ring->line_start){
+        uint64_t sec = oldest_slot->timestamp / CLINT_TIMER_BASE_FRQENCY;
+        uint64_t usec = (oldest_slot->timestamp % CLINT_TIMER_BASE_FRQENCY) / (CLINT_TIMER_BASE_FRQENCY / 1000000);
+        len = sprintf(staging, "[%5lu.%06lu] %s", sec, usec, klog_level_prefix[oldest_slot->level]);
+    }
+    memcpy(staging + len, oldest_slot->text, oldest_slot->length);
+    len += oldest_slot->length;
+    oldest_ring->line_start = oldest_slot->length > 0 && oldest_slot->text[oldest_slot->length - 1] == '\n';
+
+    // 释放槽位, 交给下一轮的生产者
+    uint64_t pos = oldest_ring->tail;
+    oldest_ring->tail = pos + 1;
+    __atomic_store_n(&oldest_slot->sequence, pos + KLOG_RING_SLOTS, __ATOMIC_RELEASE);
+
+    staging_len = len;
+    staging_off = 0;
+    return True;
+}
+
+
+void klog_init(void){
+    for (int i = 0; i < MAX_CPU_NUM; i++){
+        klog_ring_t *ring = &klog_rings[i];
+        ring->head = ring->tail = ring->dropped = 0;
+        ring->line_start = True;
+        for (int j = 0; j < KLOG_RING_SLOTS; j++)
+            ring->slots[j].sequence = j;
+    }
+}
+
+
+/**
+ * @brief `_klog_sync_output`以轮询的方式输出缓冲区中剩余的日志, 调用者需要持有`klog_draining`
+ */
+static void _klog_sync_output(void){
+    do {
+        while (staging_off < staging_len)
+            uart_put(staging[staging_off++]);
+    } while (_klog_render());
+}
+
+
+void klog_set_mode(klog_mode_t mode){
+    if (mode == KLOG_MODE_SYNC){
+        // 先切换模式, 之后的日志将直接输出, 之后进入klog_drain的CPU将直接返回
+        klog_mode = KLOG_MODE_SYNC;
+        // 发送环形缓冲区中的字符在缓冲区中的日志之前, 需要先发送
+        kconsole_flush();
+        // 等待正在输出日志的CPU完成, 否则两个CPU会同时修改staging_off
+        while (__atomic_exchange_n(&klog_draining, 1, __ATOMIC_ACQUIRE))
+            ;
+        _klog_sync_output();
+        __atomic_store_n(&klog_draining, 0, __ATOMIC_RELEASE);
+    } else
+        klog_mode = mode;
+}
+
+
+void klog_panic(void){
+    klog_mode = KLOG_MODE_SYNC;
+    // 崩溃可能发生在当前CPU持有控制台的锁时, 因此不能使用kconsole_flush
+    kconsole_panic_flush();
+    /*
+     * 内核崩溃时可能正好打断了当前CPU上正在输出日志的klog_drain, 等待klog_draining会死锁,
+     * 因此这里不检查klog_draining, 最坏情况下会重复输出一部分日志
+     */
+    _klog_sync_output();
+    __atomic_store_n(&klog_draining, 0, __ATOMIC_RELEASE);
+}
+
+
+void klog_write(klog_level_t level, const char *text, size_t len){
+    if (klog_mode == KLOG_MODE_SYNC){
+        for (size_t i = 0; i < len; i++)
+            uart_put(text[i]);
+        return;
+    }
+
+    klog_ring_t *ring = &klog_rings[cpu_id()];
+    uint64_t timestamp = get_cycle();
+    // 长日志拆分到多个槽位中
+    do {
+        size_t chunk = len > KLOG_SLOT_TEXT_SIZE ? KLOG_SLOT_TEXT_SIZE : len;
+        if (!_klog_push(ring, level, timestamp, text, chunk)){
+            // 缓冲区满, 当前和剩余的分段全部丢弃, 每个分段计为一条日志
+            __atomic_fetch_add(&ring->dropped, 1 + (len - chunk + KLOG_SLOT_TEXT_SIZE - 1) / KLOG_SLOT_TEXT_SIZE, __ATOMIC_RELAXED);
+            return;
+        }
+        text += chunk, len -= chunk;
+    } while (len > 0);
+}
+
+
+size_t klogf(klog_level_t level, const char *format, ...){
+    va_list args;
+    va_start(args, format);
+    char buf[PRINTF_STRING_SIZE] = {0};
+    size_t len = vsprintf(buf, format, args);
+    va_end(args);
+    klog_write(level, buf, len);
+    return len;
+}
+
+
+void klog_drain(void){
+    if (klog_mode == KLOG_MODE_SYNC)
+        return;
+    // 已经有CPU在输出日志
+    if (__atomic_exchange_n(&klog_draining, 1, __ATOMIC_ACQUIRE))
+        return;
+    while (True){
+        if (staging_off == staging_len && !_klog_render())
+            break;
+        size_t written = kconsole_try_write(staging + staging_off, staging_len - staging_off);
+        staging_off += written;
+        // 控制台的发送环形缓冲区已满, 等待下一次输出
+        if (written == 0)
+            break;
+    }
+    __atomic_store_n(&klog_draining, 0, __ATOMIC_RELEASE);
+}
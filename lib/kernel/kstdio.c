@@ -10,14 +10,15 @@
  * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
  */
 
+#include "kernel/klog.h"
 #include "kernel/kstdio.h"
 
 size_t kprintf(const char* format, ...){
     va_list args;
     va_start(args, format);
     char buf[PRINTF_STRING_SIZE] = {0};
-    vsprintf(buf, format, args);
+    size_t len = vsprintf(buf, format, args);
     va_end(args);
-    uart_puts((const char*)buf);
-    return strlen(buf);
+    klog_write(KLOG_INFO, buf, len);
+    return len;
 }
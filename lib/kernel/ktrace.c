@@ -0,0 +1,85 @@
+/**
+ * @file ktrace.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `ktrace.c`是内核二进制跟踪点的实现
+ * @version 0.1
+ * @date 2023-06-06
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "stdfmt.h"
+#include "kernel/ktrace.h"
+#include "kernel/ksmp.h"
+#include "kernel/ktimer.h"
+#include "kernel/kconsole.h"
+
+// 每个CPU的跟踪缓冲区
+ktrace_ring_t ktrace_rings[MAX_CPU_NUM];
+
+// 是否打开跟踪
+static Bool volatile ktrace_enabled = True;
+
+// 是否有CPU正在输出跟踪缓冲区, 同一时刻只有一个CPU输出
+static uint64_t volatile ktrace_dumping = 0;
+
+// 输出使用的行缓冲区, 由ktrace_dumping保护. ktrace_dump在中断栈上的tasklet中运行, 不在栈上分配
+static char ktrace_line[PRINTF_STRING_SIZE];
+
+
+
+void ktrace_record(const char *fmt, uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3){
+    if (!ktrace_enabled)
+        return;
+    ktrace_ring_t *ring = &ktrace_rings[cpu_id()];
+    // 中断可能打断正在记录的事件, 因此使用原子操作分配序号
+    uint64_t pos = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    ktrace_event_t *event = &ring->events[pos & (KTRACE_RING_EVENTS - 1)];
+    event->sequence = 0;
+    event->timestamp = get_cycle();
+    event->fmt = fmt;
+    event->args[0] = a0;
+    event->args[1] = a1;
+    event->args[2] = a2;
+    event->args[3] = a3;
+    __atomic_store_n(&event->sequence, pos + 1, __ATOMIC_RELEASE);
+}
+
+
+void ktrace_set_enable(Bool enable){
+    ktrace_enabled = enable;
+}
+
+
+void ktrace_dump(void){
+    if (__atomic_exchange_n(&ktrace_dumping, 1, __ATOMIC_ACQUIRE))
+        return;
+    Bool enabled = ktrace_enabled;
+    ktrace_enabled = False;
+
+    char *line = ktrace_line;
+    size_t len = sprintf(line, "KTRACE BEGIN %lx\n", (uint64_t) CLINT_TIMER_BASE_FRQENCY);
+    kconsole_write(line, len);
+    for (int cpu = 0; cpu < MAX_CPU_NUM; cpu++){
+        ktrace_ring_t *ring = &ktrace_rings[cpu];
+        uint64_t head = ring->head;
+        uint64_t pos = head > KTRACE_RING_EVENTS ? head - KTRACE_RING_EVENTS : 0;
+        for (; pos < head; pos++){
+            ktrace_event_t *event = &ring->events[pos & (KTRACE_RING_EVENTS - 1)];
+            // 跳过正在写入的事件
+            if (__atomic_load_n(&event->sequence, __ATOMIC_ACQUIRE) != pos + 1)
+                continue;
+            len = sprintf(
+                line, "KT %x %lx %lx %lx %lx %lx %lx %lx\n",
+                cpu, pos, event->timestamp, (uint64_t) event->fmt,
+                event->args[0], event->args[1], event->args[2], event->args[3]
+            );
+            kconsole_write(line, len);
+        }
+    }
+    len = sprintf(line, "KTRACE END\n");
+    kconsole_write(line, len);
+
+    ktrace_enabled = enabled;
+    __atomic_store_n(&ktrace_dumping, 0, __ATOMIC_RELEASE);
+}
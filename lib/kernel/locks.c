@@ -2,53 +2,336 @@
  * @file locks.c
  * @author Shihong Wang (jack4shihong@gmail.com)
  * @brief `locks.h`为操作系统提供了锁的实现
- * @version 0.1
+ * @version 0.2
  * @date 2023-05-15
- * 
+ *
  * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
  */
 
+#include "string.h"
+#include "constrains.h"
 #include "kernel/ktrap.h"
+#include "kernel/percpu.h"
 #include "kernel/locks.h"
+#include "kernel/kstdio.h"
 
 
-void spinlock_init(spinlock_t *lock, char *name){
-    lock->locked = False;
-    lock->name = name;
+// 每个CPU关中断的嵌套深度, 以及最外层关中断之前中断是否是打开的
+static DEFINE_PER_CPU(uint64_t, intr_depth);
+static DEFINE_PER_CPU(Bool, intr_enabled);
+
+
+#if LOCKSTAT_ENABLE == 1
+// 已经加入统计的锁
+static lockstat_t *lockstat_list[LOCKSTAT_MAX_LOCKS];
+static uint64_t volatile lockstat_num = 0;
+
+
+void lockstat_register_stat(lockstat_t *stat, const char *name){
+    // 多个CPU可能同时注册同一个锁, 只有一个可以加入统计列表
+    if (__atomic_exchange_n(&stat->registered, 1, __ATOMIC_ACQ_REL))
+        return;
+    stat->name = name;
+    uint64_t idx = __atomic_fetch_add(&lockstat_num, 1, __ATOMIC_RELAXED);
+    if (idx < LOCKSTAT_MAX_LOCKS)
+        __atomic_store_n(&lockstat_list[idx], stat, __ATOMIC_RELEASE);
 }
 
-void spinlock_acquire(spinlock_t *lock){
-    // 关闭中断以避免死锁
-    supervisor_interrupt_disable();
-    // 如果没有获得锁则循环在此
-    while (__sync_lock_test_and_set(&lock->locked, True) != 0);
+
+/**
+ * @brief `_lockstat_acquired`在获得锁之后记录本次等待的时钟周期数
+ *
+ * @param stat 锁的统计信息
+ * @param wait_start 开始等待时的时钟周期数
+ * @param contended 开始等待时锁是否已经被持有
+ */
+static void _lockstat_acquired(lockstat_t *stat, uint64_t wait_start, Bool contended){
+    uint64_t now = read_csr(cycle);
+    uint64_t wait = now - wait_start;
+    // 持有锁时修改, 不需要原子操作
+    stat->acquisitions++;
+    stat->contended += contended ? 1 : 0;
+    stat->wait_total += wait;
+    if (wait > stat->wait_max)
+        stat->wait_max = wait;
+    stat->hold_start = now;
+}
+
+
+/**
+ * @brief `_lockstat_releasing`在释放锁之前记录本次持有的时钟周期数
+ *
+ * @param stat 锁的统计信息
+ */
+static void _lockstat_releasing(lockstat_t *stat){
+    uint64_t hold = read_csr(cycle) - stat->hold_start;
+    stat->hold_total += hold;
+    if (hold > stat->hold_max)
+        stat->hold_max = hold;
+}
+
+#define LOCKSTAT_WAIT_START()                           uint64_t __wait_start = read_csr(cycle)
+#define LOCKSTAT_ACQUIRED(lock, contended)              _lockstat_acquired(&(lock)->stat, __wait_start, contended)
+#define LOCKSTAT_RELEASING(lock)                        _lockstat_releasing(&(lock)->stat)
+#else
+#define LOCKSTAT_WAIT_START()
+#define LOCKSTAT_ACQUIRED(lock, contended)
+#define LOCKSTAT_RELEASING(lock)
+#endif
+
+
+
+/**
+ * @brief `_intr_push`关闭中断并增加关中断的嵌套深度, 最外层时保存之前的中断状态
+ */
+static inline void _intr_push(void){
+    Bool enabled = supervisor_interrupt_save();
+    // 中断已经关闭, 不需要原子操作
+    uint64_t *depth = this_cpu_ptr(intr_depth);
+    if ((*depth)++ == 0)
+        this_cpu_write(intr_enabled, enabled);
+}
+
+
+/**
+ * @brief `_intr_pop`减少关中断的嵌套深度, 最外层时恢复之前的中断状态
+ */
+static inline void _intr_pop(void){
+    if (--(*this_cpu_ptr(intr_depth)) == 0)
+        supervisor_interrupt_restore(this_cpu_read(intr_enabled));
+}
+
+
+/**
+ * @brief `_ticket_lock`领取号码并等待叫号
+ */
+static inline void _ticket_lock(spinlock_t *lock){
+    LOCKSTAT_WAIT_START();
     /*
+     * 领取号码使用原子加(amoadd), 等待叫号时只读取`owner`, 不会像test_and_set一样反复写入同一个缓存行
+     *
      * 由于RISC-V是弱内存模型, 因此内存访问指令在CPU内部是乱序执行的.
      * 所以这里可能会导致一个问题: 可能在获得锁之前就运行了临界区内的内存访问指令
-     * 这里借助GCC的__sync_synchronize手动触发一个内存屏障指令(fence)
-     * 内存屏障指令通知`CPU`在执行阶段后续的临界区内的内存访问指令不会在下面这个函数运行前执行
-     * 从而确保临界区内的内存访问指令一定在获得锁之后执行
-     * 
-     * PS: RISC-V的内存模型是RVWMO, 所以其实是存在多种内存屏障的
-     *     而GCC实现的__sync_synchronize是一个双向内存屏障
+     * 这里使用acquire语义读取`owner`, 确保临界区内的内存访问指令一定在获得锁之后执行
+     *
+     * PS: RISC-V的内存模型是RVWMO, acquire语义对应`fence r,rw`
      */
-    __sync_synchronize();
+    uint64_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    Bool contended = __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket;
+    if (contended)
+        while (__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket);
+    LOCKSTAT_ACQUIRED(lock, contended);
 }
 
-void spinlock_release(spinlock_t *lock){
+
+/**
+ * @brief `_ticket_unlock`叫下一个号
+ */
+static inline void _ticket_unlock(spinlock_t *lock){
     /*
-     * 由于RISC-V是弱内存模型, 因此内存访问指令在CPU内部是乱序执行的.
-     * 所以这里可能会导致一个问题: 可能在临界区内的内存访问指令在释放锁之后运行
-     * 这里借助GCC的__sync_synchronize手动触发一个内存屏障指令(fence)
-     * 内存屏障指令通知`CPU`在执行阶段先前临界区内的内存访问指令不会在下面这个函数运行后执行
-     * 从而确保临界区内的内存访问指令一定在释放锁前运行
-     * 
-     * PS: RISC-V的内存模型是RVWMO, 所以其实是存在多种内存屏障的
-     *     而GCC实现的__sync_synchronize是一个双向内存屏障
+     * 只有持有锁的CPU会修改`owner`, 因此不需要原子加.
+     * 这里使用release语义写入`owner`, 确保临界区内的内存访问指令一定在释放锁前运行
+     *
+     * PS: release语义对应`fence rw,w`
      */
-    __sync_synchronize();
-    // 释放锁
-    __sync_lock_release(&lock->locked);
-    // 开中断
-    supervisor_interrupt_enable();
-}
\ No newline at end of file
+    LOCKSTAT_RELEASING(lock);
+    __atomic_store_n(&lock->owner, lock->owner + 1, __ATOMIC_RELEASE);
+}
+
+
+void spinlock_init(spinlock_t *lock, char *name){
+    lock->next = 0;
+    lock->owner = 0;
+    lock->name = name;
+#if LOCKSTAT_ENABLE == 1
+    memset(&lock->stat, 0, sizeof(lockstat_t));
+#endif
+}
+
+void spinlock_acquire(spinlock_t *lock){
+    // 关闭中断以避免死锁
+    _intr_push();
+    _ticket_lock(lock);
+}
+
+void spinlock_release(spinlock_t *lock){
+    _ticket_unlock(lock);
+    // 最外层的锁被释放后才恢复中断
+    _intr_pop();
+}
+
+Bool spinlock_acquire_irqsave(spinlock_t *lock){
+    Bool enabled = supervisor_interrupt_save();
+    _ticket_lock(lock);
+    return enabled;
+}
+
+void spinlock_release_irqrestore(spinlock_t *lock, Bool enabled){
+    _ticket_unlock(lock);
+    supervisor_interrupt_restore(enabled);
+}
+
+Bool spinlock_holding(spinlock_t *lock){
+    return lock->next != __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE);
+}
+
+
+void mcslock_init(mcslock_t *lock, char *name){
+    lock->tail = NULL;
+    lock->name = name;
+#if LOCKSTAT_ENABLE == 1
+    memset(&lock->stat, 0, sizeof(lockstat_t));
+#endif
+}
+
+void mcslock_acquire(mcslock_t *lock, mcs_node_t *node){
+    _intr_push();
+    LOCKSTAT_WAIT_START();
+    node->next = NULL;
+    node->waiting = True;
+    // 将自己加入队尾, 之前的队尾即为前一个等待者
+    mcs_node_t *prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (prev != NULL){
+        __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+        // 只在自己的节点上自旋, 前一个等待者释放锁时会修改`waiting`
+        while (__atomic_load_n(&node->waiting, __ATOMIC_ACQUIRE));
+    }
+    LOCKSTAT_ACQUIRED(lock, prev != NULL);
+}
+
+void mcslock_release(mcslock_t *lock, mcs_node_t *node){
+    LOCKSTAT_RELEASING(lock);
+    mcs_node_t *next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+    if (next == NULL){
+        // 没有等待者, 将锁设置为空闲
+        mcs_node_t *expected = node;
+        if (__atomic_compare_exchange_n(&lock->tail, &expected, NULL, False, __ATOMIC_RELEASE, __ATOMIC_RELAXED)){
+            _intr_pop();
+            return;
+        }
+        // 有新的等待者正在加入队列, 等待其设置`next`
+        while ((next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)) == NULL);
+    }
+    __atomic_store_n(&next->waiting, False, __ATOMIC_RELEASE);
+    _intr_pop();
+}
+
+
+void rwlock_init(rwlock_t *lock, char *name){
+    lock->next = 0;
+    lock->read_owner = 0;
+    lock->write_owner = 0;
+    lock->name = name;
+}
+
+void rwlock_read_acquire(rwlock_t *lock){
+    _intr_push();
+    uint64_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&lock->read_owner, __ATOMIC_ACQUIRE) != ticket);
+    // 只有当前读者会修改`read_owner`, 之后的读者可以立即获得锁
+    __atomic_store_n(&lock->read_owner, ticket + 1, __ATOMIC_RELEASE);
+}
+
+Bool rwlock_try_read_acquire(rwlock_t *lock){
+    _intr_push();
+    uint64_t ticket = __atomic_load_n(&lock->next, __ATOMIC_RELAXED);
+    // `read_owner`等于`next`时没有写者持有锁或者正在等待
+    if (__atomic_load_n(&lock->read_owner, __ATOMIC_ACQUIRE) == ticket
+        && __atomic_compare_exchange_n(&lock->next, &ticket, ticket + 1, False, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+        __atomic_store_n(&lock->read_owner, ticket + 1, __ATOMIC_RELEASE);
+        return True;
+    }
+    _intr_pop();
+    return False;
+}
+
+void rwlock_read_release(rwlock_t *lock){
+    // 多个读者可能同时释放, 因此需要原子加
+    __atomic_fetch_add(&lock->write_owner, 1, __ATOMIC_RELEASE);
+    _intr_pop();
+}
+
+void rwlock_write_acquire(rwlock_t *lock){
+    _intr_push();
+    uint64_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_RELAXED);
+    while (__atomic_load_n(&lock->write_owner, __ATOMIC_ACQUIRE) != ticket);
+}
+
+void rwlock_write_release(rwlock_t *lock){
+    // 持有写锁时没有其他CPU修改`read_owner`和`write_owner`
+    __atomic_store_n(&lock->read_owner, lock->read_owner + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&lock->write_owner, lock->write_owner + 1, __ATOMIC_RELEASE);
+    _intr_pop();
+}
+
+
+void seqlock_init(seqlock_t *lock, char *name){
+    lock->sequence = 0;
+    spinlock_init(&lock->lock, name);
+}
+
+void seqlock_write_begin(seqlock_t *lock){
+    spinlock_acquire(&lock->lock);
+    lock->sequence++;
+    // 保证序号变为奇数之后才写入数据
+    asm volatile("fence w,w" ::: "memory");
+}
+
+void seqlock_write_end(seqlock_t *lock){
+    // 保证数据写入完成之后序号才变为偶数
+    asm volatile("fence w,w" ::: "memory");
+    lock->sequence++;
+    spinlock_release(&lock->lock);
+}
+
+
+#if LOCKSTAT_ENABLE == 1
+void lockstat_dump(void){
+    uint64_t num = lockstat_num < LOCKSTAT_MAX_LOCKS ? lockstat_num : LOCKSTAT_MAX_LOCKS;
+    // 按照等待的总时钟周期数从多到少插入排序, 锁的数量很少. 注册时先增加lockstat_num再写入, 跳过还没有写入的项
+    lockstat_t *sorted[LOCKSTAT_MAX_LOCKS];
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < num; i++){
+        lockstat_t *stat = __atomic_load_n(&lockstat_list[i], __ATOMIC_ACQUIRE);
+        if (stat == NULL)
+            continue;
+        uint64_t j = count++;
+        for (; j > 0 && sorted[j - 1]->wait_total < stat->wait_total; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = stat;
+    }
+
+    kprintf("Lock Statistics (in CPU cycles):\n");
+    kprintf("%-20s %10s %10s %12s %10s %12s %10s\n", "name", "acquire", "contended", "wait-total", "wait-max", "hold-total", "hold-max");
+    for (uint64_t i = 0; i < count; i++)
+        kprintf(
+            "%-20s %10lu %10lu %12lu %10lu %12lu %10lu\n",
+            sorted[i]->name, sorted[i]->acquisitions, sorted[i]->contended,
+            sorted[i]->wait_total, sorted[i]->wait_max, sorted[i]->hold_total, sorted[i]->hold_max
+        );
+    if (lockstat_num > LOCKSTAT_MAX_LOCKS)
+        kprintf("%lu locks not shown, increase LOCKSTAT_MAX_LOCKS\n", lockstat_num - LOCKSTAT_MAX_LOCKS);
+}
+
+void lockstat_reset(void){
+    uint64_t num = lockstat_num < LOCKSTAT_MAX_LOCKS ? lockstat_num : LOCKSTAT_MAX_LOCKS;
+    for (uint64_t i = 0; i < num; i++){
+        lockstat_t *stat = __atomic_load_n(&lockstat_list[i], __ATOMIC_ACQUIRE);
+        if (stat == NULL)
+            continue;
+        stat->acquisitions = stat->contended = 0;
+        stat->wait_total = stat->wait_max = 0;
+        stat->hold_total = stat->hold_max = 0;
+    }
+}
+#else
+void lockstat_register_stat(lockstat_t *stat UNUSED, const char *name UNUSED){
+}
+
+void lockstat_dump(void){
+    kprintf("Lock Statistics: disabled, set LOCKSTAT_ENABLE to 1 in constrains.h\n");
+}
+
+void lockstat_reset(void){
+}
+#endif
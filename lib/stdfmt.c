@@ -43,6 +43,77 @@
 })
 
 
+/**
+ * @brief `_mulhu`返回`a * b`的128位乘积的高64位
+ * 
+ * @note 编译时没有链接`libgcc`, 因此不能使用`__uint128_t`, 直接使用`mulhu`指令
+ */
+static inline uint64_t _mulhu(uint64_t a, uint64_t b){
+    uint64_t hi;
+    asm volatile("mulhu %0, %1, %2" : "=r"(hi) : "r"(a), "r"(b));
+    return hi;
+}
+
+// 使用乘法代替除法, 计算num / 100, 对所有64位无符号整数都成立
+#define div_by_100(num)     (_mulhu((num) >> 2, 0x28F5C28F5C28F5C3UL) >> 2)
+
+// `digit_pairs`是00~99的两位数字表, 十进制转换的时候每次输出两位, 除法次数减半
+static const char digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+
+/**
+ * @brief `_convert_number`将`num`按照`base`进制转换为字符串数字, 逆序(低位在前)存入`buf`中
+ * 
+ * @param buf 接受输出的字符数组, 至少需要64个字节
+ * @param num 需要转换的数字
+ * @param base 进制, 2~36
+ * @param digits 数字字符表
+ * @return int 转换得到的位数
+ * 
+ * @note 十进制使用两位数字表和乘法逆元, 2的幂次进制使用移位和掩码, 其他进制才使用除法
+ */
+static int _convert_number(char *buf, uint64_t num, int base, const char *digits){
+    int i = 0;
+    if (base == 10){
+        while (num >= 100){
+            uint64_t quotient = div_by_100(num);
+            uint64_t remain = num - quotient * 100;
+            buf[i++] = digit_pairs[remain * 2 + 1];
+            buf[i++] = digit_pairs[remain * 2];
+            num = quotient;
+        }
+        if (num >= 10){
+            buf[i++] = digit_pairs[num * 2 + 1];
+            buf[i++] = digit_pairs[num * 2];
+        } else
+            buf[i++] = '0' + num;
+    } else if ((base & (base - 1)) == 0){
+        int shift = 0;
+        while ((1 << shift) < base)
+            shift++;
+        do {
+            buf[i++] = digits[num & (base - 1)];
+            num >>= shift;
+        } while (num != 0);
+    } else {
+        do {
+            buf[i++] = digits[do_div(num, base)];
+        } while (num != 0);
+    }
+    return i;
+}
+
+
 const char* _scan_number(const char *str, int* num){
     int tmp = 0;
     while (is_digit(*str)){
@@ -57,7 +128,7 @@ const char* _scan_number(const char *str, int* num){
 char *copy_number(char *str, unsigned long num, int base, int width, int precision, int flag){
     char pad_char;
     char sign = '\0';
-    char char_num[128];
+    char char_num[64];
 
     // 处理大小写
     const char *digits = "0123456789abcdefghijklmnopqrstuvwxyz";
@@ -94,12 +165,7 @@ char *copy_number(char *str, unsigned long num, int base, int width, int precisi
     }
 
     // int数字转为字符串数字
-    int i = 0;
-    if (num == 0)
-        char_num[i++] = '0';
-    else
-        while (num != 0)
-            char_num[i++] = digits[do_div(num, base)];
+    int i = _convert_number(char_num, num, base, digits);
     
     // 计算输出的精度
     precision = i > precision ? i : precision;
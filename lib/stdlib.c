@@ -15,16 +15,16 @@
 #define INT_MIN -2147483648
 
 void itoa(uint64_t integer, char** buf_ptr_addr, uint8_t base){
-    // 使用递归来完成转换
-    uint64_t remain = integer % base;       // 余数
-    uint64_t quotient = integer / base;     // 商
-    // 没有处理到最高位则继续处理
-    if (quotient)
-        itoa(quotient, buf_ptr_addr, base);
-    if (remain < 10)
-        *((*buf_ptr_addr)++) = remain + '0';
-    else
-        *((*buf_ptr_addr)++) = remain - 10 + 'A';
+    // 先从低位到高位逆序写入临时数组, 再正序复制, 避免递归
+    char reversed[64];
+    int i = 0;
+    do {
+        uint64_t remain = integer % base;   // 余数
+        integer /= base;                    // 商
+        reversed[i++] = remain < 10 ? remain + '0' : remain - 10 + 'A';
+    } while (integer != 0);
+    while (i-- > 0)
+        *((*buf_ptr_addr)++) = reversed[i];
 }
 
 int64_t atoi(char* str){
@@ -84,4 +84,36 @@ list_elem_t* list_walking(list_t *list_ptr, list_walking_func_t func, int arg){
         walking_ptr = walking_ptr->next;
     }
     return NULL;
-}
\ No newline at end of file
+}
+
+
+void list_insert_rcu(list_elem_t *before_ptr, list_elem_t *add_ptr){
+    // 先初始化新节点, 读者此时还看不到新节点
+    add_ptr->prev = before_ptr->prev;
+    add_ptr->next = before_ptr;
+    // 发布新节点, release语义保证读者看到新节点时其内容已经写入
+    __atomic_store_n(&before_ptr->prev->next, add_ptr, __ATOMIC_RELEASE);
+    // 读者只向后遍历, 因此prev可以直接修改
+    before_ptr->prev = add_ptr;
+}
+
+void list_append_rcu(list_elem_t *elem_ptr, list_t *list_ptr){
+    list_insert_rcu(&list_ptr->tail, elem_ptr);
+}
+
+void list_push_rcu(list_elem_t *elem_ptr, list_t *list_ptr){
+    list_insert_rcu(list_ptr->head.next, elem_ptr);
+}
+
+void list_remove_rcu(list_elem_t *elem_ptr){
+    // 跳过被删除的节点, 被删除节点的next保持不变, 正在访问它的读者可以继续遍历
+    __atomic_store_n(&elem_ptr->prev->next, elem_ptr->next, __ATOMIC_RELEASE);
+    elem_ptr->next->prev = elem_ptr->prev;
+}
+
+list_elem_t* list_walking_rcu(list_t *list_ptr, list_walking_func_t func, int arg){
+    for (list_elem_t *walking_ptr = list_first_rcu(list_ptr); walking_ptr != &list_ptr->tail; walking_ptr = list_next_rcu(walking_ptr))
+        if (func(walking_ptr, arg))
+            return walking_ptr;
+    return NULL;
+}
@@ -35,8 +35,31 @@ void print_strapframe(strapframe_t *stf_ptr, printf_t print_func){
 }
 
 
+/**
+ * @brief `_print_partial_ktrapframe`用于输出中断快速入口构建的部分陷入帧, 只输出保存了的寄存器
+ */
+static void _print_partial_ktrapframe(ktrapframe_t *ktf_ptr, printf_t print_func){
+    printf_t printf = print_func;
+    gtrapframe_t *gtf_ptr = &ktf_ptr->gregisters;
+    printf("Print Partial Kernel Trap Frame at: %#016X\n", (void*)ktf_ptr);
+    printf("sepc: %#016lX                  sstatus : %#016lX\n", ktf_ptr->sepc, ktf_ptr->sstatus);
+	printf(" ra : %#016lX t0 : %#016lX t1 : %#016lX\n", gtf_ptr->ra, gtf_ptr->t0, gtf_ptr->t1);
+	printf(" t2 : %#016lX t3 : %#016lX t4 : %#016lX\n", gtf_ptr->t2, gtf_ptr->t3, gtf_ptr->t4);
+	printf(" t5 : %#016lX t6 : %#016lX a0 : %#016lX\n", gtf_ptr->t5, gtf_ptr->t6, gtf_ptr->a0);
+	printf(" a1 : %#016lX a2 : %#016lX a3 : %#016lX\n", gtf_ptr->a1, gtf_ptr->a2, gtf_ptr->a3);
+	printf(" a4 : %#016lX a5 : %#016lX a6 : %#016lX\n", gtf_ptr->a4, gtf_ptr->a5, gtf_ptr->a6);
+	// 快速入口在被打断的程序的栈上分配陷入帧, 因此被打断时的sp就是陷入帧的末尾
+	printf(" a7 : %#016lX sp : %#016lX\n", gtf_ptr->a7, (addr_t)ktf_ptr + sizeof(ktrapframe_t));
+	printf(" gp, tp, s0~s11 are not saved in partial trap frame\n");
+}
+
+
 void print_ktrapframe(ktrapframe_t *ktf_ptr, printf_t print_func){
     printf_t printf = print_func;
+    if (ktf_ptr->frame_type == KTF_FRAME_PARTIAL){
+        _print_partial_ktrapframe(ktf_ptr, print_func);
+        return;
+    }
     printf("Print Kernel Trap Frame at: %#016X\n", (void*)ktf_ptr);
 	printf("origin_a0: %#016lX\n", ktf_ptr->origin_a0);
     printf("sepc: %#016lX                  sstatus : %#016lX\n", ktf_ptr->sepc, ktf_ptr->sstatus);
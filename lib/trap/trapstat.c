@@ -0,0 +1,84 @@
+/**
+ * @file trapstat.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `trapstat.c`是陷入统计的实现
+ * @version 0.1
+ * @date 2023-06-17
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "trap/trapstat.h"
+
+
+/**
+ * @brief `_trapstat_bucket`计算处理时间`cycles`所在的直方图的桶, 即`cycles`以2为底的对数
+ *
+ * @note 内核不链接`libgcc`, 没有`Zbb`扩展时`__builtin_clzl`需要调用`libgcc`中的函数, 因此逐位计算
+ */
+static uint64_t _trapstat_bucket(uint64_t cycles){
+    uint64_t bucket = 0;
+    while (cycles > 1 && bucket < TRAPSTAT_BUCKET_NUM - 1){
+        cycles >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+
+void trapstat_record(trapstat_table_t *table, uint64_t hartid, Bool interrupt, uint64_t trap_code, uint64_t cycles){
+    if (hartid >= MAX_CPU_NUM || trap_code >= TRAPSTAT_CAUSE_NUM)
+        return;
+    trapstat_t *stat = &(interrupt ? table->intr : table->excp)[hartid][trap_code];
+    stat->count++;
+    stat->total += cycles;
+    if (cycles > stat->max)
+        stat->max = cycles;
+    stat->buckets[_trapstat_bucket(cycles)]++;
+}
+
+
+/**
+ * @brief `_trapstat_dump_cause`输出一个中断/异常号在所有`HART`上的统计信息, 没有发生过时不输出
+ */
+static void _trapstat_dump_cause(trapstat_t (*stats)[TRAPSTAT_CAUSE_NUM], uint64_t trap_code, const char *kind, const char *msg, printf_t print_func){
+    printf_t printf = print_func;
+    uint64_t count = 0;
+    uint64_t buckets[TRAPSTAT_BUCKET_NUM] = {0};
+    for (uint64_t hart = 0; hart < MAX_CPU_NUM; hart++){
+        count += stats[hart][trap_code].count;
+        for (uint64_t i = 0; i < TRAPSTAT_BUCKET_NUM; i++)
+            buckets[i] += stats[hart][trap_code].buckets[i];
+    }
+    if (count == 0)
+        return;
+
+    printf("%s %2lu: %s\n", kind, trap_code, msg != NULL ? msg : "Unknown");
+    for (uint64_t hart = 0; hart < MAX_CPU_NUM; hart++){
+        trapstat_t *stat = &stats[hart][trap_code];
+        if (stat->count == 0)
+            continue;
+        printf("\thart%-3lu count %12lu  avg %10lu  max %10lu\n", hart, stat->count, stat->total / stat->count, stat->max);
+    }
+    // 直方图只输出非空的桶, <2^(i+1)表示处理时间在[2^i, 2^(i+1))内
+    printf("\thistogram:");
+    for (uint64_t i = 0; i < TRAPSTAT_BUCKET_NUM; i++){
+        if (buckets[i] == 0)
+            continue;
+        if (i == TRAPSTAT_BUCKET_NUM - 1)
+            printf(" >=2^%lu:%lu", i, buckets[i]);
+        else
+            printf(" <2^%lu:%lu", i + 1, buckets[i]);
+    }
+    printf("\n");
+}
+
+
+void trapstat_dump(trapstat_table_t *table, const char **intr_msg, const char **excp_msg, const char *unit, printf_t print_func){
+    printf_t printf = print_func;
+    printf("Trap Statistics (time in %s):\n", unit);
+    for (uint64_t trap_code = 0; trap_code < TRAPSTAT_CAUSE_NUM; trap_code++)
+        _trapstat_dump_cause(table->intr, trap_code, "Interrupt", intr_msg[trap_code], print_func);
+    for (uint64_t trap_code = 0; trap_code < TRAPSTAT_CAUSE_NUM; trap_code++)
+        _trapstat_dump_cause(table->excp, trap_code, "Exception", excp_msg[trap_code], print_func);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file saia.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `saia.c`是`SBI`的`AIA`中断控制器初始化模块的实现
+ * @version 0.1
+ * @date 2023-06-14
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "io.h"
+#include "fdt.h"
+#include "asm/aia.h"
+#include "asm/csr.h"
+#include "sbi/saia.h"
+#include "sbi/sstdio.h"
+
+
+/**
+ * @brief `_saia_find_imsic`查找向`ext_irq`(M模式或S模式的外部中断)发送中断的`IMSIC`节点
+ * 
+ * @param dtb 设备树的地址
+ * @param ext_irq `interrupts-extended`属性中的中断号
+ * @return int64_t 节点的偏移, 没有找到返回-1
+ */
+static int64_t _saia_find_imsic(addr_t dtb, uint32_t ext_irq){
+    for (int64_t node = fdt_find_compatible(dtb, -1, "riscv,imsics"); node >= 0; node = fdt_find_compatible(dtb, node, "riscv,imsics")){
+        // interrupts-extended由<phandle 中断号>组成, 所有HART的中断号都相同
+        uint32_t irq;
+        if (fdt_get_u32(dtb, node, "interrupts-extended", 1, &irq) && irq == ext_irq)
+            return node;
+    }
+    return -1;
+}
+
+
+/**
+ * @brief `_saia_hart_bits`计算`size`大小的中断文件区域中`HART`下标的位数
+ */
+static uint32_t _saia_hart_bits(size_t size){
+    // 每个中断文件占一页
+    uint64_t harts = size >> 12;
+    uint32_t bits = 0;
+    while ((1UL << bits) < harts)
+        bits++;
+    return bits;
+}
+
+
+Bool saia_init(addr_t dtb){
+    if (!fdt_check_header(dtb))
+        return False;
+
+    // 根中断域有子中断域
+    int64_t aplic = fdt_find_compatible(dtb, -1, "riscv,aplic");
+    while (aplic >= 0 && fdt_get_property(dtb, aplic, "riscv,children", NULL) == NULL)
+        aplic = fdt_find_compatible(dtb, aplic, "riscv,aplic");
+    // M模式外部中断的中断号为11
+    int64_t m_imsic = _saia_find_imsic(dtb, 11);
+    int64_t s_imsic = _saia_find_imsic(dtb, CAUSE_INTERRUPT_S_EXTERNAL_INTERRUPT);
+    if (aplic < 0 || m_imsic < 0 || s_imsic < 0)
+        return False;
+
+    addr_t base, m_file, s_file;
+    size_t size, m_size, s_size;
+    uint32_t nr_sources;
+    if (
+        !fdt_get_reg(dtb, aplic, 0, &base, &size) ||
+        !fdt_get_reg(dtb, m_imsic, 0, &m_file, &m_size) ||
+        !fdt_get_reg(dtb, s_imsic, 0, &s_file, &s_size) ||
+        !fdt_get_u32(dtb, aplic, "riscv,num-sources", 0, &nr_sources)
+    )
+        return False;
+
+    // 配置期间关闭根中断域
+    write_32_bits(base + APLIC_DOMAINCFG, 0);
+
+    // MSI的目标地址: 中断文件基地址 + HART下标 * 4096. LHXW由M模式和S模式共用
+    uint32_t lhxw = _saia_hart_bits(s_size > m_size ? s_size : m_size);
+    write_32_bits(base + APLIC_MMSIADDRCFG, (uint32_t) (m_file >> 12));
+    write_32_bits(base + APLIC_MMSIADDRCFGH, (lhxw << APLIC_MSIADDRCFGH_LHXW_SHIFT) | (uint32_t) (m_file >> 44));
+    write_32_bits(base + APLIC_SMSIADDRCFG, (uint32_t) (s_file >> 12));
+    write_32_bits(base + APLIC_SMSIADDRCFGH, (uint32_t) (s_file >> 44));
+
+    // 所有中断源委托给第0个子中断域, 即S模式的中断域
+    for (uint32_t src = 1; src <= nr_sources; src++)
+        write_32_bits(aplic_sourcecfg_addr(base, src), APLIC_SOURCECFG_D | 0);
+
+    write_32_bits(base + APLIC_DOMAINCFG, APLIC_DOMAINCFG_IE | APLIC_DOMAINCFG_DM);
+    bprintf("\tAPLIC root domain at %#lx, %u sources delegated to S-mode, IMSIC S-files at %#lx\n", base, nr_sources, s_file);
+    return True;
+}
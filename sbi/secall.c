@@ -11,49 +11,260 @@
 #include "sbi/stimer.h"
 #include "sbi/sstdio.h"
 #include "sbi/secall.h"
+#include "sbi/shart.h"
+#include "sbi/sipi.h"
+#include "sbi/strap.h"
+#include "sbi/sreset.h"
+#include "device/ddr.h"
 
 
-void secall_init(void){
-    regitser_strap_handler(CAUSE_EXCEPTION_SUPERVISOR_ECALL, False, NULL, sup_ecall_handler);
+/**
+ * @brief `_secall_settimer`设置当前`HART`的下一次时钟中断
+ */
+static ireg_t _secall_settimer(ireg_t arg0, ireg_t arg1 UNUSED, ireg_t arg2 UNUSED){
+    clint_timer_event_start(arg0);
+    return 0;
 }
 
-int64_t sup_ecall_handler(strapframe_t *stf_ptr){
-    // ecall id 保存在 a7 寄存器中
-    ireg_t arg0 UNUSED = stf_ptr->gregisters.a0;
-    ireg_t arg1 UNUSED = stf_ptr->gregisters.a1;
-    ireg_t arg2 UNUSED = stf_ptr->gregisters.a2;
-    ireg_t ecall_id = stf_ptr->gregisters.a7;
+/**
+ * @brief `_secall_putchar`输出一个字符
+ */
+static ireg_t _secall_putchar(ireg_t arg0, ireg_t arg1 UNUSED, ireg_t arg2 UNUSED){
+    bprintf("%c", (char)arg0);
+    return 0;
+}
 
-    int64_t ret = -1;
-    switch (ecall_id) {
-        case SBICALL_SETTIMER:
-            // bprintf("ecall for mtimecmp happened!\n");
-            clint_timer_event_start(stf_ptr->gregisters.a0);
-            ret = 0;
-            break;
-        case SBICALL_CONSOLE_PUTCHAR:
-            bprintf("%c", (char)arg0);
-            ret = 0;
-            break;
-        case SBICALL_CONSOLE_PUTSTR:
-            bprintf("%s", (char*)arg0);
-            ret = 0;
-            break;
-        case SBICALL_CONSOLE_GETCHAR:
-            // RISC-V ABI中a0寄存器用于保存函数返回值
-            stf_ptr->gregisters.a0 = uart_get();
-            ret = 0;
+/**
+ * @brief `_secall_putstr`输出一个字符串
+ */
+static ireg_t _secall_putstr(ireg_t arg0, ireg_t arg1 UNUSED, ireg_t arg2 UNUSED){
+    bprintf("%s", (char*)arg0);
+    return 0;
+}
+
+/**
+ * @brief `_secall_getchar`获取一个字符
+ */
+static ireg_t _secall_getchar(ireg_t arg0 UNUSED, ireg_t arg1 UNUSED, ireg_t arg2 UNUSED){
+    return uart_get();
+}
+
+/**
+ * @brief `_secall_hart_start`启动一个`HART`
+ */
+static ireg_t _secall_hart_start(ireg_t arg0, ireg_t arg1, ireg_t arg2){
+    return shart_start(arg0, arg1, arg2);
+}
+
+
+// 传统调用的调用号是连续的, 全部放入快速路径的调用表
+_Static_assert(SBICALL_HART_START < SECALL_FAST_NUM, "SECALL_FAST_NUM too small for legacy SBI calls");
+// strap_entry.S的快速路径按照下标取出TIME和DBCN扩展使用的处理函数
+_Static_assert(SBICALL_SETTIMER == 0 && SBICALL_CONSOLE_PUTCHAR == 1, "strap_entry.S fast path expects SETTIMER at 0 and CONSOLE_PUTCHAR at 1");
+
+secall_fast_handler_t secall_fast_table[SECALL_FAST_NUM] = {
+    [SBICALL_SETTIMER]          = _secall_settimer,
+    [SBICALL_CONSOLE_PUTCHAR]   = _secall_putchar,
+    [SBICALL_CONSOLE_PUTSTR]    = _secall_putstr,
+    [SBICALL_CONSOLE_GETCHAR]   = _secall_getchar,
+    [SBICALL_HART_START]        = _secall_hart_start,
+};
+
+
+/**
+ * @brief `secall_ext_t`是一个`SBI`标准扩展或者厂商扩展, `handler`根据功能号`fid`处理调用, 参数从陷入帧中的`a0~a5`读取
+ */
+typedef struct __secall_ext_t {
+    /// @brief 扩展号
+    uint64_t eid;
+    /// @brief 扩展的处理函数
+    sbiret_t (*handler)(ireg_t fid, strapframe_t *stf_ptr);
+} secall_ext_t;
+
+static sbiret_t _secall_ext_base(ireg_t fid, strapframe_t *stf_ptr);
+
+
+/**
+ * @brief `_secall_ext_time`是`TIME`扩展的处理函数, 通常在快速路径中处理
+ */
+static sbiret_t _secall_ext_time(ireg_t fid, strapframe_t *stf_ptr){
+    if (fid != 0)
+        return (sbiret_t){SBI_ERR_NOT_SUPPORTED, 0};
+    clint_timer_event_start(stf_ptr->gregisters.a0);
+    return (sbiret_t){SBI_SUCCESS, 0};
+}
+
+/**
+ * @brief `_secall_ext_ipi`是`IPI`扩展的处理函数
+ */
+static sbiret_t _secall_ext_ipi(ireg_t fid, strapframe_t *stf_ptr){
+    if (fid != 0)
+        return (sbiret_t){SBI_ERR_NOT_SUPPORTED, 0};
+    return (sbiret_t){sipi_send_ipi(stf_ptr->gregisters.a0, stf_ptr->gregisters.a1), 0};
+}
+
+/**
+ * @brief `_secall_ext_rfence`是`RFENCE`扩展的处理函数
+ */
+static sbiret_t _secall_ext_rfence(ireg_t fid, strapframe_t *stf_ptr){
+    gtrapframe_t *r = &stf_ptr->gregisters;
+    return (sbiret_t){sipi_remote_fence(fid, r->a0, r->a1, r->a2, r->a3, r->a4), 0};
+}
+
+/**
+ * @brief `_secall_ext_hsm`是`HSM`扩展的处理函数
+ */
+static sbiret_t _secall_ext_hsm(ireg_t fid, strapframe_t *stf_ptr){
+    gtrapframe_t *r = &stf_ptr->gregisters;
+    int64_t status = 0;
+    switch (fid){
+        case SBI_HSM_HART_START:
+            return (sbiret_t){shart_start(r->a0, r->a1, r->a2), 0};
+        case SBI_HSM_HART_STOP:
+            // shart_stop不会返回, 被重新启动的HART从start_addr开始运行
+            shart_stop();
             break;
+        case SBI_HSM_HART_GET_STATUS:
+            return (sbiret_t){shart_get_status(r->a0, &status), status};
+        case SBI_HSM_HART_SUSPEND:
+            return (sbiret_t){shart_suspend(r->a0), 0};
+        default:
+            return (sbiret_t){SBI_ERR_NOT_SUPPORTED, 0};
+    }
+}
+
+/**
+ * @brief `_secall_ext_srst`是`SRST`扩展的处理函数
+ */
+static sbiret_t _secall_ext_srst(ireg_t fid, strapframe_t *stf_ptr){
+    if (fid != 0)
+        return (sbiret_t){SBI_ERR_NOT_SUPPORTED, 0};
+    return (sbiret_t){sreset_system_reset(stf_ptr->gregisters.a0, stf_ptr->gregisters.a1), 0};
+}
+
+/**
+ * @brief `_secall_dbcn_range_ok`检查`DBCN`扩展传入的物理地址范围是否可以被S模式访问
+ * 
+ * @param base 起始物理地址的低64位
+ * @param base_hi 起始物理地址的高64位
+ * @param num_bytes 字节数
+ * @return Bool `[base, base + num_bytes)`位于内核可用的`DDR`内存中时返回True
+ * 
+ * @note `SBI`自身所在的`[DDR_BASE_ADDR, KERNEL_JUMP_ADDR)`不属于S模式, 否则内核可以通过`console_read`改写`SBI`的内存
+ */
+static Bool _secall_dbcn_range_ok(ireg_t base, ireg_t base_hi, ireg_t num_bytes){
+    return base_hi == 0 && base >= KERNEL_JUMP_ADDR && base < DDR_END_ADDR && num_bytes <= DDR_END_ADDR - base;
+}
+
+/**
+ * @brief `_secall_ext_dbcn`是`DBCN`扩展的处理函数
+ * 
+ * @note `M模式`下没有开启地址翻译, 可以直接访问内核传入的物理地址. `RV64`上物理地址只有低64位, 高64位(`a2`)必须为0
+ * @note 地址范围不在S模式的内存中时返回`SBI_ERR_INVALID_PARAM`, 而不是在`M模式`下访问非法地址
+ */
+static sbiret_t _secall_ext_dbcn(ireg_t fid, strapframe_t *stf_ptr){
+    gtrapframe_t *r = &stf_ptr->gregisters;
+    switch (fid){
+        case SBI_DBCN_CONSOLE_WRITE:
+            if (!_secall_dbcn_range_ok(r->a1, r->a2, r->a0))
+                return (sbiret_t){SBI_ERR_INVALID_PARAM, 0};
+            for (size_t i = 0; i < r->a0; i++)
+                uart_put(((const char *)r->a1)[i]);
+            return (sbiret_t){SBI_SUCCESS, r->a0};
+        case SBI_DBCN_CONSOLE_READ:
+            if (!_secall_dbcn_range_ok(r->a1, r->a2, r->a0))
+                return (sbiret_t){SBI_ERR_INVALID_PARAM, 0};
+            return (sbiret_t){SBI_SUCCESS, uart_rx_drain((char *)r->a1, r->a0)};
+        case SBI_DBCN_CONSOLE_WRITE_BYTE:
+            uart_put((char)r->a0);
+            return (sbiret_t){SBI_SUCCESS, 0};
+        default:
+            return (sbiret_t){SBI_ERR_NOT_SUPPORTED, 0};
+    }
+}
+
+/**
+ * @brief `_secall_ext_x2w`是`X2W-OS`厂商扩展的处理函数
+ */
+static sbiret_t _secall_ext_x2w(ireg_t fid, strapframe_t *stf_ptr UNUSED){
+    if (fid != SBI_X2W_TRAPSTAT_DUMP)
+        return (sbiret_t){SBI_ERR_NOT_SUPPORTED, 0};
+    strap_stat_dump();
+    return (sbiret_t){SBI_SUCCESS, 0};
+}
+
+
+// 支持的扩展, 同时用于Base扩展的probe_extension
+static const secall_ext_t secall_exts[] = {
+    {SBI_EXT_BASE,      _secall_ext_base},
+    {SBI_EXT_TIME,      _secall_ext_time},
+    {SBI_EXT_IPI,       _secall_ext_ipi},
+    {SBI_EXT_RFENCE,    _secall_ext_rfence},
+    {SBI_EXT_HSM,       _secall_ext_hsm},
+    {SBI_EXT_SRST,      _secall_ext_srst},
+    {SBI_EXT_DBCN,      _secall_ext_dbcn},
+    {SBI_EXT_X2W,       _secall_ext_x2w},
+};
+
+
+/**
+ * @brief `_secall_find_ext`查找扩展号为`eid`的扩展, 不支持时返回NULL
+ */
+static const secall_ext_t *_secall_find_ext(ireg_t eid){
+    for (size_t i = 0; i < sizeof(secall_exts) / sizeof(secall_exts[0]); i++)
+        if (secall_exts[i].eid == eid)
+            return &secall_exts[i];
+    return NULL;
+}
+
+/**
+ * @brief `_secall_ext_base`是`Base`扩展的处理函数
+ */
+static sbiret_t _secall_ext_base(ireg_t fid, strapframe_t *stf_ptr){
+    switch (fid){
+        case SBI_BASE_GET_SPEC_VERSION:
+            return (sbiret_t){SBI_SUCCESS, SBI_SPEC_VERSION};
+        case SBI_BASE_GET_IMPL_ID:
+            return (sbiret_t){SBI_SUCCESS, SBI_IMPL_ID_X2W};
+        case SBI_BASE_GET_IMPL_VERSION:
+            return (sbiret_t){SBI_SUCCESS, SBI_IMPL_VERSION};
+        case SBI_BASE_PROBE_EXT:
+            return (sbiret_t){SBI_SUCCESS, _secall_find_ext(stf_ptr->gregisters.a0) != NULL};
+        case SBI_BASE_GET_MVENDORID:
+            return (sbiret_t){SBI_SUCCESS, read_csr(mvendorid)};
+        case SBI_BASE_GET_MARCHID:
+            return (sbiret_t){SBI_SUCCESS, read_csr(marchid)};
+        case SBI_BASE_GET_MIMPID:
+            return (sbiret_t){SBI_SUCCESS, read_csr(mimpid)};
         default:
-            bprintf("Ecall Error: Non-supported ecall ID: %#X!\n", ecall_id);
-            bprintf("Add Support for Ecall with ID: %#X to remove haning!\n", ecall_id);
-            bprintf("Hanging HART Here\n");
-            while(1);
+            return (sbiret_t){SBI_ERR_NOT_SUPPORTED, 0};
     }
+}
+
+
+void secall_init(void){
+    regitser_strap_handler(CAUSE_EXCEPTION_SUPERVISOR_ECALL, False, NULL, sup_ecall_handler);
+}
+
+int64_t sup_ecall_handler(strapframe_t *stf_ptr){
+    // 传统调用的调用号和标准扩展的扩展号都保存在 a7 寄存器中, 标准扩展的功能号保存在 a6 寄存器中
+    ireg_t ecall_id = stf_ptr->gregisters.a7;
+    ireg_t fid = stf_ptr->gregisters.a6;
 
     // ecall 为异常, 因此返回时候需要把pc的值 +4, 即指向ecall的下一条指令
-    if (ret == 0)
-        stf_ptr->mepc += 4;
+    stf_ptr->mepc += 4;
+
+    // 传统调用只修改 a0 寄存器. 调用表中的调用通常在快速路径中处理, 经过完整路径时同样查表处理
+    if (ecall_id < SECALL_FAST_NUM && secall_fast_table[ecall_id] != NULL){
+        gtrapframe_t *r = &stf_ptr->gregisters;
+        r->a0 = secall_fast_table[ecall_id](r->a0, r->a1, r->a2);
+        return 0;
+    }
 
-    return ret;
+    // 标准扩展的错误码保存在 a0 寄存器中, 返回值保存在 a1 寄存器中. 不支持的调用返回错误码, 而不是挂起HART
+    const secall_ext_t *ext = _secall_find_ext(ecall_id);
+    sbiret_t ret = ext != NULL ? ext->handler(fid, stf_ptr) : (sbiret_t){SBI_ERR_NOT_SUPPORTED, 0};
+    stf_ptr->gregisters.a0 = ret.error;
+    stf_ptr->gregisters.a1 = ret.value;
+    return 0;
 }
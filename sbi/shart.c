@@ -0,0 +1,130 @@
+/**
+ * @file shart.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `shart.c`是`SBI`的`HART`管理模块的实现
+ * @version 0.1
+ * @date 2023-06-10
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "io.h"
+#include "asm/csr.h"
+#include "asm/clint.h"
+#include "sbi/sbi.h"
+#include "sbi/shart.h"
+#include "sbi/sinit.h"
+#include "sbi/smain.h"
+
+// 每个HART的启动信息
+static shart_t sharts[MAX_CPU_NUM];
+
+
+void shart_scratch_init(uint64_t hartid){
+    shart_scratch_t *scratch = shart_scratch();
+    scratch->hartid = hartid;
+    scratch->mtimecmp_addr = CLINT_TIMER_MTIMECMP_ADDR(hartid);
+    scratch->next_event = (uint64_t)-1;
+    scratch->timer_events = 0;
+}
+
+
+void shart_init(void){
+    __atomic_store_n(&sharts[read_csr(mhartid)].state, SHART_STARTED, __ATOMIC_RELEASE);
+}
+
+
+Bool shart_is_started(uint64_t hartid){
+    return hartid < MAX_CPU_NUM && __atomic_load_n(&sharts[hartid].state, __ATOMIC_ACQUIRE) == SHART_STARTED;
+}
+
+
+NO_RETURN void shart_park(uint64_t hartid){
+    shart_t *hart = &sharts[hartid];
+    shart_scratch_init(hartid);
+    __atomic_store_n(&hart->state, SHART_STOPPED, __ATOMIC_RELEASE);
+
+    // 只用M模式软件中断唤醒wfi
+    write_csr(mie, MIE_M_SOFTWARE_INTERRUPT);
+    while (__atomic_load_n(&hart->state, __ATOMIC_ACQUIRE) != SHART_START_PENDING){
+        asm volatile("wfi");
+        // 先清除msip再检查状态, 清除之后的唤醒不会丢失
+        write_32_bits(CLINT_MSIP_0_ADDR + 4 * hartid, 0);
+        asm volatile("fence iorw, iorw" ::: "memory");
+    }
+
+    // 初始化当前HART的M模式寄存器, 中断/异常处理函数表等全局状态已由HART0初始化
+    sinit_hart();
+    __atomic_store_n(&hart->state, SHART_STARTED, __ATOMIC_RELEASE);
+    jump_to_kernel(hartid, hart->start_addr, hart->opaque);
+    UNREACHABLE;
+}
+
+
+int64_t shart_start(uint64_t hartid, addr_t start_addr, uint64_t opaque){
+    if (hartid >= MAX_CPU_NUM)
+        return SBI_ERR_INVALID_PARAM;
+    shart_t *hart = &sharts[hartid];
+    uint64_t state = __atomic_load_n(&hart->state, __ATOMIC_ACQUIRE);
+    if (state == SHART_ABSENT)
+        return SBI_ERR_INVALID_PARAM;
+    if (state != SHART_STOPPED)
+        return SBI_ERR_ALREADY_AVAILABLE;
+    // 启动信息需要在状态改变之前写入, 被启动的HART读取到SHART_START_PENDING后才读取启动信息
+    hart->start_addr = start_addr;
+    hart->opaque = opaque;
+    uint64_t expected = SHART_STOPPED;
+    if (!__atomic_compare_exchange_n(&hart->state, &expected, SHART_START_PENDING, False, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        return SBI_ERR_ALREADY_AVAILABLE;
+    // 状态写入内存之后再写msip唤醒HART
+    asm volatile("fence iorw, iorw" ::: "memory");
+    write_32_bits(CLINT_MSIP_0_ADDR + 4 * hartid, 1);
+    return SBI_SUCCESS;
+}
+
+
+NO_RETURN void shart_stop(void){
+    uint64_t hartid = read_csr(mhartid);
+    // 清除注入的S模式时钟中断, 重新启动后由内核重新设置时钟
+    clear_csr(mip, MIP_S_TIMER_INTERRUPT);
+    clear_csr(mie, MIE_M_TIMER_INTERRUPT);
+    // 不会再返回到陷入处理函数, 直接在M模式栈顶(shart_scratch_t之下)调用shart_park
+    register uint64_t a0 asm("a0") = hartid;
+    asm volatile(
+        "mv sp, %0\n\t"
+        "j shart_park"
+        :: "r" (shart_scratch()), "r" (a0) : "memory"
+    );
+    UNREACHABLE;
+}
+
+
+int64_t shart_get_status(uint64_t hartid, int64_t *status){
+    if (hartid >= MAX_CPU_NUM)
+        return SBI_ERR_INVALID_PARAM;
+    switch (__atomic_load_n(&sharts[hartid].state, __ATOMIC_ACQUIRE)){
+        case SHART_STOPPED:
+            *status = SBI_HSM_STATE_STOPPED;
+            return SBI_SUCCESS;
+        case SHART_START_PENDING:
+            *status = SBI_HSM_STATE_START_PENDING;
+            return SBI_SUCCESS;
+        case SHART_STARTED:
+            *status = SBI_HSM_STATE_STARTED;
+            return SBI_SUCCESS;
+        default:
+            return SBI_ERR_INVALID_PARAM;
+    }
+}
+
+
+int64_t shart_suspend(uint64_t suspend_type){
+    // 0x10000000~0x7FFFFFFF和0x90000000以上是平台定义的类型, 其余非默认的类型都是保留的类型
+    if (suspend_type == SBI_HSM_SUSPEND_NON_RET_DEFAULT || (suspend_type >= 0x10000000 && suspend_type <= 0x7FFFFFFF) || suspend_type >= 0x90000000)
+        return SBI_ERR_NOT_SUPPORTED;
+    if (suspend_type != SBI_HSM_SUSPEND_RET_DEFAULT)
+        return SBI_ERR_INVALID_PARAM;
+    // mie中打开的中断到来时wfi返回, M模式的中断是关闭的, 因此不会在这里陷入, 返回内核后再处理中断
+    asm volatile("wfi");
+    return SBI_SUCCESS;
+}
@@ -12,10 +12,14 @@
 #include "sbi/strap.h"
 #include "sbi/stimer.h"
 #include "sbi/secall.h"
+#include "sbi/shart.h"
+#include "sbi/sipi.h"
+#include "sbi/saia.h"
+#include "sbi/sreset.h"
 #include "sbi/sstdio.h"
 
 
-void sinit_all(void){
+void sinit_all(addr_t dtb){
     // 初始化 SBI 异常/中断处理模块
     bprintf("=> strap_init\n");
     strap_init();
@@ -26,6 +30,30 @@ void sinit_all(void){
     delegate_traps();
     bprintf("=> delegate_traps\n");
     // 初始化 SBI Timer
-    stimer_init();
+    stimer_init(dtb);
     bprintf("=> stimer_init\n");
-}
\ No newline at end of file
+    // 初始化 SBI 核间中断
+    sipi_init();
+    bprintf("=> sipi_init\n");
+    // 初始化 AIA 中断控制器, 使用 PLIC 时什么都不做
+    if (saia_init(dtb))
+        bprintf("=> saia_init\n");
+    // 查找 SRST 扩展使用的复位设备
+    if (sreset_init(dtb))
+        bprintf("=> sreset_init\n");
+    // 标记当前 HART 已经启动
+    shart_init();
+    bprintf("=> shart_init\n");
+}
+
+
+void sinit_hart(void){
+    // 设置当前HART的异常/中断入口
+    strap_init_hart();
+    // 委托 S模式下的中断和异常给S模式
+    delegate_traps();
+    // 打开当前 HART 的核间中断
+    sipi_init_hart();
+    // 支持 Sstc 时允许 S模式直接设置 stimecmp
+    stimer_init_hart();
+}
@@ -0,0 +1,183 @@
+/**
+ * @file sipi.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `sipi.c`是`SBI`的核间中断模块的实现
+ * @version 0.1
+ * @date 2023-06-12
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "io.h"
+#include "asm/csr.h"
+#include "asm/clint.h"
+#include "sbi/sbi.h"
+#include "sbi/sipi.h"
+#include "sbi/shart.h"
+
+// 每个HART收到的核间中断请求
+static sipi_t sipis[MAX_CPU_NUM];
+
+
+void sipi_init(void){
+    regitser_strap_handler(CAUSE_INTERRUPT_M_SOFTWARE_INTERRUPT, True, "Machine Software Interrupt", sipi_interrupt_handler);
+    sipi_init_hart();
+}
+
+
+void sipi_init_hart(void){
+    set_csr(mie, MIE_M_SOFTWARE_INTERRUPT);
+}
+
+
+/**
+ * @brief `_sipi_targets`将`hart_mask`和`hart_mask_base`转换为目标`HART`的位图
+ * 
+ * @param hart_mask `HART`的掩码
+ * @param hart_mask_base `hart_mask`的起始`HART`编号, 为-1时表示所有已经启动的`HART`
+ * @param targets 目标`HART`的位图, 第`i`位表示`HARTi`
+ * @return int64_t 有`HART`不存在或者没有启动时返回`SBI_ERR_INVALID_PARAM`
+ */
+static int64_t _sipi_targets(uint64_t hart_mask, uint64_t hart_mask_base, uint64_t *targets){
+    *targets = 0;
+    if (hart_mask_base == (uint64_t)-1){
+        for (uint64_t hartid = 0; hartid < MAX_CPU_NUM; hartid++)
+            if (shart_is_started(hartid))
+                *targets |= 1UL << hartid;
+        return SBI_SUCCESS;
+    }
+    for (uint64_t i = 0; i < 64; i++){
+        if ((hart_mask & (1UL << i)) == 0)
+            continue;
+        uint64_t hartid = hart_mask_base + i;
+        if (!shart_is_started(hartid))
+            return SBI_ERR_INVALID_PARAM;
+        *targets |= 1UL << hartid;
+    }
+    return SBI_SUCCESS;
+}
+
+
+/**
+ * @brief `_sipi_kick`写目标`HART`的`msip`寄存器以触发M模式软件中断
+ */
+static inline void _sipi_kick(uint64_t hartid){
+    // 请求写入内存之后再写msip
+    asm volatile("fence iorw, iorw" ::: "memory");
+    write_32_bits(CLINT_MSIP_0_ADDR + 4 * hartid, 1);
+}
+
+
+/**
+ * @brief `_sipi_local_fence`在当前`HART`上执行`RFENCE`请求
+ */
+static void _sipi_local_fence(uint64_t fid, addr_t start, uint64_t size, uint64_t asid){
+    if (fid == SBI_RFENCE_FENCE_I){
+        asm volatile("fence.i" ::: "memory");
+        return;
+    }
+    Bool all = (start == 0 && size == 0) || size == (uint64_t)-1 || size > TLB_FLUSH_ALL_THRESHOLD * PAGE_SIZE;
+    if (fid == SBI_RFENCE_SFENCE_VMA){
+        if (all)
+            asm volatile("sfence.vma" ::: "memory");
+        else
+            for (addr_t addr = start & ~((addr_t)PAGE_SIZE - 1); addr < start + size; addr += PAGE_SIZE)
+                asm volatile("sfence.vma %0" : : "r" (addr) : "memory");
+    } else {
+        if (all)
+            asm volatile("sfence.vma zero, %0" : : "r" (asid) : "memory");
+        else
+            for (addr_t addr = start & ~((addr_t)PAGE_SIZE - 1); addr < start + size; addr += PAGE_SIZE)
+                asm volatile("sfence.vma %0, %1" : : "r" (addr), "r" (asid) : "memory");
+    }
+}
+
+
+/**
+ * @brief `_sipi_process`处理发给`hartid`(即当前`HART`)的所有请求
+ */
+static void _sipi_process(uint64_t hartid){
+    sipi_t *ipi = &sipis[hartid];
+    // 先清除msip再读取请求, 清除之后发送的请求会再次触发中断
+    write_32_bits(CLINT_MSIP_0_ADDR + 4 * hartid, 0);
+    asm volatile("fence iorw, iorw" ::: "memory");
+    uint64_t pending = __atomic_exchange_n(&ipi->pending, 0, __ATOMIC_ACQUIRE);
+    if (pending & SIPI_SOFTWARE)
+        set_csr(mip, MIP_S_SOFTWARE_INTERRUPT);
+    if (pending & SIPI_RFENCE){
+        _sipi_local_fence(ipi->rfence_fid, ipi->rfence_start, ipi->rfence_size, ipi->rfence_asid);
+        __atomic_store_n(&ipi->rfence_owner, 0, __ATOMIC_RELEASE);
+    }
+}
+
+
+/**
+ * @brief `_sipi_poll`在M模式中等待其他`HART`时调用, 处理发给当前`HART`的请求, 避免互相等待
+ */
+static inline void _sipi_poll(uint64_t hartid){
+    if (__atomic_load_n(&sipis[hartid].pending, __ATOMIC_RELAXED) != 0)
+        _sipi_process(hartid);
+}
+
+
+int64_t sipi_send_ipi(uint64_t hart_mask, uint64_t hart_mask_base){
+    uint64_t targets;
+    int64_t ret = _sipi_targets(hart_mask, hart_mask_base, &targets);
+    if (ret != SBI_SUCCESS)
+        return ret;
+    for (uint64_t hartid = 0; hartid < MAX_CPU_NUM; hartid++){
+        if ((targets & (1UL << hartid)) == 0)
+            continue;
+        __atomic_fetch_or(&sipis[hartid].pending, SIPI_SOFTWARE, __ATOMIC_RELEASE);
+        _sipi_kick(hartid);
+    }
+    return SBI_SUCCESS;
+}
+
+
+int64_t sipi_remote_fence(uint64_t fid, uint64_t hart_mask, uint64_t hart_mask_base, addr_t start, uint64_t size, uint64_t asid){
+    if (fid > SBI_RFENCE_SFENCE_VMA_ASID)
+        return SBI_ERR_NOT_SUPPORTED;
+    uint64_t targets;
+    int64_t ret = _sipi_targets(hart_mask, hart_mask_base, &targets);
+    if (ret != SBI_SUCCESS)
+        return ret;
+
+    uint64_t self = read_csr(mhartid);
+    // 向所有目标HART发送请求, 目标HART的上一个请求还没有完成时等待
+    for (uint64_t hartid = 0; hartid < MAX_CPU_NUM; hartid++){
+        if ((targets & (1UL << hartid)) == 0 || hartid == self)
+            continue;
+        sipi_t *ipi = &sipis[hartid];
+        uint64_t expected = 0;
+        while (!__atomic_compare_exchange_n(&ipi->rfence_owner, &expected, self + 1, False, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)){
+            expected = 0;
+            _sipi_poll(self);
+        }
+        ipi->rfence_fid = fid;
+        ipi->rfence_start = start;
+        ipi->rfence_size = size;
+        ipi->rfence_asid = asid;
+        __atomic_fetch_or(&ipi->pending, SIPI_RFENCE, __ATOMIC_RELEASE);
+        _sipi_kick(hartid);
+    }
+
+    // 在其他HART执行的同时执行本地的请求
+    if (targets & (1UL << self))
+        _sipi_local_fence(fid, start, size, asid);
+
+    // 等待所有目标HART完成
+    for (uint64_t hartid = 0; hartid < MAX_CPU_NUM; hartid++){
+        if ((targets & (1UL << hartid)) == 0 || hartid == self)
+            continue;
+        while (__atomic_load_n(&sipis[hartid].rfence_owner, __ATOMIC_ACQUIRE) == self + 1)
+            _sipi_poll(self);
+    }
+    return SBI_SUCCESS;
+}
+
+
+int64_t sipi_interrupt_handler(strapframe_t *stf_ptr){
+    _sipi_process(read_csr(mhartid));
+    return 0;
+}
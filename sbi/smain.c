@@ -11,13 +11,16 @@
 #include "types.h"
 #include "constrains.h"
 #include "asm/csr.h"
+#include "sbi/shart.h"
 #include "sbi/sinit.h"
 #include "sbi/smain.h"
 #include "sbi/sstdio.h"
 #include "device/uart.h"
 
 
-NO_RETURN void sbi_main(void){
+NO_RETURN void sbi_main(uint64_t hartid, addr_t dtb){
+    // 初始化当前 HART 的私有数据
+    shart_scratch_init(hartid);
     // 初始化 UART 设备
     uart_init();
     // 输出 SBI Banner
@@ -27,16 +30,16 @@ NO_RETURN void sbi_main(void){
     bprintf("Enter SBI!\n");
     // 初始化 SBI 其余各个组件
     bprintf("SBI init!\n");
-    sinit_all();
+    sinit_all(dtb);
     // 跳转至内核
     bprintf("Jump to kernel!\n");
-    jump_to_kernel();
+    jump_to_kernel(hartid, KERNEL_JUMP_ADDR, dtb);
     UNREACHABLE;
 }
 
 
 
-NO_RETURN void jump_to_kernel(){
+NO_RETURN void jump_to_kernel(uint64_t hartid, addr_t start_addr, uint64_t opaque){
     // 设置中断前模式
     uint64_t mval;
     mval = read_csr(mstatus);
@@ -45,9 +48,9 @@ NO_RETURN void jump_to_kernel(){
     write_csr(mstatus, mval);
 
     // 设置M模式的EPC(Exception Program Counter)寄存器, 用于mret跳转
-    write_csr(mepc, KERNEL_JUMP_ADDR);
+    write_csr(mepc, start_addr);
     // 设置S模式的异常向量表入口
-    write_csr(stvec, KERNEL_JUMP_ADDR);
+    write_csr(stvec, start_addr);
     // 关闭S模式的中断
     write_csr(sie, 0);
     // 关闭S模式的页表转换
@@ -57,7 +60,9 @@ NO_RETURN void jump_to_kernel(){
     write_csr(pmpaddr0, (ireg_t)0x3FFFFFFFFFFFFF);
     write_csr(pmpcfg0, 0xF);
 
-    // 伪装中断返回, 返回到S模式
-    asm volatile("mret");
+    // 伪装中断返回, 返回到S模式, a0为HART的编号, a1为参数
+    register ireg_t a0 asm ("a0") = (ireg_t)hartid;
+    register ireg_t a1 asm ("a1") = (ireg_t)opaque;
+    asm volatile("mret" : : "r" (a0), "r" (a1));
     UNREACHABLE;
 }
@@ -0,0 +1,61 @@
+/**
+ * @file sreset.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `sreset.c`是`SBI`的系统复位模块的实现
+ * @version 0.1
+ * @date 2023-06-18
+ * 
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "io.h"
+#include "fdt.h"
+#include "sbi/sbi.h"
+#include "sbi/sreset.h"
+#include "sbi/sstdio.h"
+
+// test finisher的命令
+#define SRESET_FINISHER_FAIL    0x3333
+#define SRESET_FINISHER_PASS    0x5555
+#define SRESET_FINISHER_RESET   0x7777
+
+// test finisher的地址, 为0时表示没有复位设备
+static addr_t sreset_finisher = 0;
+
+
+Bool sreset_init(addr_t dtb){
+    if (!fdt_check_header(dtb))
+        return False;
+    int64_t node = fdt_find_compatible(dtb, -1, "sifive,test0");
+    size_t size;
+    if (node < 0 || !fdt_get_reg(dtb, node, 0, &sreset_finisher, &size)){
+        sreset_finisher = 0;
+        return False;
+    }
+    bprintf("\ttest finisher at: %#lx\n", sreset_finisher);
+    return True;
+}
+
+
+int64_t sreset_system_reset(uint64_t reset_type, uint64_t reset_reason){
+    // 0xF0000000以上是厂商定义的类型, 其余的是保留的类型
+    if (reset_type > SBI_SRST_WARM_REBOOT)
+        return reset_type >= 0xF0000000 ? SBI_ERR_NOT_SUPPORTED : SBI_ERR_INVALID_PARAM;
+    // 0xE0000000以上是平台和厂商定义的原因, 其余的是保留的原因
+    if (reset_reason > SBI_SRST_REASON_SYSTEM_FAILURE && reset_reason < 0xE0000000)
+        return SBI_ERR_INVALID_PARAM;
+    if (sreset_finisher == 0)
+        return SBI_ERR_NOT_SUPPORTED;
+
+    uint32_t cmd;
+    if (reset_type == SBI_SRST_SHUTDOWN)
+        cmd = reset_reason == SBI_SRST_REASON_NONE ? SRESET_FINISHER_PASS : (SRESET_FINISHER_FAIL | (1 << 16));
+    else
+        // test finisher没有区分冷重启和热重启
+        cmd = SRESET_FINISHER_RESET;
+    bprintf("SBI: system reset, type %lu, reason %#lx\n", reset_type, reset_reason);
+    write_32_bits(sreset_finisher, cmd);
+    while (1)
+        asm volatile("wfi");
+    UNREACHABLE;
+}
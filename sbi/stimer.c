@@ -9,19 +9,42 @@
  */
 
 #include "io.h"
+#include "fdt.h"
 #include "asm/csr.h"
 #include "asm/clint.h"
+#include "sbi/shart.h"
 #include "sbi/strap.h"
 #include "sbi/stimer.h"
 #include "sbi/sstdio.h"
 
 
-void stimer_init(void){
+// 所有HART是否都支持Sstc扩展
+static Bool stimer_sstc = False;
+
+
+void stimer_init(addr_t dtb){
     regitser_strap_handler(CAUSE_INTERRUPT_M_TIMER_INTERRUPT, True, "Machine Timer Interrupt", stimer_interrupt_handler);
+    stimer_sstc = fdt_isa_has_extension(dtb, "sstc");
+    if (stimer_sstc)
+        bprintf("\tSstc supported, S-mode programs stimecmp directly\n");
+    stimer_init_hart();
+}
+
+
+void stimer_init_hart(void){
+    // 内核使用cycle统计锁的等待和持有时间
+    set_csr(mcounteren, MCOUNTEREN_CY);
+    if (!stimer_sstc)
+        return;
+    // 在内核设置之前不产生S模式的时钟中断
+    write_csr_num(CSR_STIMECMP, -1UL);
+    set_csr_num(CSR_MENVCFG, MENVCFG_STCE);
+    set_csr(mcounteren, MCOUNTEREN_TM);
 }
 
 int64_t stimer_interrupt_handler(strapframe_t *stf_ptr){
     // bprintf("Machine Timer Interrupt Happened!\n");
+    shart_scratch()->timer_events++;
     // 禁止M模式下的时钟中断, 而后开启S模式下的timer pending中断, 即中断注入, 相当于手动触发S模式的时钟中断
     clear_csr(mie, MIE_M_TIMER_INTERRUPT);
     set_csr(mip, MIP_S_TIMER_INTERRUPT);
@@ -30,7 +53,14 @@ int64_t stimer_interrupt_handler(strapframe_t *stf_ptr){
 
 
 void clint_timer_event_start(uint64_t next_ticks){
-    write_64_bits(CLINT_TIMER_MTIMECMP_0_ADDR, next_ticks);
+    // 每个HART都有自己的mtimecmp寄存器
+    shart_scratch_t *scratch = shart_scratch();
+    scratch->next_event = next_ticks;
+    if (stimer_sstc){
+        write_csr_num(CSR_STIMECMP, next_ticks);
+        return;
+    }
+    write_64_bits(scratch->mtimecmp_addr, next_ticks);
     // 清除S模式下的timer pending终端, 而后打开M模式下的时钟中断
     clear_csr(mip, MIP_S_TIMER_INTERRUPT);
     set_csr(mie, MIE_M_TIMER_INTERRUPT);
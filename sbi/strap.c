@@ -14,6 +14,7 @@
 #include "sbi/stimer.h"
 #include "sbi/sstdio.h"
 #include "device/uart.h"
+#include "trap/trapstat.h"
 
 // 中断的提示信息
 const char *sintr_msg[MAX_INTR_EXCP_INFO_NUM] = {
@@ -57,11 +58,11 @@ strap_handler_t intr_handlers[MAX_INTR_EXCP_INFO_NUM];
 // 异常处理函数表
 strap_handler_t excp_handlers[MAX_INTR_EXCP_INFO_NUM];
 
+// 陷入统计, 时间为mcycle的时钟周期. M模式下处理陷入时中断是关闭的, 可以直接记录
+static trapstat_table_t strap_stat;
+
 void strap_init(void){
-    // 设置中断向量地址, 设置为直接模式
-    write_csr(mtvec, ((addr_t)strap_enter & (~((addr_t)TVEC_TRAP_DIRECT))));
-    // 关闭所有的中断
-    write_csr(mie, 0);
+    strap_init_hart();
     // 为所有的异常和中断注册处理函数
     for (size_t i = 0; i < MAX_INTR_EXCP_INFO_NUM; i++)
         regitser_strap_handler(i, False, NULL, general_strap_handler);
@@ -72,6 +73,14 @@ void strap_init(void){
 }
 
 
+void strap_init_hart(void){
+    // 设置中断向量地址, 设置为直接模式
+    write_csr(mtvec, ((addr_t)strap_enter & (~((addr_t)TVEC_TRAP_DIRECT))));
+    // 关闭所有的中断
+    write_csr(mie, 0);
+}
+
+
 void delegate_traps(void){
     // 将S模式下的发生的:
     //      1. 软件中断
@@ -113,7 +122,19 @@ void strap_dispatcher(strapframe_t *stf_ptr){
 
     Bool is_interrupt = ((mcause & CAUSE_INTERRUPT_FLAG) != 0) ? 1 : 0;
     uint64_t trap_code = mcause & ~(CAUSE_INTERRUPT_FLAG);
+    uint64_t start = read_csr(mcycle);
     int64_t rtval UNUSED = (is_interrupt ? intr_handlers : excp_handlers)[trap_code](stf_ptr);
+    trapstat_record(&strap_stat, read_csr(mhartid), is_interrupt, trap_code, read_csr(mcycle) - start);
+}
+
+
+void strap_fast_stat(uint64_t start){
+    trapstat_record(&strap_stat, read_csr(mhartid), False, CAUSE_EXCEPTION_SUPERVISOR_ECALL, read_csr(mcycle) - start);
+}
+
+
+void strap_stat_dump(void){
+    trapstat_dump(&strap_stat, sintr_msg, sexcp_msg, "mcycle", bprintf);
 }
 
 
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+ktrace_decode.py 用于解码内核`ktrace_dump`输出的跟踪事件
+
+内核跟踪点只记录格式字符串的地址和参数, 本脚本根据内核ELF文件(build/os.elf)中的.rodata段读取格式字符串, 并在主机上完成格式化
+
+用法:
+    python3 scripts/ktrace_decode.py build/os.elf console.log
+    make run | tee console.log      # 在内核控制台中按下Ctrl+T输出跟踪缓冲区
+
+Author: Shihong Wang (jack4shihong@gmail.com)
+Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+"""
+
+import re
+import sys
+import struct
+import argparse
+
+
+class ELFImage:
+    """ELFImage 读取ELF64小端文件中所有已分配的段, 并支持按照虚拟地址读取字符串"""
+
+    SHT_NOBITS = 8
+    SHF_ALLOC = 0x2
+
+    def __init__(self, path: str):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 2 or self.data[5] != 1:
+            raise ValueError(f"{path} is not a little-endian ELF64 file")
+        # ELF头中节区头表的偏移, 表项大小和数量
+        e_shoff, = struct.unpack_from("<Q", self.data, 0x28)
+        e_shentsize, e_shnum = struct.unpack_from("<HH", self.data, 0x3A)
+        self.sections = []
+        for i in range(e_shnum):
+            _, sh_type, sh_flags, sh_addr, sh_offset, sh_size = struct.unpack_from(
+                "<IIQQQQ", self.data, e_shoff + i * e_shentsize)
+            if sh_flags & self.SHF_ALLOC and sh_type != self.SHT_NOBITS:
+                self.sections.append((sh_addr, sh_offset, sh_size))
+
+    def read_string(self, addr: int) -> str:
+        for sh_addr, sh_offset, sh_size in self.sections:
+            if sh_addr <= addr < sh_addr + sh_size:
+                start = sh_offset + addr - sh_addr
+                end = self.data.index(b"\x00", start, sh_offset + sh_size)
+                return self.data[start:end].decode("utf-8", errors="replace")
+        raise KeyError(addr)
+
+
+# 与stdfmt.c一致的格式控制字符: %[flag][width][precision][length]<type>
+FORMAT_SPEC = re.compile(r"%([-+ #0]*)(\d+)?(?:\.(\d+))?(hh|h|ll|l)?([%cspbodiuxXn])")
+
+
+def to_signed(value: int, length: str) -> int:
+    bits = 64 if length in ("l", "ll") else 16 if length == "h" else 8 if length == "hh" else 32
+    value &= (1 << bits) - 1
+    return value - (1 << bits) if value >> (bits - 1) else value
+
+
+def render(elf: ELFImage, fmt: str, args: list) -> str:
+    args = iter(args)
+
+    def convert(m: re.Match) -> str:
+        flags, width, precision, length, conv = m.groups()
+        if conv == "%":
+            return "%"
+        value = next(args, 0)
+        if conv == "s":
+            try:
+                text = elf.read_string(value)
+            except (KeyError, ValueError):
+                text = f"<str@{value:#x}>"
+            return ("%" + flags + (width or "") + "s") % text
+        if conv == "c":
+            return chr(value & 0xFF)
+        if conv == "n":
+            return ""
+        if conv in "di":
+            value = to_signed(value, length or "")
+            spec = "d"
+        elif conv == "u":
+            spec = "d"
+        elif conv == "b":
+            text = bin(value)[2:]
+            if precision:
+                text = text.zfill(int(precision))
+            if "#" in flags:
+                text = "0b" + text
+            return text.rjust(int(width or 0), "0" if "0" in flags else " ")
+        elif conv == "p":
+            return "%#x" % value
+        else:
+            spec = conv
+        py = "%" + flags + (width or "") + ("." + precision if precision else "") + spec
+        return py % value
+
+    return FORMAT_SPEC.sub(convert, fmt)
+
+
+def decode(elf: ELFImage, lines, out=sys.stdout):
+    freq = None
+    events = []
+    for line in lines:
+        line = line.strip()
+        if line.startswith("KTRACE BEGIN"):
+            freq = int(line.split()[2], 16)
+            events = []
+        elif line.startswith("KT ") and freq is not None:
+            fields = [int(x, 16) for x in line.split()[1:]]
+            if len(fields) == 8:
+                events.append(fields)
+        elif line.startswith("KTRACE END") and freq is not None:
+            # 按照时间顺序合并所有CPU的事件
+            for cpu, seq, ts, fmt_addr, *args in sorted(events, key=lambda e: e[2]):
+                try:
+                    text = render(elf, elf.read_string(fmt_addr), args)
+                except (KeyError, ValueError):
+                    text = f"<unknown format {fmt_addr:#x}> " + " ".join(f"{a:#x}" for a in args)
+                print(f"[{ts // freq:5d}.{(ts % freq) * 1000000 // freq:06d}] cpu{cpu} #{seq}: {text}", file=out)
+            freq = None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode X2W-OS binary trace events")
+    parser.add_argument("elf", help="kernel ELF with symbols, e.g. build/os.elf")
+    parser.add_argument("log", nargs="?", help="console log containing ktrace_dump output, default stdin")
+    args = parser.parse_args()
+
+    elf = ELFImage(args.elf)
+    if args.log:
+        with open(args.log, "r", errors="replace") as f:
+            decode(elf, f)
+    else:
+        decode(elf, sys.stdin)
+
+
+if __name__ == "__main__":
+    main()
@@ -15,6 +15,9 @@
 #include "test/test_string.h"
 #include "test/test_kstdio.h"
 #include "test/test_strap.h"
+#include "test/test_locks.h"
+#include "test/test_rcu.h"
+#include "test/test_kcounter.h"
 
 /// @brief 测试函数结构体
 struct {
@@ -44,6 +47,9 @@ void test_all(void){
     register_test_func(test_stdfmt);
     register_test_func(test_string);
     register_test_func(test_kstdio);
+    register_test_func(test_locks);
+    register_test_func(test_rcu);
+    register_test_func(test_kcounter);
     // register_test_func(test_exception);
 
 
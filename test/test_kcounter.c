@@ -0,0 +1,45 @@
+/**
+ * @file test_kcounter.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `test_kcounter.c`是`kcounter`的测试文件
+ * @version 0.1
+ * @date 2023-06-21
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "kernel/kstdio.h"
+#include "test/test_kcounter.h"
+
+// 声明外部符号, 避免include
+extern void uart_puts(const char*);
+
+
+int test_kcounter(void){
+    uart_puts("=> "), uart_puts(__func__), uart_puts(": \n");
+
+    kcounter_t counter = KCOUNTER_INIT("test counter");
+    for (uint64_t cpu = 0; cpu < MAX_CPU_NUM; cpu++)
+        atomic64_set(&counter.slots[cpu].value, 0);
+
+    // 只修改当前CPU的计数值
+    kcounter_inc(&counter);
+    kcounter_add(&counter, 9);
+    kprintf("\ttest local cpu: %ld (expect 10)\n", kcounter_read_cpu(&counter, cpu_id()));
+
+    // 读取时将所有CPU的计数值相加, 模拟其他CPU的计数
+    int64_t expect = 10;
+    for (uint64_t cpu = 0; cpu < MAX_CPU_NUM; cpu++){
+        if (cpu == cpu_id())
+            continue;
+        atomic64_set(&counter.slots[cpu].value, (int64_t) cpu + 100);
+        expect += (int64_t) cpu + 100;
+    }
+    kprintf("\ttest sum: %ld (expect %ld)\n", kcounter_read(&counter), expect);
+
+    // 计数值可以为负数
+    kcounter_add(&counter, -20);
+    kprintf("\ttest negative: local=%ld, sum=%ld (expect -10, %ld)\n", kcounter_read_cpu(&counter, cpu_id()), kcounter_read(&counter), expect - 20);
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file test_locks.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `test_locks.c`是`locks`的测试文件
+ * @version 0.1
+ * @date 2023-06-07
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "asm/csr.h"
+#include "kernel/ktrap.h"
+#include "kernel/kstdio.h"
+#include "test/test_locks.h"
+
+// 声明外部符号, 避免include
+extern void uart_puts(const char*);
+
+
+static inline Bool _sie(void){
+    return (read_csr(sstatus) & SSTATUS_SIE) != 0;
+}
+
+
+int test_locks(void){
+    uart_puts("=> "), uart_puts(__func__), uart_puts(": \n");
+    Bool before = supervisor_interrupt_save();
+    supervisor_interrupt_enable();
+
+    spinlock_t a, b;
+    spinlock_init(&a, "test lock a");
+    spinlock_init(&b, "test lock b");
+
+    // 嵌套获取锁, 只有释放最外层的锁后才恢复中断
+    spinlock_acquire(&a);
+    spinlock_acquire(&b);
+    kprintf("\ttest nested acquire: holding=%d, SIE=%d\n", spinlock_holding(&b), _sie());
+    spinlock_release(&b);
+    kprintf("\ttest release inner lock: SIE=%d (expect 0)\n", _sie());
+    spinlock_release(&a);
+    kprintf("\ttest release outer lock: SIE=%d (expect 1), holding=%d\n", _sie(), spinlock_holding(&a));
+
+    // irqsave在中断关闭时获取锁, 释放后中断仍然是关闭的
+    supervisor_interrupt_disable();
+    Bool enabled = spinlock_acquire_irqsave(&a);
+    spinlock_release_irqrestore(&a, enabled);
+    kprintf("\ttest irqsave with interrupt disabled: SIE=%d (expect 0)\n", _sie());
+    supervisor_interrupt_enable();
+
+    // 排号锁按照顺序叫号
+    for (int i = 0; i < 3; i++){
+        spinlock_acquire(&a);
+        spinlock_release(&a);
+    }
+    kprintf("\ttest ticket: next=%ld, owner=%ld (expect 5, 5)\n", a.next, a.owner);
+
+    mcslock_t m;
+    mcs_node_t node;
+    mcslock_init(&m, "test mcs lock");
+    mcslock_acquire(&m, &node);
+    kprintf("\ttest mcs acquire: tail is node=%d, SIE=%d\n", m.tail == &node, _sie());
+    mcslock_release(&m, &node);
+    kprintf("\ttest mcs release: tail=%p, SIE=%d (expect 1)\n", m.tail, _sie());
+
+    // 读写锁: 多个读者可以同时持有读锁, 有读者时不能获得写锁
+    rwlock_t rw;
+    rwlock_init(&rw, "test rwlock");
+    rwlock_read_acquire(&rw);
+    Bool second = rwlock_try_read_acquire(&rw);
+    kprintf("\ttest rwlock two readers: second=%d (expect 1), write_owner=%ld\n", second, rw.write_owner);
+    rwlock_read_release(&rw);
+    rwlock_read_release(&rw);
+    rwlock_write_acquire(&rw);
+    kprintf("\ttest rwlock writer: try read=%d (expect 0)\n", rwlock_try_read_acquire(&rw));
+    rwlock_write_release(&rw);
+    kprintf("\ttest rwlock released: next=%ld, read_owner=%ld, write_owner=%ld (expect 3, 3, 3), SIE=%d\n", rw.next, rw.read_owner, rw.write_owner, _sie());
+
+    // 顺序锁写入时序号为奇数, 写入后读者读取到一致的数据
+    seqlock_t sl;
+    uint64_t data = 0, copy, seq;
+    seqlock_init(&sl, "test seqlock");
+    seqlock_write_begin(&sl);
+    kprintf("\ttest seqlock writing: sequence=%ld (expect 1)\n", sl.sequence);
+    data = 42;
+    seqlock_write_end(&sl);
+    do {
+        seq = seqlock_read_begin(&sl);
+        copy = data;
+    } while (seqlock_read_retry(&sl, seq));
+    kprintf("\ttest seqlock read: data=%ld, sequence=%ld (expect 42, 2)\n", copy, seq);
+
+    supervisor_interrupt_disable();
+    supervisor_interrupt_restore(before);
+    return 0;
+}
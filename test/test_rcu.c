@@ -0,0 +1,88 @@
+/**
+ * @file test_rcu.c
+ * @author Shihong Wang (jack4shihong@gmail.com)
+ * @brief `test_rcu.c`是`rcu`的测试文件
+ * @version 0.1
+ * @date 2023-06-21
+ *
+ * @copyright Copyright Shihong Wang (c) 2023 with GNU Public License V3.0
+ */
+
+#include "stdlib.h"
+#include "kernel/kstdio.h"
+#include "test/test_rcu.h"
+
+// 声明外部符号, 避免include
+extern void uart_puts(const char*);
+
+
+/**
+ * @brief `test_node_t`是测试使用的链表节点
+ */
+typedef struct __test_node_t {
+    int value;
+    list_elem_t elem;
+    rcu_head_t rcu;
+} test_node_t;
+
+// 宽限期结束后被调用的回调函数的次数
+static int callback_count = 0;
+
+static void _test_rcu_callback(rcu_head_t *head UNUSED){
+    callback_count++;
+}
+
+
+/**
+ * @brief `_test_rcu_collect`在读临界区内遍历链表, 将节点的值按顺序拼成一个十进制数
+ */
+static int _test_rcu_collect(list_t *list){
+    int digits = 0;
+    rcu_read_lock();
+    for (list_elem_t *e = list_first_rcu(list); e != &list->tail; e = list_next_rcu(e))
+        digits = digits * 10 + (member2struct(test_node_t, elem, e))->value;
+    rcu_read_unlock();
+    return digits;
+}
+
+
+int test_rcu(void){
+    uart_puts("=> "), uart_puts(__func__), uart_puts(": \n");
+
+    list_t list;
+    test_node_t a = {.value = 1}, b = {.value = 2}, c = {.value = 3}, d = {.value = 4};
+    list_init(&list);
+
+    // 插入: append加到末尾, push加到开头, insert加到指定节点之前
+    list_append_rcu(&a.elem, &list);
+    list_append_rcu(&b.elem, &list);
+    list_push_rcu(&c.elem, &list);
+    list_insert_rcu(&b.elem, &d.elem);
+    kprintf("\ttest insert order: %d (expect 3142)\n", _test_rcu_collect(&list));
+
+    // 删除: 被删除节点的next保持不变, 正在访问该节点的读者可以继续遍历
+    list_remove_rcu(&a.elem);
+    kprintf("\ttest remove order: %d (expect 342)\n", _test_rcu_collect(&list));
+    kprintf("\ttest removed node next: %d (expect 1)\n", a.elem.next == &d.elem);
+    list_remove_rcu(&c.elem);
+    list_remove_rcu(&b.elem);
+    kprintf("\ttest remove head and tail: %d (expect 4)\n", _test_rcu_collect(&list));
+
+    // 宽限期: 读临界区嵌套时只增加嵌套深度
+    rcu_read_lock();
+    rcu_read_lock();
+    kprintf("\ttest read lock nesting: %lu (expect 2)\n", rcu_cpus[cpu_id()].nesting);
+    rcu_read_unlock();
+    rcu_read_unlock();
+
+    // call_rcu的回调函数需要等待注册之后开始的完整的宽限期
+    callback_count = 0;
+    call_rcu(&a.rcu, _test_rcu_callback);
+    kprintf("\ttest call_rcu before grace period: %d (expect 0)\n", callback_count);
+    synchronize_rcu();
+    synchronize_rcu();
+    rcu_quiescent_state();
+    kprintf("\ttest call_rcu after grace period: %d (expect 1)\n", callback_count);
+
+    return 0;
+}
@@ -218,4 +218,9 @@ void _test_length(void){
         sprintf(sprintf_buffer, "Output a long long: %ld\n", (long)987654321123456789);
         uart_puts(sprintf_buffer);
     }
+    {
+        char sprintf_buffer[100] = {0};
+        sprintf(sprintf_buffer, "Output a max unsigned long: %lu, %lx, %lo\n", (unsigned long)-1, (unsigned long)-1, (unsigned long)-1);
+        uart_puts(sprintf_buffer);
+    }
 }
\ No newline at end of file